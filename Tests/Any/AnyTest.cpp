@@ -1,5 +1,34 @@
 #include <Io.hpp>
 #include <Any.hpp>
+#include <String.hpp>
+
+#include <cassert>
+
+// Counts the times any puts one on the heap, which it does
+// through the class' own operator new and delete
+template <hsd::usize Words>
+struct words
+{
+    static inline hsd::usize allocations = 0;
+    static inline hsd::usize frees = 0;
+
+    hsd::u64 values[Words];
+
+    static void* operator new(hsd::usize size)
+    {
+        allocations++;
+        return ::operator new(size);
+    }
+
+    static void operator delete(void* ptr)
+    {
+        frees++;
+        ::operator delete(ptr);
+    }
+};
+
+using small = words<2>;
+using big = words<8>;
 
 struct S
 {
@@ -63,4 +92,43 @@ int main()
     {
         hsd::println("Holds an int"_fmt);
     }
-}
\ No newline at end of file
+
+    // Small values never touch the heap
+    {
+        hsd::any value = small{{1, 2}};
+        hsd::any copy = value;
+        hsd::any moved = hsd::move(copy);
+        value = 2.5;
+
+        assert(!copy.has_value());
+        assert(moved.cast_if<small>()->values[1] == 2);
+        assert(value.cast_to<hsd::f64>().unwrap().get() == 2.5);
+        assert(!value.holds_type<hsd::f32>());
+        assert(small::allocations == 0);
+    }
+
+    // Big ones take one allocation per copy
+    {
+        hsd::any first = big{{1, 2, 3, 4, 5, 6, 7, 8}};
+        hsd::any second = first;
+        assert(big::allocations == 2);
+
+        hsd::any third = hsd::move(second);
+        assert(big::allocations == 2);
+        assert(third.cast_if<big>()->values[7] == 8);
+
+        hsd::any other = 7;
+        swap(other, third);
+        assert(other.holds_type<big>() && third.cast_to<hsd::i32>().unwrap().get() == 7);
+    }
+
+    assert(big::frees == big::allocations);
+
+    {
+        hsd::string payload = "payload";
+        hsd::any text = payload;
+        hsd::any copy = text;
+        text.reset();
+        assert(copy.cast_if<hsd::string>()->size() == payload.size());
+    }
+}
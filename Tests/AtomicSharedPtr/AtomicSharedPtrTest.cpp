@@ -0,0 +1,130 @@
+// Stress test, meant to be run under ThreadSanitizer and AddressSanitizer
+// as well: g++ -std=c++20 -fsanitize=thread AtomicSharedPtrTest.cpp -lpthread
+#include <cassert>
+#include <AtomicSharedPtr.hpp>
+#include <Thread.hpp>
+#include <Vector.hpp>
+#include <Io.hpp>
+
+static hsd::atomic_i64 g_live = 0;
+
+// Immutable once published, readers check that
+// they never see a half-written snapshot
+struct config
+{
+    hsd::u64 version;
+    hsd::u64 checksum;
+
+    config(hsd::u64 ver)
+        : version{ver}, checksum{ver * 31 + 7}
+    {
+        g_live.fetch_add(1, hsd::memory_order_relaxed);
+    }
+
+    ~config()
+    {
+        checksum = 0;
+        g_live.fetch_sub(1, hsd::memory_order_relaxed);
+    }
+};
+
+int main()
+{
+    using namespace hsd::format_literals;
+
+    {
+        hsd::epoch_domain domain;
+
+        {
+            hsd::atomic_shared_ptr<config> current{domain};
+            assert(current.load() == nullptr);
+
+            current.store(hsd::make_safe_shared<config>(1ull));
+            assert(current.load()->version == 1);
+
+            auto old = current.exchange(hsd::make_safe_shared<config>(2ull));
+            assert(old->version == 1 && current.load()->version == 2);
+
+            auto expected = old;
+            assert(!current.compare_exchange(expected, hsd::make_safe_shared<config>(3ull)));
+            assert(expected->version == 2);
+            assert(current.compare_exchange(expected, hsd::make_safe_shared<config>(3ull)));
+            assert(current.load()->version == 3);
+
+            // With nobody reading, a replaced value is gone right away
+            hsd::safe_weak_ptr<config> replaced = current.load();
+            current.store(hsd::make_safe_shared<config>(4ull));
+            assert(replaced.expired());
+
+            // A pinned reader keeps it alive until a later write
+            replaced = current.load();
+            {
+                auto guard = domain.pin();
+                current.store(hsd::make_safe_shared<config>(5ull));
+                assert(!replaced.expired());
+            }
+
+            current.exchange(hsd::make_safe_shared<config>(6ull));
+            assert(replaced.expired());
+        }
+
+        domain.collect();
+    }
+
+    assert(g_live.load() == 0);
+
+    // One writer publishing, readers loading as fast as they can
+    {
+        hsd::epoch_domain domain;
+
+        {
+            constexpr hsd::u64 versions = 20'000;
+            hsd::atomic_shared_ptr<config> current{
+                hsd::make_safe_shared<config>(0ull), domain
+            };
+
+            hsd::atomic_bool done = false;
+            hsd::vector<hsd::thread> readers;
+
+            for (hsd::i32 index = 0; index < 3; index++)
+            {
+                readers.emplace_back([&current, &done] {
+                    while (done.load(hsd::memory_order_acquire) == false)
+                    {
+                        auto snapshot = current.load();
+                        assert(snapshot->checksum == snapshot->version * 31 + 7);
+                    }
+                });
+            }
+
+            // A second writer bumping the version with compare_exchange
+            hsd::thread bumper{[&current] {
+                for (hsd::u64 step = 0; step < versions / 4; step++)
+                {
+                    auto expected = current.load();
+
+                    while (!current.compare_exchange(
+                        expected, hsd::make_safe_shared<config>(expected->version + 1)))
+                        ;
+                }
+            }};
+
+            for (hsd::u64 version = 1; version <= versions; version++)
+            {
+                auto latest = current.load();
+                current.store(hsd::make_safe_shared<config>(latest->version + 1));
+            }
+
+            bumper.join().unwrap();
+            done.store(true, hsd::memory_order_release);
+
+            for (auto& reader : readers)
+            {
+                reader.join().unwrap();
+            }
+        }
+    }
+
+    assert(g_live.load() == 0);
+    hsd::println("Atomic shared pointer tests passed"_fmt);
+}
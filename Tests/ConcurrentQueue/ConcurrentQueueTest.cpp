@@ -0,0 +1,294 @@
+#include <cassert>
+#include <ConcurrentQueue.hpp>
+#include <UniquePtr.hpp>
+#include <Thread.hpp>
+#include <ConditionVariable.hpp>
+#include <Time.hpp>
+#include <Io.hpp>
+
+// The hand-rolled queue the lock-free ones are meant to replace
+template <typename T>
+class locked_queue
+{
+private:
+    hsd::vector<T> _ring;
+    hsd::usize _head = 0;
+    hsd::usize _count = 0;
+    hsd::mutex _mutex;
+    hsd::condition_variable _not_empty;
+    hsd::condition_variable _not_full;
+
+public:
+    locked_queue(hsd::usize capacity)
+    {
+        _ring.resize(capacity);
+    }
+
+    void push(T value)
+    {
+        hsd::unique_lock<hsd::mutex> lock{_mutex};
+        _not_full.wait(lock, [this] { return _count < _ring.size(); });
+
+        _ring[(_head + _count) % _ring.size()] = hsd::move(value);
+        _count++;
+
+        lock.unlock().unwrap();
+        _not_empty.notify_one();
+    }
+
+    T pop()
+    {
+        hsd::unique_lock<hsd::mutex> lock{_mutex};
+        _not_empty.wait(lock, [this] { return _count != 0; });
+
+        T value = hsd::move(_ring[_head]);
+        _head = (_head + 1) % _ring.size();
+        _count--;
+
+        lock.unlock().unwrap();
+        _not_full.notify_one();
+        return value;
+    }
+};
+
+static constexpr hsd::u64 messages = 1'000'000;
+
+static void report(const char* name, hsd::precise_clock elapsed)
+{
+    using namespace hsd::format_literals;
+
+    auto nanoseconds = elapsed.to_nanoseconds();
+    hsd::println(
+        "{}: {} messages/sec, {}ns per message"_fmt, name,
+        static_cast<hsd::u64>(messages * 1e9 / static_cast<hsd::f64>(nanoseconds)),
+        nanoseconds / messages
+    );
+}
+
+template <typename Producer, typename Consumer>
+static void run_pair(const char* name, Producer produce, Consumer consume)
+{
+    hsd::precise_clock clock;
+    hsd::u64 sum = 0;
+
+    hsd::thread producer{produce};
+    hsd::thread consumer{[&sum, &consume] { sum = consume(); }};
+
+    producer.join().unwrap();
+    consumer.join().unwrap();
+
+    report(name, clock.restart());
+    assert(sum == messages * (messages - 1) / 2);
+}
+
+int main()
+{
+    using namespace hsd::format_literals;
+
+    // Bounded, first in first out, rejects when full
+    {
+        hsd::mpmc_queue<hsd::i32> queue{3};
+        assert(queue.capacity() == 4);
+
+        for (hsd::i32 index = 0; index < 4; index++)
+        {
+            assert(queue.try_push(index) == true);
+        }
+
+        assert(queue.try_push(4) == false);
+        assert(queue.size() == 4);
+
+        for (hsd::i32 index = 0; index < 4; index++)
+        {
+            assert(queue.try_pop().unwrap() == index);
+        }
+
+        assert(queue.try_pop().is_ok() == false);
+        assert(queue.empty());
+    }
+
+    // Move-only values, leftovers are destroyed with the queue
+    {
+        hsd::mpmc_queue<hsd::unique_ptr<hsd::i32>> queue{8};
+        queue.push(hsd::make_unique<hsd::i32>(7));
+        queue.push(hsd::make_unique<hsd::i32>(8));
+        assert(*queue.pop() == 7);
+    }
+
+    // Many producers and consumers through a tiny queue, so
+    // that both sides keep parking on the futex
+    {
+        constexpr hsd::u64 per_producer = 100'000;
+        hsd::mpmc_queue<hsd::u64> queue{16};
+        hsd::atomic_u64 sum = 0;
+
+        auto produce = [&queue](hsd::u64 first) {
+            for (hsd::u64 value = first; value < first + per_producer; value++)
+            {
+                queue.push(value);
+            }
+        };
+
+        auto consume = [&queue, &sum] {
+            hsd::u64 local = 0;
+
+            for (hsd::u64 count = 0; count < per_producer; count++)
+            {
+                local += queue.pop();
+            }
+
+            sum.fetch_add(local);
+        };
+
+        hsd::thread threads[] = {
+            hsd::thread{[&] { produce(0); }},
+            hsd::thread{[&] { produce(per_producer); }},
+            hsd::thread{[&] { produce(per_producer * 2); }},
+            hsd::thread{consume}, hsd::thread{consume}, hsd::thread{consume}
+        };
+
+        for (auto& thread : threads)
+            thread.join().unwrap();
+
+        constexpr hsd::u64 total = per_producer * 3;
+        assert(sum.load() == total * (total - 1) / 2);
+        assert(queue.empty());
+    }
+
+    // One to one, values arrive in order, batches wrap around the ring
+    {
+        hsd::spsc_queue<hsd::i32> queue{4};
+        hsd::i32 input[] = {1, 2, 3, 4, 5, 6};
+        hsd::i32 output[6] = {};
+
+        assert(queue.try_push(0) == true);
+        assert(queue.try_pop().unwrap() == 0);
+
+        assert(queue.push_n(hsd::span<hsd::i32*>{input, input + 6, 6}) == 4);
+        assert(queue.try_push(5) == false);
+        assert(queue.pop_n(hsd::span<hsd::i32*>{output, output + 3, 3}) == 3);
+        assert(queue.push_n(hsd::span<hsd::i32*>{input + 4, input + 6, 2}) == 2);
+        assert(queue.pop_n(hsd::span<hsd::i32*>{output + 3, output + 6, 3}) == 3);
+
+        for (hsd::i32 index = 0; index < 6; index++)
+        {
+            assert(output[index] == index + 1);
+        }
+
+        assert(queue.empty());
+    }
+
+    // Throughput of a single producer and consumer pair
+    {
+        hsd::spsc_queue<hsd::u64> spsc{1024};
+        hsd::mpmc_queue<hsd::u64> mpmc{1024};
+        locked_queue<hsd::u64> locked{1024};
+
+        run_pair("spsc_queue", [&spsc] {
+            for (hsd::u64 value = 0; value < messages; value++)
+            {
+                while (spsc.try_push(value) == false)
+                    hsd::this_thread::yield();
+            }
+        }, [&spsc] {
+            hsd::u64 sum = 0;
+
+            for (hsd::u64 count = 0; count < messages; count++)
+            {
+                auto value = spsc.try_pop();
+
+                while (value.is_ok() == false)
+                {
+                    hsd::this_thread::yield();
+                    value = spsc.try_pop();
+                }
+
+                sum += value.unwrap();
+            }
+
+            return sum;
+        });
+
+        run_pair("spsc_queue, batches of 64", [&spsc] {
+            hsd::u64 batch[64];
+
+            for (hsd::u64 value = 0; value < messages;)
+            {
+                hsd::usize size = 0;
+
+                for (; size < 64 && value + size < messages; size++)
+                {
+                    batch[size] = value + size;
+                }
+
+                hsd::usize sent = 0;
+
+                while (sent < size)
+                {
+                    sent += spsc.push_n(
+                        hsd::span<hsd::u64*>{batch + sent, batch + size, size - sent}
+                    );
+
+                    if (sent < size)
+                        hsd::this_thread::yield();
+                }
+
+                value += size;
+            }
+        }, [&spsc] {
+            hsd::u64 sum = 0;
+            hsd::u64 batch[64];
+
+            for (hsd::u64 count = 0; count < messages;)
+            {
+                hsd::usize size = spsc.pop_n(hsd::span<hsd::u64*>{batch, batch + 64, 64});
+
+                if (size == 0)
+                    hsd::this_thread::yield();
+
+                for (hsd::usize index = 0; index < size; index++)
+                {
+                    sum += batch[index];
+                }
+
+                count += size;
+            }
+
+            return sum;
+        });
+
+        run_pair("mpmc_queue", [&mpmc] {
+            for (hsd::u64 value = 0; value < messages; value++)
+            {
+                mpmc.push(value);
+            }
+        }, [&mpmc] {
+            hsd::u64 sum = 0;
+
+            for (hsd::u64 count = 0; count < messages; count++)
+            {
+                sum += mpmc.pop();
+            }
+
+            return sum;
+        });
+
+        run_pair("mutex and condition_variable", [&locked] {
+            for (hsd::u64 value = 0; value < messages; value++)
+            {
+                locked.push(value);
+            }
+        }, [&locked] {
+            hsd::u64 sum = 0;
+
+            for (hsd::u64 count = 0; count < messages; count++)
+            {
+                sum += locked.pop();
+            }
+
+            return sum;
+        });
+    }
+
+    hsd::println("Concurrent queue tests passed"_fmt);
+}
@@ -0,0 +1,157 @@
+#include <cassert>
+#include <ConcurrentUnorderedMap.hpp>
+#include <UnorderedMap.hpp>
+#include <String.hpp>
+#include <Thread.hpp>
+#include <Time.hpp>
+#include <Io.hpp>
+
+static constexpr hsd::u64 keys = 4096;
+static constexpr hsd::u64 lookups = 200'000;
+
+// Read-mostly traffic, one write every 16 lookups
+template <typename Lookup, typename Store>
+static hsd::u64 cache_traffic(Lookup lookup, Store store)
+{
+    hsd::precise_clock clock;
+
+    auto worker = [&](hsd::u64 seed) {
+        for (hsd::u64 index = 0; index < lookups; index++)
+        {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            hsd::u64 key = (seed >> 33) % keys;
+
+            if (index % 16 == 0)
+            {
+                store(key);
+            }
+            else
+            {
+                lookup(key);
+            }
+        }
+    };
+
+    hsd::thread threads[] = {
+        hsd::thread{[&] { worker(1); }}, hsd::thread{[&] { worker(2); }},
+        hsd::thread{[&] { worker(3); }}, hsd::thread{[&] { worker(4); }}
+    };
+
+    for (auto& thread : threads)
+        thread.join().unwrap();
+
+    return clock.restart().to_nanoseconds() / (lookups * 4);
+}
+
+int main()
+{
+    using namespace hsd::format_literals;
+
+    // Same basic operations as unordered_map, under a lock per stripe
+    {
+        hsd::concurrent_unordered_map<hsd::string, hsd::i32> map{8};
+        assert(map.stripe_count() == 8);
+
+        assert(map.insert_or_assign(hsd::string{"one"}, 1) == true);
+        assert(map.insert_or_assign(hsd::string{"one"}, 11) == false);
+        assert(map.insert(hsd::string{"two"}, 2) == true);
+        assert(map.insert(hsd::string{"two"}, 22) == false);
+
+        assert(map.find("one").unwrap() == 11);
+        assert(map.find("two").unwrap() == 2);
+        assert(map.find("three").is_ok() == false);
+
+        assert(map.update("two", [](hsd::i32& value) { value *= 10; }) == true);
+        assert(*map.find_guarded("two").unwrap() == 20);
+
+        assert(map.erase("one") == true);
+        assert(map.erase("one") == false);
+        assert(map.contains("one") == false);
+        assert(map.size() == 1);
+
+        // Enough to rehash every stripe a few times
+        for (hsd::i32 index = 0; index < 1000; index++)
+        {
+            map.insert_or_assign(hsd::to_string(index), index);
+        }
+
+        hsd::i64 total = 0;
+        map.for_each([&total](const hsd::string&, const hsd::i32& value) {
+            total += value;
+        });
+
+        assert(map.size() == 1001);
+        assert(total == 999 * 1000 / 2 + 20);
+
+        map.clear();
+        assert(map.size() == 0);
+    }
+
+    // Concurrent writers on disjoint keys, readers alongside
+    {
+        hsd::concurrent_unordered_map<hsd::u64, hsd::u64> map;
+
+        auto writer = [&map](hsd::u64 first) {
+            for (hsd::u64 key = first; key < first + 10000; key++)
+            {
+                map.insert_or_assign(key, key * 2);
+            }
+
+            for (hsd::u64 key = first; key < first + 10000; key += 2)
+            {
+                map.erase(key);
+            }
+        };
+
+        auto reader = [&map] {
+            for (hsd::u64 key = 0; key < 40000; key++)
+            {
+                if (auto value = map.find(key); value.is_ok())
+                {
+                    assert(value.unwrap() == key * 2);
+                }
+            }
+        };
+
+        hsd::thread threads[] = {
+            hsd::thread{[&] { writer(0); }}, hsd::thread{[&] { writer(10000); }},
+            hsd::thread{[&] { writer(20000); }}, hsd::thread{[&] { writer(30000); }},
+            hsd::thread{reader}, hsd::thread{reader}
+        };
+
+        for (auto& thread : threads)
+            thread.join().unwrap();
+
+        assert(map.size() == 20000);
+        assert(map.contains(1) && !map.contains(2));
+    }
+
+    // Against the whole unordered_map behind a single mutex
+    {
+        hsd::concurrent_unordered_map<hsd::u64, hsd::u64> striped;
+        hsd::unordered_map<hsd::u64, hsd::u64> plain;
+        hsd::mutex plain_mutex;
+
+        for (hsd::u64 key = 0; key < keys; key++)
+        {
+            striped.insert_or_assign(key, key);
+            plain.emplace(key, key);
+        }
+
+        hsd::println("concurrent_unordered_map: {}ns per operation"_fmt, cache_traffic(
+            [&](hsd::u64 key) { assert(striped.find(key).unwrap() == key); },
+            [&](hsd::u64 key) { striped.insert_or_assign(key, key); }
+        ));
+
+        hsd::println("unordered_map with a mutex: {}ns per operation"_fmt, cache_traffic(
+            [&](hsd::u64 key) {
+                hsd::unique_lock lock{plain_mutex};
+                assert(plain.at(key).unwrap().get() == key);
+            },
+            [&](hsd::u64 key) {
+                hsd::unique_lock lock{plain_mutex};
+                plain[key] = key;
+            }
+        ));
+    }
+}
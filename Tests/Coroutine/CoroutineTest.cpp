@@ -0,0 +1,91 @@
+#include <cassert>
+#include <Coroutine.hpp>
+#include <Io.hpp>
+
+static hsd::task<hsd::i32> parse_digit(char ch)
+{
+    if (ch < '0' || ch > '9')
+    {
+        co_return hsd::runtime_error{"Not a digit"};
+    }
+
+    co_return ch - '0';
+}
+
+static hsd::task<hsd::i32> parse_number(const char* str)
+{
+    hsd::i32 value = 0;
+
+    for (; *str != '\0'; str++)
+    {
+        auto digit = co_await parse_digit(*str);
+
+        if (digit.is_ok() == false)
+        {
+            co_return digit.unwrap_err();
+        }
+
+        value = value * 10 + digit.unwrap();
+    }
+
+    co_return value;
+}
+
+// Hops onto the pool, then waits on work submitted from there
+static hsd::task<hsd::i32> on_pool(hsd::thread_pool& pool)
+{
+    co_await hsd::schedule(pool);
+    assert(pool.current_worker().is_ok() == true);
+
+    auto squared = co_await pool.submit([] { return 12 * 12; });
+    co_return squared.unwrap() + 1;
+}
+
+static hsd::task<void> may_fail(bool fail)
+{
+    if (fail == true)
+    {
+        co_return hsd::runtime_error{"Requested failure"};
+    }
+
+    co_return {};
+}
+
+int main()
+{
+    using namespace hsd::format_literals;
+
+    auto number = hsd::sync_wait(parse_number("12345"));
+    assert(number.unwrap() == 12345);
+
+    auto broken = hsd::sync_wait(parse_number("12a45"));
+    assert(broken.is_ok() == false);
+
+    hsd::thread_pool pool{4};
+    assert(hsd::sync_wait(on_pool(pool)).unwrap() == 145);
+
+    assert(hsd::sync_wait(may_fail(false)).is_ok() == true);
+    assert(hsd::sync_wait(may_fail(true)).is_ok() == false);
+
+    // Awaiting a future that is already done doesn't suspend
+    auto ready = hsd::async(hsd::launch::deferred, [] { return 3; });
+    ready.wait();
+
+    auto ready_task = [](hsd::future<hsd::i32> fut) -> hsd::task<hsd::i32> {
+        auto value = co_await hsd::move(fut);
+        co_return value.unwrap() * 2;
+    };
+
+    assert(hsd::sync_wait(ready_task(hsd::move(ready))).unwrap() == 6);
+
+    // Lots of short lived frames, these come out of the frame cache
+    hsd::i64 total = 0;
+
+    for (hsd::i32 index = 0; index < 10000; index++)
+    {
+        total += hsd::sync_wait(parse_digit('0' + index % 10)).unwrap();
+    }
+
+    assert(total == 45000);
+    hsd::println("Coroutine tests passed"_fmt);
+}
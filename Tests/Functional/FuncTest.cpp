@@ -1,5 +1,7 @@
 #include <stdio.h>
+#include <cassert>
 #include <Functional.hpp>
+#include <Time.hpp>
 
 static int func(int a)
 {
@@ -28,6 +30,71 @@ struct counter
     }
 };
 
+// Not inlined, so that the calls really go through the wrappers
+[[gnu::noipa]] static long sum_with(const hsd::function<long(long)>& func, long count)
+{
+    long sum = 0;
+
+    for (long i = 0; i < count; i++)
+        sum += func(i).unwrap();
+
+    return sum;
+}
+
+[[gnu::noipa]] static long sum_with(hsd::function_ref<long(long)> func, long count)
+{
+    long sum = 0;
+
+    for (long i = 0; i < count; i++)
+        sum += func(i);
+
+    return sum;
+}
+
+[[gnu::noipa]] static long sum_with(long (*func)(long), long count)
+{
+    long sum = 0;
+
+    for (long i = 0; i < count; i++)
+        sum += func(i);
+
+    return sum;
+}
+
+static long twice(long value)
+{
+    return value * 2;
+}
+
+// Adds its captured values to the argument. function puts it on
+// the heap with new, so its own operator new counts the times
+template <typename T, hsd::usize Count>
+struct sum_of
+{
+    static inline hsd::usize allocations = 0;
+
+    T values[Count];
+
+    T operator()(T extra = 0) const
+    {
+        for (auto value : values)
+            extra += value;
+
+        return extra;
+    }
+
+    static void* operator new(hsd::usize size)
+    {
+        allocations++;
+        return ::operator new(size);
+    }
+
+    static void operator delete(void* ptr)
+    {
+        ::operator delete(ptr);
+    }
+};
+
 int main()
 {
     counter b = 5;
@@ -47,4 +114,109 @@ int main()
     printf("%d\n", f3().unwrap());
     hsd::function my_counter = counter(1);
     my_counter().unwrap();
-}
\ No newline at end of file
+
+    // Small callables stay inline, building, copying
+    // and calling them never goes to the heap
+    {
+        using small_type = sum_of<int, 2>;
+
+        hsd::function<int(int)> small = small_type{{1, 2}};
+        auto copy = small;
+        hsd::function<int(int)> moved = hsd::move(copy);
+
+        assert(small(3).unwrap() == 6);
+        assert(moved(4).unwrap() == 7);
+        assert(!copy);
+        assert(small_type::allocations == 0);
+    }
+
+    // Bigger ones go to the heap, once per copy
+    {
+        using big_type = sum_of<long, 4>;
+
+        hsd::function<long()> big = big_type{{1, 2, 3, 4}};
+        auto copy = big;
+
+        assert(big().unwrap() == 10 && copy().unwrap() == 10);
+        assert(big_type::allocations == 2);
+
+        hsd::function<long()> empty;
+        auto empty_copy = empty;
+        assert(!empty_copy && empty_copy().is_ok() == false);
+    }
+
+    // Move-only captures need unique_function
+    {
+        auto owned = hsd::make_unique<int>(42);
+
+        hsd::unique_function<int()> func = [ptr = hsd::move(owned)] {
+            return *ptr;
+        };
+
+        auto moved = hsd::move(func);
+        assert(!func && moved().unwrap() == 42);
+
+        moved = [] { return 7; };
+        assert(moved().unwrap() == 7);
+    }
+
+    {
+        constexpr hsd::usize iterations = 1'000'000;
+        using callback_type = sum_of<int, 2>;
+
+        hsd::precise_clock clock;
+        hsd::usize before = callback_type::allocations;
+        int sum = 0;
+
+        for (hsd::usize i = 0; i < iterations; i++)
+        {
+            hsd::function<int(int)> callback = callback_type{{sum & 1, static_cast<int>(i & 1)}};
+            sum += callback(1).unwrap();
+        }
+
+        printf(
+            "create and call: %lluns per function, %zu allocations\n",
+            static_cast<unsigned long long>(clock.restart().to_nanoseconds() / iterations),
+            callback_type::allocations - before
+        );
+
+        assert(sum > 0);
+    }
+
+    {
+        sum_of<long, 1> add{{3}};
+
+        hsd::function_ref<long(long)> ref = add;
+        hsd::function_ref<long(long)> ptr_ref = twice;
+        hsd::function_ref<int()> counting = my_counter;
+
+        assert(ref(1) == 4 && ptr_ref(5) == 10);
+        int first = counting();
+        assert(counting() == first + 1);
+        assert(sizeof(ref) == 2 * sizeof(void*));
+        assert((sum_of<long, 1>::allocations == 0));
+    }
+
+    {
+        constexpr long iterations = 10'000'000;
+        long offset = 3;
+        auto add = [&offset](long value) { return value + offset; };
+        hsd::function<long(long)> owning = add;
+
+        auto bench = [&](const char* name, auto&& run) {
+            hsd::precise_clock clock;
+            long sum = run();
+
+            printf(
+                "%s: %.2fns per call (%ld)\n", name,
+                static_cast<double>(clock.restart().to_nanoseconds()) / iterations, sum
+            );
+        };
+
+        bench("hsd::function", [&] { return sum_with(owning, iterations); });
+        bench("hsd::function_ref", [&] {
+            return sum_with(hsd::function_ref<long(long)>{add}, iterations);
+        });
+        bench("function pointer", [&] { return sum_with(&twice, iterations); });
+    }
+}
@@ -0,0 +1,131 @@
+#include <cassert>
+#include <Async.hpp>
+#include <Io.hpp>
+
+static hsd::result<hsd::i32, hsd::runtime_error> checked_half(hsd::i32 value)
+{
+    if (value % 2 != 0)
+    {
+        return hsd::runtime_error{"Odd value"};
+    }
+
+    return value / 2;
+}
+
+// An error type that has no message to give
+struct error_code
+{
+    hsd::i32 code = 0;
+};
+
+int main()
+{
+    using namespace hsd::format_literals;
+
+    // Every launch policy ends up in the same kind of future
+    {
+        auto pooled = hsd::async([](hsd::i32 a) { return a * 2; }, 21);
+        auto threaded = hsd::async(hsd::launch::async, [] { return 2; });
+
+        bool ran = false;
+        auto deferred = hsd::async(hsd::launch::deferred, [&ran] { ran = true; });
+
+        assert(ran == false);
+        deferred.wait();
+        assert(ran == true);
+
+        pooled.wait();
+        threaded.wait();
+        assert(pooled.get().unwrap() == 42);
+        assert(threaded.get().unwrap() == 2);
+    }
+
+    // Continuations get the value and skip on errors
+    {
+        auto chained = hsd::async(checked_half, 8)
+            .then([](hsd::i32 value) { return value + 1; })
+            .then([](hsd::i32 value) { return checked_half(value * 2); });
+
+        chained.wait();
+        assert(chained.get().unwrap() == 5);
+
+        hsd::atomic_bool skipped = true;
+        auto failed = hsd::async(checked_half, 7)
+            .then([&skipped](hsd::i32 value) { skipped = false; return value; });
+
+        failed.wait();
+        assert(skipped.load() == true);
+        assert(failed.get().is_ok() == false);
+
+        // Taking the whole result handles the error instead
+        auto recovered = hsd::async(checked_half, 7)
+            .then([](hsd::result<hsd::i32, hsd::runtime_error>& res) {
+                return res.is_ok() ? res.unwrap() : -1;
+            });
+
+        recovered.wait();
+        assert(recovered.get().unwrap() == -1);
+    }
+
+    // Fan out, then join on all of them or the first one
+    {
+        hsd::vector<hsd::future<hsd::i32>> futures;
+
+        for (hsd::i32 index = 0; index < 32; index++)
+        {
+            futures.emplace_back(hsd::async(checked_half, index * 2));
+        }
+
+        auto all = hsd::when_all(hsd::move(futures));
+        all.wait();
+
+        auto values = all.get().unwrap();
+        assert(values.size() == 32);
+
+        for (hsd::i32 index = 0; index < 32; index++)
+        {
+            assert(values[static_cast<hsd::usize>(index)] == index);
+        }
+
+        hsd::vector<hsd::future<hsd::i32>> failing;
+        failing.emplace_back(hsd::async(checked_half, 2));
+        failing.emplace_back(hsd::async(checked_half, 3));
+
+        auto all_failed = hsd::when_all(hsd::move(failing));
+        all_failed.wait();
+        assert(all_failed.get().is_ok() == false);
+
+        hsd::promise<hsd::i32> never;
+        hsd::vector<hsd::future<hsd::i32>> racing;
+        racing.emplace_back(never.get_future());
+        racing.emplace_back(hsd::async([] { return 17; }));
+
+        auto any = hsd::when_any(hsd::move(racing));
+        any.wait();
+
+        auto first = any.get().unwrap();
+        assert(first.first == 1 && first.second == 17);
+        never.set_value(0);
+
+        // Nothing to wait on fails right away instead of hanging
+        auto no_values = hsd::when_any(hsd::vector<hsd::future<hsd::i32>>{});
+        assert(no_values.get().is_ok() == false);
+
+        auto no_options = hsd::when_any(hsd::vector<hsd::future<hsd::i32, void>>{});
+        assert(no_options.get().is_ok() == false);
+
+        // Without one, it fails with a default error instead
+        hsd::promise<hsd::i32, error_code> coded{error_code{1}};
+        hsd::vector<hsd::future<hsd::i32, error_code>> coded_futures;
+        coded_futures.emplace_back(coded.get_future());
+
+        auto coded_any = hsd::when_any(hsd::move(coded_futures));
+        coded.set_value(9);
+        assert(coded_any.get().unwrap().second == 9);
+
+        auto no_codes = hsd::when_any(hsd::vector<hsd::future<hsd::i32, error_code>>{});
+        assert(no_codes.get().unwrap_err().code == 0);
+    }
+
+    hsd::println("Async tests passed"_fmt);
+}
@@ -0,0 +1,99 @@
+#include <cassert>
+#include <IntrusivePtr.hpp>
+#include <Thread.hpp>
+#include <Vector.hpp>
+#include <Io.hpp>
+
+static hsd::i32 g_alive = 0;
+
+struct node : hsd::unsafe_ref_counted<node>
+{
+    hsd::i32 value;
+    hsd::intrusive_ptr<node> next;
+
+    node(hsd::i32 val)
+        : value{val}
+    {
+        g_alive++;
+    }
+
+    virtual ~node()
+    {
+        g_alive--;
+    }
+
+    // The count lives in the object, so this is enough
+    // to hand out another owner from a raw pointer
+    hsd::intrusive_ptr<node> self()
+    {
+        return hsd::intrusive_ptr<node>{this};
+    }
+};
+
+struct tagged_node : node
+{
+    tagged_node(hsd::i32 val)
+        : node{val}
+    {}
+};
+
+static hsd::atomic_i32 g_hits = 0;
+
+struct shared_counter : hsd::safe_ref_counted<shared_counter>
+{};
+
+int main()
+{
+    using namespace hsd::format_literals;
+
+    {
+        auto first = hsd::make_intrusive<node>(1);
+        assert(first->get_count() == 1);
+
+        auto again = first->self();
+        assert(again == first);
+        assert(first->get_count() == 2);
+
+        first->next = hsd::make_intrusive<node>(2);
+        first->next->next = hsd::make_intrusive<tagged_node>(3);
+        assert(g_alive == 3);
+
+        hsd::intrusive_ptr<node> base = hsd::make_intrusive<tagged_node>(4);
+        base = first->next;
+        assert(base->value == 2 && g_alive == 3);
+
+        node* raw = again.detach();
+        assert(raw->get_count() == 2);
+        hsd::intrusive_ptr<node> adopted{raw, false};
+        assert(adopted->get_count() == 2);
+    }
+
+    assert(g_alive == 0);
+
+    {
+        auto counter = hsd::make_intrusive<shared_counter>();
+        hsd::vector<hsd::thread> threads;
+
+        for (hsd::i32 index = 0; index < 4; index++)
+        {
+            threads.emplace_back([counter] {
+                for (hsd::i32 step = 0; step < 10'000; step++)
+                {
+                    hsd::intrusive_ptr<shared_counter> copy = counter;
+                    assert(copy->get_count() >= 2);
+                    g_hits.fetch_add(1, hsd::memory_order_relaxed);
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join().unwrap();
+        }
+
+        assert(g_hits.load() == 40'000);
+        assert(counter->get_count() == 1);
+    }
+
+    hsd::println("Intrusive pointer tests passed"_fmt);
+}
@@ -0,0 +1,85 @@
+#include <cassert>
+#include <string.h>
+
+#include <Io.hpp>
+#include <String.hpp>
+
+using namespace hsd::format_literals;
+
+int main()
+{
+    // Fully buffered, nothing reaches the file until it fills up
+    auto file = hsd::io::load_file(
+        "Tests/Io/buffered.txt", hsd::io_options::write
+    ).unwrap();
+
+    assert(file.get_buffering() == hsd::io_buffering::full);
+
+    for (hsd::i32 index = 0; index < 1000; index++)
+    {
+        file.print<"line number {}\n">(index);
+    }
+
+    // Longer than the whole buffer, it has to grow instead of truncating
+    hsd::string long_line{hsd::io::default_buffer_size * 2};
+    
+    for (hsd::usize index = 0; index < hsd::io::default_buffer_size * 2; index++)
+    {
+        long_line.push_back('a' + static_cast<char>(index % 26));
+    }
+
+    file.print<"{}\n">(long_line);
+    file.flush().unwrap();
+
+    auto check = hsd::io::load_file(
+        "Tests/Io/buffered.txt", hsd::io_options::read
+    ).unwrap();
+
+    check.get_stream().reserve(hsd::io::default_buffer_size * 8);
+
+    check.read_chunk().unwrap();
+    assert(check.is_eof() == true);
+
+    // "line number " and a new line for every number, plus their digits
+    constexpr hsd::usize lines_size = 1000 * 13 + 10 * 1 + 90 * 2 + 900 * 3;
+    constexpr hsd::usize expected_size = lines_size + hsd::io::default_buffer_size * 2 + 1;
+    static_assert(expected_size == 24083);
+
+    const char* data = check.get_stream().data();
+    assert(check.get_stream().size() == expected_size);
+    assert(strncmp(data, "line number 0\nline number 1\n", 28) == 0);
+    assert(strncmp(data + lines_size - 32, "line number 998\nline number 999\n", 32) == 0);
+
+    for (hsd::usize index = 0; index < hsd::io::default_buffer_size * 2; index++)
+    {
+        assert(data[lines_size + index] == 'a' + static_cast<char>(index % 26));
+    }
+
+    assert(data[expected_size - 1] == '\n');
+    hsd::println("Wrote {} bytes"_fmt, expected_size);
+
+    // Reading from a tied stream writes out the pending prompt first
+    auto prompt = hsd::io::load_file(
+        "Tests/Io/buffered.txt", hsd::io_options::write
+    ).unwrap();
+
+    prompt.print<"Name? ">();
+
+    auto answer = hsd::io::load_file(
+        "Tests/Io/buffered.txt", hsd::io_options::read
+    ).unwrap();
+
+    answer.get_stream().reserve(64);
+    answer.tie(&prompt).read_chunk().unwrap();
+    assert(strcmp(answer.get_stream().data(), "Name? ") == 0);
+    assert(hsd::io::cin().get_tied() == &hsd::io::cout());
+
+    // The standard output is line buffered on a terminal
+    hsd::io::cout().set_buffering(hsd::io_buffering::full);
+    hsd::print("Flushed "_fmt);
+    hsd::print("at once\n"_fmt);
+    hsd::flush();
+
+    hsd::io::cout().set_buffering(hsd::io_buffering::none);
+    hsd::println("Unbuffered {} {}"_fmt, 12, -3.4);
+}
@@ -0,0 +1,75 @@
+#include <cassert>
+#include <stdio.h>
+#include <string.h>
+
+#include <Io.hpp>
+#include <Random.hpp>
+#include <String.hpp>
+
+using namespace hsd::format_literals;
+
+template <hsd::basic_string_literal fmt, typename T>
+static void check(const char* spec, T value)
+{
+    char expected[512], actual[512];
+    snprintf(expected, sizeof(expected), spec, value);
+    hsd::usize len = hsd::format_to<fmt>(actual, sizeof(actual), value);
+
+    if (strcmp(expected, actual) != 0 || len != strlen(expected))
+    {
+        hsd::println_err("Mismatch for {}: expected {}, got {}"_fmt, spec, expected, actual);
+        assert(false);
+    }
+}
+
+int main()
+{
+    check<"{}">("%d", 0);
+    check<"{}">("%d", -2147483647 - 1);
+    check<"{}">("%lld", 9223372036854775807ll);
+    check<"{}">("%llu", 18446744073709551615ull);
+    check<"{hex}">("0x%hhx", static_cast<hsd::i8>(-1));
+    check<"{hex}">("0x%x", 0u);
+    check<"{hex}">("0x%llx", 0xdeadbeefcafeull);
+    check<"{}">("%c", 'x');
+    check<"{}">("%s", "text with % and {{ }}");
+
+    const hsd::f64 doubles[] = {
+        0.0, -0.0, 1.0, 0.5, 2.5, 0.0078125, 0.0000005, 0.0000015, 123.2, 
+        -3.4, 1e-300, 5e-324, 999999.9999995, 9.9999995, 1e18, 9.2e18, 1e300,
+        1.0 / 0.0, -1.0 / 0.0, 0.0 / 0.0
+    };
+
+    for (auto value : doubles)
+    {
+        check<"{}">("%lf", value);
+        check<"{hex}">("%la", value);
+        check<"{exp}">("%le", value);
+    }
+
+    hsd::mt19937_64 engine;
+
+    for (hsd::usize index = 0; index < 100000; index++)
+    {
+        auto bits = engine.generate();
+        auto value = hsd::bit_cast<hsd::f64>(bits);
+        
+        check<"{hex}">("%la", value);
+
+        // Keep the exponent in a range where %lf output stays short
+        bits = (bits & ~(0x7ffull << 52)) | ((1023ull - 40 + bits % 100) << 52);
+        check<"{}">("%lf", hsd::bit_cast<hsd::f64>(bits));
+        check<"{}">("%f", static_cast<hsd::f32>(hsd::bit_cast<hsd::f64>(bits)));
+    }
+
+    check<"{}">("%Lf", static_cast<hsd::f128>(1.25));
+
+    // Strings and views are written directly, styles are kept
+    hsd::string str = "string";
+    hsd::sstream stream;
+    stream.write_data<"{} {} {bold,fg=9}">(str, static_cast<hsd::string_view>(str), 42);
+    assert(strcmp(stream.c_str(), "string string \x1b[;1;38;5;9m42\x1b[0m") == 0);
+    assert(stream.size() == strlen(stream.c_str()));
+    
+    hsd::println("All formats match the C library"_fmt);
+}
@@ -0,0 +1,77 @@
+#include <cassert>
+#include <Io.hpp>
+#include <String.hpp>
+
+using namespace hsd::format_literals;
+
+int main()
+{
+    {
+        auto file = hsd::io::load_file(
+            "Tests/Io/mapped.txt", hsd::io_options::write
+        ).unwrap();
+
+        for (hsd::i32 index = 0; index < 1000; index++)
+        {
+            file.print<"{} {}\n">(index, index * 0.5);
+        }
+
+        file.print<"hello world\n">();
+    }
+
+    auto mapping = hsd::io::map_file("Tests/Io/mapped.txt").unwrap();
+    assert(mapping.is_mapped() == true);
+    assert(mapping.view().size() == mapping.size());
+
+    for (hsd::i32 index = 0; index < 1000; index++)
+    {
+        assert(mapping.read_value<hsd::i32>() == index);
+        assert(mapping.read_value<hsd::f64>() == index * 0.5);
+    }
+
+    // Strings are handed out as views into the mapping itself
+    auto word = mapping.read_value<hsd::string_view>();
+    assert(word.data() >= mapping.data());
+    assert(word.data() < mapping.data() + mapping.size());
+    assert(hsd::cstring::compare(word.data(), "hello", word.size()) == 0);
+
+    auto other = mapping.read_value<hsd::string>();
+    assert(hsd::cstring::compare(other.c_str(), "world") == 0);
+    assert(mapping.is_eof() == true);
+
+    mapping.advise(hsd::mapped_access::random).unwrap();
+    mapping.seek(0);
+    assert(mapping.read_value<hsd::i32>() == 0);
+
+    hsd::usize lines = 0;
+
+    for (auto ch : mapping.to_span())
+    {
+        lines += (ch == '\n');
+    }
+
+    assert(lines == 1001);
+
+    #if defined(HSD_PLATFORM_POSIX)
+    // Pipes can't be mapped, they get drained into a buffer instead
+    hsd::i32 fds[2];
+    assert(pipe(fds) == 0);
+    assert(write(fds[1], "12 -7 piped", 11) == 11);
+    close(fds[1]);
+
+    char path[32];
+    hsd::format_to<"/dev/fd/{}">(path, sizeof(path), fds[0]);
+
+    auto piped = hsd::mapped_file::open(path).unwrap();
+    close(fds[0]);
+
+    assert(piped.is_mapped() == false);
+    assert(piped.size() == 11);
+    assert(piped.read_value<hsd::u32>() == 12);
+    assert(piped.read_value<hsd::i64>() == -7);
+    assert(piped.read_value<hsd::string_view>().size() == 5);
+    assert(piped.is_eof() == true);
+    #endif
+
+    hsd::println("mapped {} bytes"_fmt, mapping.size());
+}
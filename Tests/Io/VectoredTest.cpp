@@ -0,0 +1,48 @@
+#include <cassert>
+#include <string.h>
+
+#include <Io.hpp>
+#include <String.hpp>
+
+using namespace hsd::format_literals;
+
+int main()
+{
+    auto file = hsd::io::load_file(
+        "Tests/Io/vectored.txt", hsd::io_options::write
+    ).unwrap();
+
+    // Strings of 64 characters or more are not copied into the buffer
+    file.set_vectored_threshold(64);
+
+    hsd::string body{4096};
+    
+    for (hsd::usize index = 0; index < 4096; index++)
+    {
+        body.push_back('a' + static_cast<char>(index % 26));
+    }
+
+    hsd::string_view view = static_cast<hsd::string_view>(body);
+
+    file.print<"short line {}\n">(1);
+    file.print<"[{}] [{}] {} [{}]\n">(body.c_str(), view, 2, "small");
+    file.print<"short line {}\n">(3);
+    file.flush().unwrap();
+
+    auto check = hsd::io::load_file(
+        "Tests/Io/vectored.txt", hsd::io_options::read
+    ).unwrap();
+
+    check.get_stream().reserve(16384);
+    check.read_chunk().unwrap();
+
+    const char* data = check.get_stream().data();
+    hsd::usize expected_size = 13 + (1 + 4096 + 3 + 4096 + 2 + 2 + 8) + 13;
+    
+    assert(check.get_stream().size() == expected_size);
+    assert(strncmp(data, "short line 1\n[abcdef", 20) == 0);
+    assert(strncmp(data + 13 + 1 + 4096, "] [abc", 6) == 0);
+    assert(strncmp(data + expected_size - 25, "] 2 [small]\nshort line 3\n", 25) == 0);
+
+    hsd::println("Wrote {} bytes"_fmt, expected_size);
+}
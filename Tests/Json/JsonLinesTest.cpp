@@ -0,0 +1,81 @@
+#include <cassert>
+#include <Extra/Json.hpp>
+#include <Io.hpp>
+
+static const char* test_filename = "Tests/Json/TestFile.jsonl";
+
+int main() 
+{
+    using namespace hsd::format_literals;
+    using namespace hsd::string_view_literals;
+    using record_type = hsd::JsonLinesReader<char>::record_type;
+
+    hsd::vector<char> buffer;
+
+    auto append = [&](const char* str)
+    {
+        for (; *str != '\0'; str++)
+            buffer.push_back(*str);
+    };
+
+    for (hsd::i64 index = 0; index < 10000; index++)
+    {
+        append("{\"id\": ");
+        append(hsd::to_string(index).c_str());
+        append(", \"tags\": [true, false, null]}\n");
+    }
+
+    hsd::string_view lines{buffer.data(), buffer.size()};
+    
+    // Small chunks so that every worker gets some
+    hsd::JsonLinesReader<char> reader{4, 1024};
+    hsd::i64 expected = 0;
+
+    reader.parse(lines, [&](record_type&& record)
+    {
+        auto value = record.unwrap();
+        assert((*value)["id"_sv].as_num<hsd::i64>().unwrap() == expected++);
+    });
+
+    assert(expected == 10000);
+
+    hsd::atomic_i64 sum = 0;
+
+    reader.parse(lines, [&](record_type&& record)
+    {
+        auto value = record.unwrap();
+        sum += (*value)["id"_sv].as_num<hsd::i64>().unwrap();
+    }, hsd::JsonDelivery::Unordered);
+
+    assert(sum.load() == 9999 * 10000 / 2);
+
+    // The second record starts right after the first one's newline
+    hsd::usize seen = 0;
+
+    reader.parse("{\"ok\": 1}\n{\"broken\" 2}\n"_sv, [&](record_type&& record)
+    {
+        if (seen++ == 0)
+        {
+            auto value = record.unwrap();
+            assert((*value)["ok"_sv].as_num<hsd::i64>().unwrap() == 1);
+        }
+        else
+        {
+            assert(!record);
+            assert(record.unwrap_err().position == 10);
+            hsd::println("Record starting at byte {} is invalid"_fmt, record.unwrap_err().position);
+        }
+    });
+
+    assert(seen == 2);
+
+    reader.parse_file(test_filename, [](record_type&& record)
+    {
+        auto value = record.unwrap();
+
+        if (value->type() == hsd::JsonValueType::Object)
+            hsd::println("Price {}"_fmt, (*value)["price"_sv].as_num<hsd::f32>().unwrap());
+        else
+            hsd::println("Array of {} elements"_fmt, value->as_array().size());
+    }).unwrap();
+}
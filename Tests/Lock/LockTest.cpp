@@ -1,8 +1,10 @@
+#include <cassert>
 #include <Lock.hpp>
 #include <Thread.hpp>
 #include <UnorderedMap.hpp>
 #include <String.hpp>
 #include <Io.hpp>
+#include <Time.hpp>
 
 using namespace hsd::format_literals;
 
@@ -105,9 +107,169 @@ public:
     }
 };
 
+class SharedMutexTest
+{
+private:
+    static inline hsd::unordered_map<hsd::string, hsd::string> g_pages;
+    static inline hsd::shared_mutex g_pages_mutex;
+
+    static inline hsd::i64 g_first = 0;
+    static inline hsd::i64 g_second = 0;
+    static inline hsd::shared_mutex g_pair_mutex;
+
+public:
+    static void save_page(const hsd::string& url)
+    {
+        // simulate a long page fetch
+        hsd::this_thread::sleep_for(2).unwrap();
+        hsd::string result = "fake content";
+
+        hsd::unique_lock lock{g_pages_mutex};
+        g_pages[url] = result;
+    }
+
+    static void writer()
+    {
+        for (hsd::i32 index = 0; index < 20000; index++)
+        {
+            hsd::unique_lock lock{g_pair_mutex};
+            g_first++;
+            g_second--;
+        }
+    }
+
+    static void reader()
+    {
+        for (hsd::i32 index = 0; index < 100000; index++)
+        {
+            hsd::shared_lock lock{g_pair_mutex};
+            assert(g_first + g_second == 0);
+        }
+    }
+
+    static void test()
+    {
+        hsd::println("SharedMutexTest::test():"_fmt);
+        hsd::thread t1{save_page, "http://foo"};
+        hsd::thread t2{save_page, "http://bar"};
+        t1.join().unwrap();
+        t2.join().unwrap();
+
+        {
+            hsd::shared_lock lock{g_pages_mutex};
+
+            for (const auto& pair : g_pages)
+            {
+                hsd::println("{} => {}"_fmt, pair.first, pair.second);
+            }
+        }
+
+        // Readers never see a half done update, writers still get through
+        hsd::thread readers[] = {
+            hsd::thread{reader}, hsd::thread{reader}, hsd::thread{reader}
+        };
+
+        hsd::thread writers[] = {hsd::thread{writer}, hsd::thread{writer}};
+
+        for (auto& thread : readers)
+            thread.join().unwrap();
+
+        for (auto& thread : writers)
+            thread.join().unwrap();
+
+        assert(g_first == 40000 && g_second == -40000);
+    }
+};
+
+class AdaptiveMutexTest
+{
+private:
+    static inline hsd::u64 g_counter = 0;
+
+    template <typename Mutex>
+    static void hammer(Mutex& mutex)
+    {
+        for (hsd::i32 index = 0; index < 200000; index++)
+        {
+            hsd::unique_lock lock{mutex};
+            g_counter++;
+        }
+    }
+
+    // Four threads fighting over a very short critical section
+    template <typename Mutex>
+    static hsd::u64 contend(Mutex& mutex)
+    {
+        g_counter = 0;
+        hsd::precise_clock clock;
+
+        hsd::thread threads[] = {
+            hsd::thread{[&mutex] { hammer(mutex); }},
+            hsd::thread{[&mutex] { hammer(mutex); }},
+            hsd::thread{[&mutex] { hammer(mutex); }},
+            hsd::thread{[&mutex] { hammer(mutex); }}
+        };
+
+        for (auto& thread : threads)
+            thread.join().unwrap();
+
+        assert(g_counter == 800000);
+        return clock.restart().to_nanoseconds() / g_counter;
+    }
+
+public:
+    static void test()
+    {
+        hsd::println("AdaptiveMutexTest::test():"_fmt);
+
+        hsd::adaptive_mutex adaptive;
+        hsd::futex futex;
+        hsd::mutex mutex;
+        hsd::spin spin;
+
+        hsd::println("adaptive_mutex: {}ns per lock"_fmt, contend(adaptive));
+        hsd::println("futex: {}ns per lock"_fmt, contend(futex));
+        hsd::println("mutex: {}ns per lock"_fmt, contend(mutex));
+        hsd::println("spin: {}ns per lock"_fmt, contend(spin));
+
+        // With a single core the run above may never collide,
+        // this lock() can't get in before the main thread lets go
+        adaptive.lock();
+        hsd::thread waiter{[&adaptive] {
+            adaptive.lock();
+            adaptive.unlock();
+        }};
+
+        while (adaptive.stats().contended == 0)
+        {
+            hsd::this_thread::yield();
+        }
+
+        adaptive.unlock();
+        waiter.join().unwrap();
+
+        auto stats = adaptive.stats();
+        assert(stats.contended > 0);
+        assert(stats.spin_acquired <= stats.contended);
+        assert(stats.spin_limit >= hsd::adaptive_mutex::min_spins);
+        assert(stats.spin_limit <= hsd::adaptive_mutex::max_spins);
+
+        hsd::println(
+            "contended: {}, got in spinning: {}, parked: {}, spin limit: {}"_fmt,
+            stats.contended, stats.spin_acquired, stats.parked, stats.spin_limit
+        );
+
+        assert(adaptive.try_lock() == true);
+        assert(adaptive.try_lock() == false);
+        adaptive.unlock();
+    }
+};
+
 int main()
 {
     SpinTest::test();
     MutexTest::test();
     FutexTest::test();
+    SharedMutexTest::test();
+    AdaptiveMutexTest::test();
 }
\ No newline at end of file
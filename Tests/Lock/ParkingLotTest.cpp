@@ -0,0 +1,109 @@
+#define HSD_FORCE_PARKING_LOT
+
+#include <cassert>
+#include <Lock.hpp>
+#include <Thread.hpp>
+#include <Io.hpp>
+
+using namespace hsd::format_literals;
+
+static hsd::atomic_u32 g_flag = 0;
+
+static void wait_for_flag()
+{
+    while (g_flag.load() == 0)
+    {
+        hsd::parking_lot::park(&g_flag, [] { return g_flag.load() == 0; });
+    }
+}
+
+template <typename Mutex>
+static void hammer(Mutex& mutex, hsd::u64& counter)
+{
+    for (hsd::i32 index = 0; index < 50000; index++)
+    {
+        hsd::unique_lock lock{mutex};
+        counter++;
+    }
+}
+
+template <typename Mutex>
+static void contend(Mutex& mutex)
+{
+    hsd::u64 counter = 0;
+
+    hsd::thread threads[] = {
+        hsd::thread{[&mutex, &counter] { hammer(mutex, counter); }},
+        hsd::thread{[&mutex, &counter] { hammer(mutex, counter); }},
+        hsd::thread{[&mutex, &counter] { hammer(mutex, counter); }},
+        hsd::thread{[&mutex, &counter] { hammer(mutex, counter); }}
+    };
+
+    for (auto& thread : threads)
+        thread.join().unwrap();
+
+    assert(counter == 200000);
+}
+
+int main()
+{
+    // Nothing parks when the validation fails, nothing to wake up
+    {
+        hsd::u32 word = 1;
+        assert(hsd::parking_lot::park(&word, [&word] { return word == 0; }) == false);
+        assert(hsd::parking_lot::unpark_one(&word).unparked == false);
+        assert(hsd::parking_lot::unpark_all(&word) == 0);
+    }
+
+    // Waiters on one address get woken, waiters elsewhere don't
+    {
+        hsd::thread first{wait_for_flag};
+        hsd::thread second{wait_for_flag};
+
+        hsd::this_thread::sleep_for(0.05f).unwrap();
+        hsd::u32 other = 0;
+        assert(hsd::parking_lot::unpark_all(&other) == 0);
+
+        g_flag.store(1);
+        hsd::parking_lot::unpark_all(&g_flag);
+
+        first.join().unwrap();
+        second.join().unwrap();
+    }
+
+    // before_sleep runs once queued, so a release in there can't be missed
+    {
+        hsd::mutex mutex;
+        bool ready = false;
+
+        mutex.lock();
+
+        hsd::thread notifier{[&] {
+            hsd::unique_lock lock{mutex};
+            ready = true;
+            hsd::parking_lot::unpark_one(&ready);
+        }};
+
+        while (ready == false)
+        {
+            hsd::parking_lot::park(&ready, [] { return true; }, [&] { mutex.unlock(); });
+            mutex.lock();
+        }
+
+        mutex.unlock();
+        notifier.join().unwrap();
+    }
+
+    // Every futex based lock runs on the parking lot here
+    {
+        hsd::futex futex;
+        hsd::shared_mutex shared;
+        hsd::adaptive_mutex adaptive;
+
+        contend(futex);
+        contend(shared);
+        contend(adaptive);
+    }
+
+    hsd::println("Parking lot tests passed"_fmt);
+}
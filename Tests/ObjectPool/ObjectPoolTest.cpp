@@ -0,0 +1,279 @@
+// Checks reuse with and without a reset hook, handles moving around,
+// objects changing threads and pools going away before their threads.
+// Worth running with -fsanitize=address and -fsanitize=thread too
+#include <cassert>
+#include <ObjectPool.hpp>
+#include <Thread.hpp>
+#include <Time.hpp>
+#include <Io.hpp>
+
+// Stand-in for a parser's working state, it keeps count of how
+// often it's built and torn down to tell reuse from rebuilding
+struct parser_state
+{
+    static inline hsd::atomic_i64 built = 0;
+    static inline hsd::atomic_i64 torn_down = 0;
+
+    hsd::u64 depth;
+    hsd::vector<hsd::u64> tokens;
+
+    parser_state(hsd::u64 start = 0)
+        : depth{start}
+    {
+        built.fetch_add(1, hsd::memory_order_relaxed);
+    }
+
+    ~parser_state()
+    {
+        torn_down.fetch_add(1, hsd::memory_order_relaxed);
+    }
+
+    static hsd::i64 alive()
+    {
+        return built.load() - torn_down.load();
+    }
+};
+
+static void reset_state(parser_state& state)
+{
+    state.depth = 0;
+    state.tokens.clear();
+}
+
+using state_pool = hsd::object_pool<parser_state>;
+
+int main()
+{
+    using namespace hsd::format_literals;
+
+    // A handle is as big as a pointer to the object and one to the pool
+    static_assert(sizeof(hsd::pooled_ptr<parser_state>) == 2 * sizeof(void*));
+
+    // Without a reset hook objects are rebuilt, only the memory is reused
+    {
+        state_pool pool;
+        parser_state* first_address = nullptr;
+
+        {
+            auto first = pool.acquire(1u);
+            first_address = first.get();
+            assert(first->depth == 1);
+            assert(parser_state::alive() == 1);
+        }
+
+        assert(parser_state::alive() == 0);
+
+        auto second = pool.acquire(2u);
+        assert(second.get() == first_address);
+        assert(second->depth == 2);
+        assert(parser_state::built.load() == 2);
+
+        auto stats = pool.stats();
+        assert(stats.created == 1);
+        assert(stats.reused == 1);
+        assert(stats.in_use == 1);
+        assert(stats.idle == 0);
+
+        second = nullptr;
+        stats = pool.stats();
+        assert(stats.in_use == 0);
+        assert(stats.idle == 1);
+        assert(pool.trim() == 1);
+        assert(pool.stats().idle == 0);
+    }
+
+    // With one they stay alive and keep what they own
+    {
+        state_pool pool{reset_state};
+        const hsd::u64* buffer = nullptr;
+
+        {
+            auto state = pool.acquire(5u);
+
+            for (hsd::u64 token = 0; token < 100; token++)
+                state->tokens.push_back(token);
+
+            buffer = state->tokens.data();
+        }
+
+        assert(parser_state::alive() == 1);
+
+        auto state = pool.acquire(7u);
+        assert(state->depth == 0);
+        assert(state->tokens.size() == 0);
+        assert(state->tokens.capacity() >= 100);
+        assert(state->tokens.data() == buffer);
+
+        // Idle objects go with the pool, buffers included
+        auto other = pool.acquire();
+        other->tokens.push_back(1);
+    }
+
+    assert(parser_state::alive() == 0);
+
+    // Handles move like any unique_ptr and give the object back once
+    {
+        state_pool pool;
+        auto first = pool.acquire(1u);
+        auto moved = hsd::move(first);
+
+        assert(first == nullptr);
+        assert(moved->depth == 1);
+
+        moved = pool.acquire(2u);
+        assert(moved->depth == 2);
+        assert(parser_state::alive() == 1);
+
+        auto stats = pool.stats();
+        assert(stats.created == 2);
+        assert(stats.in_use == 1);
+        assert(stats.idle == 1);
+    }
+
+    assert(parser_state::alive() == 0);
+
+    // Objects travel between threads, through the shared list when
+    // a thread's own cache overflows or runs dry
+    {
+        state_pool pool;
+        constexpr hsd::u64 per_thread = 20'000;
+        constexpr hsd::usize held = 100;
+        hsd::atomic_u64 checksum = 0;
+
+        auto worker = [&](hsd::u64 first) {
+            hsd::vector<hsd::pooled_ptr<parser_state>> states;
+            hsd::u64 sum = 0;
+
+            for (hsd::u64 round = 0; round < per_thread; round++)
+            {
+                states.push_back(pool.acquire(first + round));
+
+                if (states.size() == held)
+                {
+                    for (auto& state : states)
+                        sum += state->depth;
+
+                    states.clear();
+                }
+            }
+
+            for (auto& state : states)
+                sum += state->depth;
+
+            checksum.fetch_add(sum);
+        };
+
+        hsd::thread threads[] = {
+            hsd::thread{[&] { worker(0); }},
+            hsd::thread{[&] { worker(per_thread); }},
+            hsd::thread{[&] { worker(per_thread * 2); }},
+            hsd::thread{[&] { worker(per_thread * 3); }}
+        };
+
+        for (auto& thread : threads)
+            thread.join().unwrap();
+
+        constexpr hsd::u64 total = per_thread * 4;
+        assert(checksum.load() == total * (total - 1) / 2);
+        assert(parser_state::alive() == 0);
+
+        auto stats = pool.stats();
+        assert(stats.in_use == 0);
+        assert(stats.created + stats.reused == total);
+        assert(stats.idle == stats.created);
+
+        // Caches of finished threads are handed to the shared list
+        assert(pool.trim() == stats.created);
+        assert(pool.stats().idle == 0);
+    }
+
+    // Short lived pools used from a long lived worker, like the ones
+    // of the global thread_pool: the worker outlives both of them
+    {
+        hsd::atomic_u32 step = 0;
+
+        auto wait_for = [&](hsd::u32 value) {
+            while (step.load() != value)
+                hsd::cpu_relax();
+        };
+
+        auto* pool = new state_pool{reset_state};
+
+        hsd::thread worker{[&] {
+            // Both end up in the worker's own cache
+            {
+                auto first = pool->acquire(1u);
+                auto second = pool->acquire(2u);
+            }
+
+            step.store(1);
+            wait_for(2);
+
+            // Maybe at the same address, but a different pool
+            {
+                auto state = pool->acquire(3u);
+                assert(state->depth == 3);
+            }
+
+            assert(pool->stats().created == 1);
+            step.store(3);
+            wait_for(4);
+        }};
+
+        wait_for(1);
+        delete pool;
+        assert(parser_state::alive() == 0);
+
+        pool = new state_pool{reset_state};
+        step.store(2);
+        wait_for(3);
+        delete pool;
+        assert(parser_state::alive() == 0);
+
+        step.store(4);
+        worker.join().unwrap();
+    }
+
+    // States built once and reused, against building a new one each time
+    {
+        constexpr hsd::usize count = 1 << 14;
+        constexpr hsd::u64 tokens = 256;
+
+        state_pool pool{reset_state};
+        hsd::precise_clock clock;
+        hsd::u64 sum = 0;
+
+        for (hsd::usize index = 0; index < count; index++)
+        {
+            auto state = pool.acquire();
+
+            for (hsd::u64 token = 0; token < tokens; token++)
+                state->tokens.push_back(token + index);
+
+            sum += state->tokens[index % tokens];
+        }
+
+        auto pooled = clock.restart().to_nanoseconds();
+
+        for (hsd::usize index = 0; index < count; index++)
+        {
+            auto state = hsd::make_unique<parser_state>();
+
+            for (hsd::u64 token = 0; token < tokens; token++)
+                state->tokens.push_back(token + index);
+
+            sum -= state->tokens[index % tokens];
+        }
+
+        auto fresh = clock.restart().to_nanoseconds();
+        assert(sum == 0);
+
+        hsd::println(
+            "pooled: {}ns, make_unique: {}ns per parser state"_fmt,
+            static_cast<hsd::f64>(pooled) / count,
+            static_cast<hsd::f64>(fresh) / count
+        );
+    }
+
+    hsd::println("Object pool tests passed"_fmt);
+}
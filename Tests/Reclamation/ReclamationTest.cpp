@@ -0,0 +1,246 @@
+// Stress test, meant to be run under ThreadSanitizer and AddressSanitizer
+// as well: g++ -std=c++20 -fsanitize=thread ReclamationTest.cpp -lpthread
+#include <cassert>
+#include <Reclamation.hpp>
+#include <Thread.hpp>
+#include <Io.hpp>
+
+static hsd::atomic_i64 g_live = 0;
+
+struct tracked
+{
+    hsd::u64 value;
+    tracked* next = nullptr;
+
+    tracked(hsd::u64 val)
+        : value{val}
+    {
+        g_live.fetch_add(1, hsd::memory_order_relaxed);
+    }
+
+    ~tracked()
+    {
+        // Poison it, a reader still holding it would notice
+        value = ~0ull;
+        g_live.fetch_sub(1, hsd::memory_order_relaxed);
+    }
+};
+
+// Treiber stack, pop retires the nodes it unlinks
+class stack
+{
+private:
+    hsd::atomic<tracked*> _head = nullptr;
+    hsd::epoch_domain& _domain;
+
+public:
+    stack(hsd::epoch_domain& domain)
+        : _domain{domain}
+    {}
+
+    ~stack()
+    {
+        auto* node = _head.load();
+
+        while (node != nullptr)
+        {
+            delete hsd::exchange(node, node->next);
+        }
+    }
+
+    void push(hsd::u64 value)
+    {
+        auto* node = new tracked{value};
+        node->next = _head.load(hsd::memory_order_relaxed);
+
+        while (!_head.compare_exchange_weak(
+            node->next, node, hsd::memory_order_release, hsd::memory_order_relaxed))
+            ;
+    }
+
+    hsd::option<hsd::u64> pop()
+    {
+        auto guard = _domain.pin();
+        auto* node = _head.load(hsd::memory_order_acquire);
+
+        while (node != nullptr)
+        {
+            // Safe to read even if another thread popped it meanwhile
+            if (_head.compare_exchange_weak(
+                node, node->next, hsd::memory_order_acquire, hsd::memory_order_acquire))
+            {
+                hsd::u64 value = node->value;
+                guard.retire(node);
+                return value;
+            }
+        }
+
+        return {};
+    }
+};
+
+struct config
+{
+    hsd::u64 version;
+    hsd::u64 checksum;
+};
+
+int main()
+{
+    using namespace hsd::format_literals;
+
+    // Nothing retired is freed while a guard from before is alive
+    {
+        hsd::epoch_domain domain;
+        auto* first = new tracked{1};
+
+        {
+            auto reader = domain.pin();
+            domain.retire(first);
+
+            for (hsd::i32 round = 0; round < 10; round++)
+            {
+                domain.collect();
+            }
+
+            assert(first->value == 1);
+            assert(domain.pending() == 1);
+        }
+
+        domain.collect();
+        domain.collect();
+        assert(domain.pending() == 0);
+        assert(g_live.load() == 0);
+    }
+
+    // Lock-free stack under pushes and pops from every thread
+    {
+        hsd::epoch_domain domain;
+
+        {
+            stack shared{domain};
+            hsd::atomic_u64 popped_sum = 0;
+            constexpr hsd::u64 per_thread = 50'000;
+
+            auto worker = [&](hsd::u64 first) {
+                hsd::u64 sum = 0;
+
+                for (hsd::u64 value = first; value < first + per_thread; value++)
+                {
+                    shared.push(value);
+
+                    if (auto popped = shared.pop(); popped.is_ok())
+                    {
+                        assert(popped.unwrap() != ~0ull);
+                        sum += popped.unwrap();
+                    }
+                }
+
+                popped_sum.fetch_add(sum);
+            };
+
+            hsd::thread threads[] = {
+                hsd::thread{[&] { worker(0); }},
+                hsd::thread{[&] { worker(per_thread); }},
+                hsd::thread{[&] { worker(per_thread * 2); }},
+                hsd::thread{[&] { worker(per_thread * 3); }}
+            };
+
+            for (auto& thread : threads)
+                thread.join().unwrap();
+
+            while (auto popped = shared.pop())
+            {
+                popped_sum.fetch_add(popped.unwrap());
+            }
+
+            constexpr hsd::u64 total = per_thread * 4;
+            assert(popped_sum.load() == total * (total - 1) / 2);
+        }
+
+        // Whatever the workers didn't get to free goes with the domain
+    }
+
+    assert(g_live.load() == 0);
+
+    // RCU style snapshots, readers never see a torn or freed config
+    {
+        hsd::epoch_domain domain;
+        hsd::rcu_cell<config> current{new config{0, 0}, domain};
+        hsd::atomic_bool done = false;
+
+        auto reader = [&] {
+            hsd::u64 last = 0;
+
+            while (done.load() == false)
+            {
+                auto guard = current.pin();
+                auto* snapshot = current.read(guard);
+
+                assert(snapshot->checksum == snapshot->version * 3);
+                assert(snapshot->version >= last);
+                last = snapshot->version;
+            }
+        };
+
+        hsd::thread readers[] = {hsd::thread{reader}, hsd::thread{reader}};
+
+        for (hsd::u64 version = 1; version <= 20'000; version++)
+        {
+            current.update(new config{version, version * 3});
+        }
+
+        done.store(true);
+
+        for (auto& thread : readers)
+            thread.join().unwrap();
+    }
+
+    // A domain can go away before the threads that used it, what they
+    // retired goes with it and their records are freed when they exit
+    {
+        hsd::atomic_u32 step = 0;
+
+        auto wait_for = [&](hsd::u32 value) {
+            while (step.load() != value)
+                hsd::cpu_relax();
+        };
+
+        auto* domain = new hsd::epoch_domain;
+
+        hsd::thread worker{[&] {
+            {
+                auto guard = domain->pin();
+                guard.retire(new tracked{1});
+            }
+
+            step.store(1);
+            wait_for(2);
+
+            // Maybe at the same address, but a different domain
+            {
+                auto guard = domain->pin();
+                guard.retire(new tracked{2});
+            }
+
+            assert(domain->pending() == 1);
+            step.store(3);
+            wait_for(4);
+        }};
+
+        wait_for(1);
+        delete domain;
+        assert(g_live.load() == 0);
+
+        domain = new hsd::epoch_domain;
+        step.store(2);
+        wait_for(3);
+        delete domain;
+        assert(g_live.load() == 0);
+
+        step.store(4);
+        worker.join().unwrap();
+    }
+
+    hsd::println("Reclamation tests passed"_fmt);
+}
@@ -0,0 +1,80 @@
+#include <Allocator.hpp>
+#include <Vector.hpp>
+#include <Time.hpp>
+#include <Io.hpp>
+
+#include <cassert>
+
+using namespace hsd::format_literals;
+
+using alloc_result = hsd::result<hsd::i32*, hsd::allocator_detail::allocator_error>;
+using at_result = decltype(hsd::declval<hsd::vector<hsd::i32>&>().at(0));
+using flush_result = hsd::result<hsd::reference<hsd::io>, hsd::runtime_error>;
+
+// Kept out of line, so the results really
+// have to be returned from a function call
+
+[[gnu::noipa]] static alloc_result allocate(hsd::allocator<hsd::i32>& alloc)
+{
+    return alloc.allocate(1);
+}
+
+[[gnu::noipa]] static at_result checked_at(hsd::vector<hsd::i32>& values, hsd::usize index)
+{
+    return values.at(index);
+}
+
+[[gnu::noipa]] static flush_result flush(hsd::io& file)
+{
+    return file.flush();
+}
+
+template <typename Func>
+static void bench(const char* name, hsd::usize count, Func&& func)
+{
+    hsd::precise_clock clock;
+    hsd::u64 sum = 0;
+
+    for (hsd::usize index = 0; index < count; index++)
+        sum += func(index);
+
+    hsd::println(
+        "{}: {}ns per call ({})"_fmt, name,
+        static_cast<hsd::f64>(clock.restart().to_nanoseconds()) / count, sum
+    );
+}
+
+int main()
+{
+    constexpr hsd::usize count = 1 << 24;
+
+    hsd::println(
+        "sizeof: allocate {}, at {}, flush {}"_fmt,
+        sizeof(alloc_result), sizeof(at_result), sizeof(flush_result)
+    );
+
+    hsd::allocator<hsd::i32> alloc;
+
+    bench("allocate + deallocate", count, [&](hsd::usize index) {
+        auto* ptr = allocate(alloc).unwrap();
+        *ptr = static_cast<hsd::i32>(index);
+        hsd::u64 value = static_cast<hsd::u64>(*ptr);
+        alloc.deallocate(ptr, 1).unwrap();
+        return value;
+    });
+
+    hsd::vector<hsd::i32> values;
+
+    for (hsd::i32 index = 0; index < 1024; index++)
+        values.push_back(index);
+
+    bench("vector::at", count, [&](hsd::usize index) {
+        return static_cast<hsd::u64>(checked_at(values, index & 1023).unwrap().get());
+    });
+
+    auto file = hsd::io::load_file("/dev/null", hsd::io_options::write).unwrap();
+
+    bench("io::flush", count, [&](hsd::usize) {
+        return static_cast<hsd::u64>(flush(file).is_ok());
+    });
+}
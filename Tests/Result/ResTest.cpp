@@ -1,6 +1,8 @@
 #include <Result.hpp>
 #include <String.hpp>
 
+#include <cassert>
+
 struct S
 {
     const char* pretty_error() const
@@ -9,6 +11,23 @@ struct S
     }
 };
 
+struct empty_error
+{
+    const char* pretty_error() const
+    {
+        return "Nothing here";
+    }
+};
+
+static constexpr auto find_index(hsd::u32 val)
+    -> hsd::result<hsd::nonmax<hsd::u32>, empty_error>
+{
+    if (val == 0)
+        return empty_error{};
+    else
+        return hsd::nonmax<hsd::u32>{val - 1};
+}
+
 static auto fail_func(hsd::i32 val) 
     -> hsd::result<hsd::string, S>
 {
@@ -63,4 +82,33 @@ int main()
             return "New string";
         }
     );
+
+    // The niche of the payload replaces the flag
+    static_assert(sizeof(hsd::result<hsd::i32*, empty_error>) == sizeof(hsd::i32*));
+    static_assert(sizeof(hsd::option<hsd::reference<hsd::i32>>) == sizeof(hsd::i32*));
+    static_assert(sizeof(hsd::result<hsd::nonmax<hsd::u32>, empty_error>) == sizeof(hsd::u32));
+    static_assert(sizeof(hsd::result<hsd::i32*, hsd::runtime_error>) > sizeof(hsd::i32*));
+    static_assert(std::is_trivially_copyable_v<hsd::result<hsd::i32*, hsd::runtime_error>>);
+
+    hsd::i32 value = 42;
+    hsd::option<hsd::reference<hsd::i32>> ref = hsd::reference{value};
+    hsd::option<hsd::reference<hsd::i32>> no_ref;
+    assert(ref.is_ok() && !no_ref.is_ok());
+    assert(&ref.unwrap().get() == &value);
+
+    hsd::result<hsd::i32*, empty_error> null_ptr = static_cast<hsd::i32*>(nullptr);
+    hsd::result<hsd::i32*, empty_error> no_ptr = empty_error{};
+    assert(null_ptr.is_ok() && null_ptr.unwrap() == nullptr);
+    assert(!no_ptr.is_ok());
+    no_ptr = hsd::move(null_ptr);
+    assert(no_ptr.is_ok());
+
+    assert(find_index(5).unwrap() == 4u);
+    assert(!find_index(0).is_ok());
+    assert(find_index(0).unwrap_or(7u) == 7u);
+
+    static_assert([] {
+        auto index = find_index(0x10000);
+        return index.is_ok() && index.unwrap().get() == 0xFFFFu;
+    }());
 }
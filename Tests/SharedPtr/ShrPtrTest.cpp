@@ -1,5 +1,8 @@
 #include <Io.hpp>
 #include <SharedPtr.hpp>
+#include <Time.hpp>
+
+#include <cassert>
 
 struct S
 {
@@ -48,6 +51,38 @@ struct derived
     {}
 };
 
+struct counted
+{
+    static inline int alive = 0;
+    int value = 7;
+
+    counted() { alive++; }
+    ~counted() { alive--; }
+};
+
+struct alignas(64) over_aligned
+{
+    int value;
+};
+
+static constexpr hsd::usize iterations = 1'000'000;
+
+template <typename Func>
+static void bench(const char* name, Func func)
+{
+    using namespace hsd::format_literals;
+
+    hsd::precise_clock clock;
+
+    for (hsd::usize i = 0; i < iterations; i++)
+        func();
+
+    hsd::println(
+        "{}: {}ns per pointer"_fmt, name,
+        clock.restart().to_nanoseconds() / iterations
+    );
+}
+
 int main()
 {
     {
@@ -93,4 +128,74 @@ int main()
         elm4 = elm3;
         elm4 = hsd::move(elm3);
     }
-}
\ No newline at end of file
+
+    {
+        auto arr = hsd::make_safe_shared<counted[]>(16);
+        assert(counted::alive == 16);
+        assert(arr.get()[15].value == 7);
+
+        auto arr2 = arr;
+        assert(arr2.get_count() == 2);
+        assert(arr2 == arr);
+        assert(arr2 != nullptr);
+
+        arr = nullptr;
+        assert(counted::alive == 16);
+        assert(arr2.is_unique());
+
+        hsd::uchar buf[256]{};
+        hsd::buffered_allocator<int> alloc{buf, 256};
+        auto arr3 = hsd::make_unsafe_shared<counted[]>(alloc, 8);
+        assert(counted::alive == 24);
+    }
+
+    assert(counted::alive == 0);
+
+    {
+        // The allocator is only converted to build a new one,
+        // nothing allocated as int is freed as over_aligned
+        hsd::allocator<int> alloc;
+        auto safe = hsd::make_safe_shared<over_aligned>(alloc, 5);
+        auto unsafe = hsd::make_unsafe_shared<over_aligned>(alloc, 6);
+
+        assert(reinterpret_cast<hsd::uptr>(safe.get()) % alignof(over_aligned) == 0);
+        assert(reinterpret_cast<hsd::uptr>(unsafe.get()) % alignof(over_aligned) == 0);
+        assert(safe->value == 5 && unsafe->value == 6);
+    }
+
+    {
+        hsd::println("make_shared, one allocation vs two:"_fmt);
+
+        bench("safe, single allocation", [] {
+            auto ptr = hsd::make_safe_shared<S>(12, 'c', 4.3f, "str");
+            auto copy = ptr;
+            assert(copy->_a == 12);
+        });
+
+        bench("safe, separate allocations", [] {
+            hsd::allocator<S> alloc;
+            auto* raw = alloc.allocate(1).unwrap();
+            alloc.construct_at(raw, 12, 'c', 4.3f, "str");
+
+            hsd::safe_shared_ptr<S> ptr{raw};
+            auto copy = ptr;
+            assert(copy->_a == 12);
+        });
+
+        bench("unsafe, single allocation", [] {
+            auto ptr = hsd::make_unsafe_shared<S>(12, 'c', 4.3f, "str");
+            auto copy = ptr;
+            assert(copy->_a == 12);
+        });
+
+        bench("unsafe, separate allocations", [] {
+            hsd::allocator<S> alloc;
+            auto* raw = alloc.allocate(1).unwrap();
+            alloc.construct_at(raw, 12, 'c', 4.3f, "str");
+
+            hsd::unsafe_shared_ptr<S> ptr{raw};
+            auto copy = ptr;
+            assert(copy->_a == 12);
+        });
+    }
+}
@@ -0,0 +1,138 @@
+#include <cassert>
+#include <SharedPtr.hpp>
+#include <Thread.hpp>
+#include <Vector.hpp>
+#include <Io.hpp>
+
+struct texture
+{
+    static inline hsd::atomic_i32 alive = 0;
+    hsd::i32 id;
+
+    texture(hsd::i32 value)
+        : id{value}
+    {
+        alive.fetch_add(1, hsd::memory_order_relaxed);
+    }
+
+    virtual ~texture()
+    {
+        alive.fetch_sub(1, hsd::memory_order_relaxed);
+    }
+};
+
+struct big_texture : texture
+{
+    big_texture(hsd::i32 value)
+        : texture{value}
+    {}
+};
+
+// Remembers what it loaded without keeping it alive, a texture
+// is loaded again only once every user has let go of it
+class texture_cache
+{
+private:
+    hsd::vector<hsd::unsafe_weak_ptr<texture>> _slots;
+
+public:
+    hsd::i32 loads = 0;
+
+    texture_cache()
+    {
+        _slots.resize(16);
+    }
+
+    hsd::unsafe_shared_ptr<texture> get(hsd::i32 id)
+    {
+        auto& slot = _slots[static_cast<hsd::usize>(id)];
+
+        if (auto cached = slot.lock(); cached != nullptr)
+            return cached;
+
+        loads++;
+        auto loaded = hsd::make_unsafe_shared<texture>(id);
+        slot = loaded;
+        return loaded;
+    }
+};
+
+int main()
+{
+    using namespace hsd::format_literals;
+
+    {
+        hsd::unsafe_weak_ptr<texture> weak;
+        assert(weak.expired());
+        assert(weak.lock() == nullptr);
+
+        {
+            auto strong = hsd::make_unsafe_shared<texture>(1);
+            weak = strong;
+
+            assert(!weak.expired());
+            assert(weak.get_count() == 1);
+            assert(weak.lock()->id == 1);
+            assert(strong.is_unique());
+        }
+
+        // The object is gone, the block waits for the weak pointer
+        assert(texture::alive.load() == 0);
+        assert(weak.expired());
+        assert(weak.lock() == nullptr);
+    }
+
+    {
+        hsd::unsafe_shared_ptr<big_texture> derived =
+            hsd::make_unsafe_shared<big_texture>(2);
+
+        hsd::unsafe_weak_ptr<texture> weak = derived;
+        hsd::unsafe_weak_ptr<texture> copy = weak;
+        hsd::unsafe_weak_ptr<texture> moved = hsd::move(copy);
+
+        assert(moved.lock()->id == 2);
+        derived = nullptr;
+        assert(moved.expired() && weak.expired());
+    }
+
+    {
+        texture_cache cache;
+
+        {
+            auto first = cache.get(3);
+            auto second = cache.get(3);
+            assert(first == second);
+            assert(cache.loads == 1);
+        }
+
+        assert(texture::alive.load() == 0);
+        cache.get(3);
+        assert(cache.loads == 2);
+    }
+
+    // lock() racing with the last owner letting go
+    {
+        for (hsd::i32 round = 0; round < 2000; round++)
+        {
+            auto strong = hsd::make_safe_shared<texture>(round);
+            hsd::safe_weak_ptr<texture> weak = strong;
+            hsd::atomic_i32 locked = 0;
+
+            hsd::thread reader{[&weak, &locked, round] {
+                if (auto ptr = weak.lock(); ptr != nullptr)
+                {
+                    assert(ptr->id == round);
+                    locked.fetch_add(1);
+                }
+            }};
+
+            strong = nullptr;
+            reader.join().unwrap();
+
+            assert(weak.expired());
+            assert(texture::alive.load() == 0);
+        }
+    }
+
+    hsd::println("Weak pointer tests passed"_fmt);
+}
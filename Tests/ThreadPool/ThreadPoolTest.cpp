@@ -0,0 +1,138 @@
+#include <cassert>
+#include <ThreadPool.hpp>
+#include <Time.hpp>
+#include <Io.hpp>
+
+static hsd::u64 tiny_work(hsd::u64 seed)
+{
+    for (hsd::u32 index = 0; index < 64; index++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    }
+
+    return seed;
+}
+
+// Every task splits itself in two, so nearly all the work gets
+// spawned from inside the workers and has to be stolen to spread
+static void fork_tree(
+    hsd::thread_pool& pool, hsd::u32 depth, hsd::atomic_u64& leaves)
+{
+    if (depth == 0)
+    {
+        // Release, so the last leaf happens before leaves goes away
+        leaves.fetch_add(1, hsd::memory_order_release);
+        return;
+    }
+
+    pool.execute([&pool, depth, &leaves] { fork_tree(pool, depth - 1, leaves); });
+    pool.execute([&pool, depth, &leaves] { fork_tree(pool, depth - 1, leaves); });
+}
+
+int main()
+{
+    using namespace hsd::format_literals;
+
+    hsd::thread_pool pool;
+    hsd::precise_clock clock;
+
+    // Futures carry the value and the error back like packaged_task
+    {
+        auto plain = pool.submit([](hsd::i32 a, hsd::i32 b) { return a + b; }, 3, 4);
+
+        auto failing = pool.submit([]() -> hsd::result<hsd::i32, hsd::runtime_error> {
+            return hsd::runtime_error{"expected failure"};
+        });
+
+        auto nothing = pool.submit([]{});
+
+        plain.wait();
+        failing.wait();
+        nothing.wait();
+
+        assert(plain.get().unwrap() == 7);
+        assert(failing.get().is_ok() == false);
+        assert(nothing.get().is_ok() == true);
+    }
+
+    // Stealing: the whole tree is spawned from the workers
+    {
+        constexpr hsd::u32 depth = 18;
+        hsd::atomic_u64 leaves = 0;
+
+        clock.restart();
+        pool.execute([&pool, &leaves] { fork_tree(pool, depth, leaves); });
+
+        while (leaves.load(hsd::memory_order_acquire) != (1ull << depth))
+        {
+            hsd::this_thread::yield();
+        }
+
+        hsd::println(
+            "fork tree of {} leaves: {}ns per task"_fmt, 1ull << depth,
+            clock.restart().to_nanoseconds() / ((2ull << depth) - 1)
+        );
+    }
+
+    // Fine-grained throughput, one future per task
+    {
+        constexpr hsd::usize tasks = 100'000;
+        hsd::vector<hsd::future<hsd::u64>> futures;
+        futures.reserve(tasks);
+
+        clock.restart();
+
+        for (hsd::usize index = 0; index < tasks; index++)
+        {
+            futures.emplace_back(pool.submit(tiny_work, index));
+        }
+
+        hsd::u64 checksum = 0;
+
+        for (auto& future : futures)
+        {
+            future.wait();
+            checksum ^= future.get().unwrap();
+        }
+
+        hsd::println(
+            "thread_pool::submit: {}ns per task"_fmt,
+            clock.restart().to_nanoseconds() / tasks
+        );
+
+        for (hsd::usize index = 0; index < tasks; index++)
+        {
+            checksum ^= tiny_work(index);
+        }
+
+        assert(checksum == 0);
+    }
+
+    // The same work with a thread spawned for every task
+    {
+        constexpr hsd::usize tasks = 5'000;
+        hsd::u64 checksum = 0;
+
+        clock.restart();
+
+        for (hsd::usize index = 0; index < tasks; index++)
+        {
+            hsd::u64 value = 0;
+            hsd::thread worker{[&value, index] { value = tiny_work(index); }};
+            worker.join().unwrap();
+            checksum ^= value;
+        }
+
+        hsd::println(
+            "thread per task: {}ns per task"_fmt,
+            clock.restart().to_nanoseconds() / tasks
+        );
+
+        for (hsd::usize index = 0; index < tasks; index++)
+        {
+            checksum ^= tiny_work(index);
+        }
+
+        assert(checksum == 0);
+    }
+}
@@ -1,4 +1,8 @@
 #include <UniquePtr.hpp>
+#include <Vector.hpp>
+#include <String.hpp>
+
+#include <cassert>
 
 struct base
 {
@@ -15,8 +19,38 @@ struct derived
     {}
 };
 
+static hsd::i32 destroyed = 0;
+
+struct counted
+{
+    hsd::i32 id = 0;
+
+    ~counted()
+    {
+        // Elements go in reverse order, all of them
+        assert(id == 3 - destroyed);
+        destroyed++;
+    }
+};
+
 int main()
 {
+    // Stateless allocators add nothing
+    static_assert(sizeof(hsd::unique_ptr<int>) == sizeof(int*));
+    static_assert(sizeof(hsd::unique_ptr<int[]>) == sizeof(int*) + sizeof(hsd::usize));
+    static_assert(sizeof(hsd::vector<int>) == sizeof(int*) + 2 * sizeof(hsd::usize));
+    static_assert(sizeof(hsd::string) == sizeof(char*) + 2 * sizeof(hsd::usize));
+    static_assert(sizeof(hsd::unique_ptr<int, hsd::buffered_allocator>) > sizeof(int*));
+
+    {
+        auto arr = hsd::make_unique<counted[]>(4);
+
+        for (hsd::i32 i = 0; i < 4; i++)
+            arr.get()[i].id = i;
+    }
+
+    assert(destroyed == 4);
+
     hsd::uchar buf[256]{};
     hsd::buffered_allocator<int> alloc{buf, 256};
 
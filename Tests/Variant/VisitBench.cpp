@@ -0,0 +1,173 @@
+#include <Variant.hpp>
+#include <Time.hpp>
+#include <Vector.hpp>
+#include <Io.hpp>
+
+#include <cassert>
+#include <string.h>
+
+using namespace hsd::format_literals;
+
+// Alternatives differ in size, in where their value sits and
+// in what the visitor does with it, so that the compiler can't
+// fold the dispatch into a single load
+template <hsd::usize I>
+struct alt
+{
+    static constexpr hsd::u64 factor = I * 2 + 1;
+    static constexpr hsd::usize last = I % 4;
+
+    hsd::u64 words[last + 1];
+};
+
+template <hsd::usize... Is>
+static auto make_alts(hsd::index_sequence<Is...>) -> hsd::variant<alt<Is>...>;
+
+template <hsd::usize N>
+using variant_of = decltype(make_alts(hsd::make_index_sequence<N>{}));
+
+// The variant's storage and visit before the jump table: a union
+// nested once per alternative, with one compare per level
+template <typename... Ts>
+union baseline_storage;
+
+template <typename T>
+union baseline_storage<T>
+{
+    T value_first;
+};
+
+template <typename T, typename... Rest>
+union baseline_storage<T, Rest...>
+{
+    T value_first;
+    baseline_storage<Rest...> storage_rest;
+};
+
+template <typename Func, typename T, typename... Rest>
+static hsd::u64 baseline_visit(baseline_storage<T, Rest...>& storage, hsd::usize id, Func& func)
+{
+    if (id == 0)
+    {
+        return func(storage.value_first);
+    }
+    else if constexpr (sizeof...(Rest) != 0)
+    {
+        return baseline_visit(storage.storage_rest, id - 1, func);
+    }
+    else
+    {
+        return func(storage.value_first);
+    }
+}
+
+template <typename... Ts>
+struct baseline_variant
+{
+    baseline_storage<Ts...> storage;
+    hsd::usize index;
+};
+
+template <hsd::usize... Is>
+static auto make_baseline(hsd::index_sequence<Is...>) -> baseline_variant<alt<Is>...>;
+
+template <hsd::usize N>
+using baseline_of = decltype(make_baseline(hsd::make_index_sequence<N>{}));
+
+template <hsd::usize I, hsd::usize N>
+static void fill(hsd::vector<variant_of<N>>& values, 
+    hsd::vector<baseline_of<N>>& baseline, hsd::usize index, hsd::u64 seed)
+{
+    if constexpr (I < N)
+    {
+        if (index == I)
+        {
+            alt<I> value{};
+            value.words[alt<I>::last] = seed;
+            values.emplace_back(value);
+
+            baseline_of<N> old;
+            old.index = I;
+            memcpy(&old.storage, &value, sizeof(value));
+            baseline.push_back(old);
+            return;
+        }
+
+        fill<I + 1, N>(values, baseline, index, seed);
+    }
+}
+
+template <hsd::usize N>
+static void bench()
+{
+    constexpr hsd::usize count = 1 << 16;
+    constexpr hsd::usize rounds = 100;
+
+    hsd::vector<variant_of<N>> values;
+    hsd::vector<baseline_of<N>> baseline;
+    hsd::u64 state = 0x9E3779B97F4A7C15ull;
+
+    for (hsd::usize i = 0; i < count; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        fill<0, N>(values, baseline, state % N, i);
+    }
+
+    auto visitor = [](auto& value) -> hsd::u64 {
+        using type = hsd::remove_cvref_t<decltype(value)>;
+        return value.words[type::last] * type::factor;
+    };
+
+    auto run = [&](const char* name, auto& variants, auto&& dispatch) {
+        hsd::precise_clock clock;
+        hsd::u64 sum = 0;
+
+        for (hsd::usize round = 0; round < rounds; round++)
+        {
+            for (auto& value : variants)
+                sum += dispatch(value);
+        }
+
+        hsd::println(
+            "{} alternatives, {}: {}ns per visit"_fmt, N, name,
+            static_cast<hsd::f64>(clock.restart().to_nanoseconds()) / (count * rounds)
+        );
+
+        return sum;
+    };
+
+    auto sum = run("hsd::visit", values, [&](auto& value) { return hsd::visit(visitor, value); });
+    auto baseline_sum = run("baseline", baseline, [&](auto& value) {
+        return baseline_visit(value.storage, value.index, visitor);
+    });
+
+    assert(sum == baseline_sum);
+}
+
+int main()
+{
+    // Trivially copyable alternatives keep the variant trivially copyable
+    static_assert(std::is_trivially_copyable_v<hsd::variant<hsd::i32, hsd::f32, alt<0>>>);
+    static_assert(std::is_trivially_destructible_v<variant_of<32>>);
+
+    {
+        hsd::variant<hsd::i32, hsd::f64> first = 2.5;
+        hsd::variant<hsd::i32, hsd::f64, char> second = 'x';
+        const hsd::variant<hsd::i32, hsd::f64> third = 4;
+
+        auto result = hsd::visit([](auto a, auto b, auto c) {
+            return static_cast<hsd::f64>(a) + static_cast<hsd::f64>(b) + static_cast<hsd::f64>(c);
+        }, first, second, third);
+
+        assert(result == 2.5 + 'x' + 4);
+        assert(first.visit([](auto value) { return static_cast<hsd::i32>(value); }) == 2);
+        assert(third.visit([](auto value) { return static_cast<hsd::i32>(value); }) == 4);
+    }
+
+    bench<2>();
+    bench<8>();
+    bench<16>();
+    bench<32>();
+}
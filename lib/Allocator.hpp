@@ -368,31 +368,46 @@ namespace hsd
         #endif
     };
 
+    namespace allocator_detail
+    {
+        // Anything up to this alignment comes from plain operator new,
+        // which frees blocks of any size, only the over-aligned types
+        // need the alignment to be passed along
+        template <typename T>
+        static constexpr bool over_aligned = (
+            alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__
+        );
+
+        // Whether memory allocated for a From can be freed as a To,
+        // both have to go through the same operator delete
+        template <typename From, typename To>
+        static constexpr bool can_free_as = (
+            (!over_aligned<From> && !over_aligned<To>) ||
+            alignof(From) == alignof(To)
+        );
+    } // namespace allocator_detail
+
+    // Holds no state, so containers using it don't grow because of it.
+    // Memory is released without a size, so an allocator converted
+    // from the one of a derived type (unique_ptr<Base> taking over a
+    // unique_ptr<Derived>) still frees the whole block, as long as
+    // both types are allocated the same way (can_free_as)
     template <typename T>
     class allocator
     {
-    private:
-        usize _type_size = sizeof(T);
-        usize _alignment = alignof(T);
-        
-        template <typename U>
-        friend class allocator;
-
     public:
         using pointer_type = T*;
         using value_type = T;
         inline allocator() = default;
 
         template <typename U = T>
-        inline allocator(const allocator<U>& other)
-            : _type_size{other._type_size}, _alignment{other._alignment}
+        inline allocator(const allocator<U>&)
         {}
 
         template <typename U = T>
         inline allocator& operator=(const allocator<U>& rhs)
         {
-            _type_size = rhs._type_size;
-            _alignment = rhs._alignment;
+            *this = allocator{rhs};
             return *this;
         }
 
@@ -405,15 +420,20 @@ namespace hsd
             }
             else
             {
-                #ifdef __cpp_aligned_new
-                T* _result = static_cast<pointer_type>(::operator new(
-                    size * _type_size, static_cast<std::align_val_t>(_alignment), std::nothrow
-                ));
-                #else
-                T* _result = static_cast<pointer_type>(
-                    ::operator new(size * _type_size, std::nothrow)
-                );
-                #endif
+                T* _result = nullptr;
+
+                if constexpr (allocator_detail::over_aligned<T>)
+                {
+                    _result = static_cast<pointer_type>(::operator new(
+                        size * sizeof(T), static_cast<std::align_val_t>(alignof(T)), std::nothrow
+                    ));
+                }
+                else
+                {
+                    _result = static_cast<pointer_type>(
+                        ::operator new(size * sizeof(T), std::nothrow)
+                    );
+                }
 
                 if (_result == nullptr)
                 {
@@ -435,11 +455,14 @@ namespace hsd
             }
             else
             {
-                #ifdef __cpp_sized_deallocation
-                ::operator delete(ptr, size * _type_size, static_cast<std::align_val_t>(_alignment));
-                #else
-                ::operator delete(ptr, static_cast<std::align_val_t>(_alignment));
-                #endif
+                if constexpr (allocator_detail::over_aligned<T>)
+                {
+                    ::operator delete(ptr, static_cast<std::align_val_t>(alignof(T)));
+                }
+                else
+                {
+                    ::operator delete(ptr);
+                }
 
                 return {};
             }
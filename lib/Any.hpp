@@ -2,6 +2,8 @@
 
 #include "UniquePtr.hpp"
 
+#include <new>
+
 namespace hsd
 {
     struct bad_any_cast
@@ -13,59 +15,188 @@ namespace hsd
         }
     };
 
-    class _any_base 
+    namespace any_detail
     {
-    public:
-        virtual ~_any_base() = default;
-        virtual hsd::unique_ptr<_any_base> clone() const = 0;
-    };
+        // Every type gets its own static, its address is the type's id,
+        // so checking a cast is one pointer comparison, no RTTI involved
+        template <typename T>
+        struct type_tag
+        {
+            static constexpr char id = 0;
+        };
 
-    template <CopyConstructible T>
-    class _any_derived : public _any_base 
-    {
-        T _value;
-        friend class any;
+        template <typename T>
+        static constexpr const void* type_id = &type_tag<remove_cvref_t<T>>::id;
 
-    public:
-        inline _any_derived(T value) 
-            : _value(move(value)) 
-        {}
+        // Values up to this size live inside the any itself
+        static constexpr usize small_size = 3 * sizeof(void*);
 
-        hsd::unique_ptr<_any_base> clone() const override 
+        template <typename T>
+        static constexpr bool stored_inline = (
+            sizeof(T) <= small_size &&
+            alignof(T) <= alignof(void*) &&
+            std::is_nothrow_move_constructible_v<T>
+        );
+
+        struct vtable
         {
-            return hsd::make_unique<_any_derived>(_value);
-        }
-    };
+            const void* type;
+            void* (*get)(void*);
+            void (*copy)(void* dest, const void* src);
+            void (*move)(void* dest, void* src);
+            void (*destroy)(void*);
+        };
+
+        template <typename T>
+        struct ops
+        {
+            static inline void* get(void* storage)
+            {
+                if constexpr (stored_inline<T>)
+                {
+                    return std::launder(reinterpret_cast<T*>(storage));
+                }
+                else
+                {
+                    return *static_cast<T**>(storage);
+                }
+            }
+
+            static inline void copy(void* dest, const void* src)
+            {
+                auto& _value = *static_cast<T*>(get(const_cast<void*>(src)));
+
+                if constexpr (stored_inline<T>)
+                {
+                    ::new (dest) T(_value);
+                }
+                else
+                {
+                    *static_cast<T**>(dest) = new T(_value);
+                }
+            }
+
+            // Leaves src empty, it won't be destroyed afterwards
+            static inline void move(void* dest, void* src)
+            {
+                if constexpr (stored_inline<T>)
+                {
+                    auto* _value = static_cast<T*>(get(src));
+                    ::new (dest) T(hsd::move(*_value));
+                    _value->~T();
+                }
+                else
+                {
+                    *static_cast<T**>(dest) = static_cast<T*>(get(src));
+                }
+            }
+
+            static inline void destroy(void* storage)
+            {
+                if constexpr (stored_inline<T>)
+                {
+                    static_cast<T*>(get(storage))->~T();
+                }
+                else
+                {
+                    delete static_cast<T*>(get(storage));
+                }
+            }
+
+            template <typename... Args>
+            static inline void create(void* storage, Args&&... args)
+            {
+                if constexpr (stored_inline<T>)
+                {
+                    ::new (storage) T(forward<Args>(args)...);
+                }
+                else
+                {
+                    *static_cast<T**>(storage) = new T(forward<Args>(args)...);
+                }
+            }
+
+            static constexpr vtable table = {
+                type_id<T>, &get, &copy, &move, &destroy
+            };
+        };
+    } // namespace any_detail
 
+    // Holds a value of any copyable type. Small values that can be
+    // moved without throwing are kept inline, bigger ones on the heap
     class any
     {
     private:
-        hsd::unique_ptr<_any_base> _data = nullptr;
+        const any_detail::vtable* _vtable = nullptr;
+        alignas(void*) uchar _storage[any_detail::small_size];
+
+        template <typename T>
+        inline T* _get_if() const
+        {
+            if (_vtable == nullptr || _vtable->type != any_detail::type_id<T>)
+                return nullptr;
+
+            return static_cast<T*>(_vtable->get(const_cast<uchar*>(_storage)));
+        }
+
+        inline void _move_from(any& other)
+        {
+            if (other._vtable != nullptr)
+            {
+                other._vtable->move(_storage, other._storage);
+                _vtable = exchange(other._vtable, nullptr);
+            }
+        }
 
     public:
         inline any() noexcept = default;
 
         template <CopyConstructible T>
+        requires (!is_same<T, any>::value)
         inline any(T other)
         {
-            _data = hsd::make_unique<_any_derived<T>>(move(other));
+            emplace<T>(move(other));
         }
 
         inline any(const any& other)
         {
-            _data = other._data->clone();
+            if (other._vtable != nullptr)
+            {
+                other._vtable->copy(_storage, other._storage);
+                _vtable = other._vtable;
+            }
         }
 
         inline any(any&& other)
         {
-            this->swap(other);
+            _move_from(other);
         }
 
-        inline ~any() = default;
+        inline ~any()
+        {
+            reset();
+        }
+
+        inline any& operator=(const any& rhs)
+        {
+            if (this != &rhs)
+            {
+                any _tmp{rhs};
+                reset();
+                _move_from(_tmp);
+            }
+
+            return *this;
+        }
 
-        inline any& operator=(any rhs)
+        inline any& operator=(any&& rhs)
         {
-            this->swap(rhs);
+            if (this != &rhs)
+            {
+                reset();
+                _move_from(rhs);
+            }
+
             return *this;
         }
 
@@ -75,9 +206,9 @@ namespace hsd
         {
             using type = typename remove_pointer<T>::type;
 
-            if (auto* p_base = dynamic_cast<_any_derived<type>*>(_data.get()))
+            if (auto* _value = _get_if<type>())
             {
-                return reference<T>{p_base->_value};
+                return reference<T>{*_value};
             }
             else
             {
@@ -88,21 +219,20 @@ namespace hsd
         template <typename T>
         inline T* cast_if() const
         {
-            if (auto* p_base = dynamic_cast<_any_derived<T>*>(_data.get()))
-                return &p_base->_value;
-
-            return nullptr;
+            return _get_if<T>();
         }
 
         template <typename T>
         inline bool holds_type() const
         {
-            return dynamic_cast<_any_derived<T>*>(_data.get());
+            return _vtable != nullptr && _vtable->type == any_detail::type_id<T>;
         }
 
         inline void swap(any& other) noexcept
         {
-            hsd::swap(_data, other._data);
+            any _tmp{move(other)};
+            other._move_from(*this);
+            _move_from(_tmp);
         }
 
         friend void swap(any& lhs, any& rhs) noexcept
@@ -113,17 +243,22 @@ namespace hsd
         template < typename T, typename... Args >
         inline void emplace(Args&&... args)
         {
-            _data = hsd::make_unique<_any_derived<T>>(T(forward<Args>(args)...));
+            reset();
+            any_detail::ops<T>::create(_storage, forward<Args>(args)...);
+            _vtable = &any_detail::ops<T>::table;
         }
 
         inline bool has_value() const
         {
-            return _data != nullptr;
+            return _vtable != nullptr;
         }
 
         inline void reset()
         {
-            _data = nullptr;
+            if (_vtable != nullptr)
+            {
+                exchange(_vtable, nullptr)->destroy(_storage);
+            }
         }
     };
 }
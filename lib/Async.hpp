@@ -0,0 +1,298 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+
+namespace hsd
+{
+    enum class launch
+    {
+        async,      // on a new thread of its own
+        deferred,   // lazily, on the first wait or get
+        pool        // on thread_pool::global()
+    };
+
+    namespace async_detail
+    {
+        template <typename T, typename Err>
+        using res_type = future_detail::promise_data_res_type<T, Err>;
+
+        // The promises of when_all and when_any start out with the
+        // error their type can build, a message or a default one
+        template <typename T, typename Err>
+        inline promise<T, Err> make_promise()
+        {
+            if constexpr (IsVoid<Err> || Constructible<Err, const char*>)
+            {
+                return {};
+            }
+            else
+            {
+                return promise<T, Err>{Err{}};
+            }
+        }
+
+        template <typename T, typename Err>
+        struct all_state
+        {
+            hsd::vector<option<T>> _values;
+            atomic_usize _remaining;
+            atomic_bool _failed = false;
+            promise<hsd::vector<T>, Err> _promise = make_promise<hsd::vector<T>, Err>();
+
+            // One extra count is held by when_all itself
+            inline all_state(usize count)
+                : _remaining{count + 1}
+            {
+                _values.resize(count);
+            }
+
+            inline void finish()
+            {
+                if (_remaining.fetch_sub(1) != 1)
+                    return;
+
+                if (_failed.load() == false)
+                {
+                    hsd::vector<T> _result;
+                    _result.reserve(_values.size());
+
+                    for (auto& _value : _values)
+                    {
+                        _result.emplace_back(_value.unwrap());
+                    }
+
+                    _promise.set_value(move(_result));
+                }
+
+                delete this;
+            }
+        };
+
+        template <typename Err>
+        struct all_state<void, Err>
+        {
+            atomic_usize _remaining;
+            atomic_bool _failed = false;
+            promise<void, Err> _promise = make_promise<void, Err>();
+
+            inline all_state(usize count)
+                : _remaining{count + 1}
+            {}
+
+            inline void finish()
+            {
+                if (_remaining.fetch_sub(1) != 1)
+                    return;
+
+                if (_failed.load() == false)
+                {
+                    _promise.set_value();
+                }
+
+                delete this;
+            }
+        };
+
+        template <typename T, typename Err>
+        struct all_continuation final
+            : future_detail::continuation<res_type<T, Err>>
+        {
+            all_state<T, Err>* _state;
+            usize _index;
+
+            inline all_continuation(all_state<T, Err>* state, usize index)
+                : _state{state}, _index{index}
+            {}
+
+            virtual void run(res_type<T, Err>& result) override
+            {
+                if (result.is_ok() == false)
+                {
+                    // Only the first error gets through
+                    if (_state->_failed.exchange(true) == false)
+                    {
+                        future_detail::forward_error(_state->_promise, result);
+                    }
+                }
+                else if constexpr (!IsVoid<T>)
+                {
+                    _state->_values[_index] = result.unwrap();
+                }
+
+                _state->finish();
+            }
+        };
+
+        template <typename T>
+        struct any_value
+        {
+            using type = pair<usize, T>;
+        };
+
+        template <>
+        struct any_value<void>
+        {
+            using type = usize;
+        };
+
+        template <typename T, typename Err>
+        struct any_state
+        {
+            atomic_usize _remaining;
+            atomic_bool _done = false;
+            promise<typename any_value<T>::type, Err> _promise =
+                make_promise<typename any_value<T>::type, Err>();
+
+            inline any_state(usize count)
+                : _remaining{count + 1}
+            {}
+
+            inline void finish()
+            {
+                if (_remaining.fetch_sub(1) == 1)
+                {
+                    delete this;
+                }
+            }
+        };
+
+        template <typename T, typename Err>
+        struct any_continuation final
+            : future_detail::continuation<res_type<T, Err>>
+        {
+            any_state<T, Err>* _state;
+            usize _index;
+
+            inline any_continuation(any_state<T, Err>* state, usize index)
+                : _state{state}, _index{index}
+            {}
+
+            virtual void run(res_type<T, Err>& result) override
+            {
+                if (_state->_done.exchange(true) == false)
+                {
+                    if (result.is_ok() == false)
+                    {
+                        future_detail::forward_error(_state->_promise, result);
+                    }
+                    else if constexpr (IsVoid<T>)
+                    {
+                        _state->_promise.set_value(_index);
+                    }
+                    else
+                    {
+                        _state->_promise.set_value(
+                            pair<usize, T>{_index, result.unwrap()}
+                        );
+                    }
+                }
+
+                _state->finish();
+            }
+        };
+    } // namespace async_detail
+
+    template <typename Func, typename... Args>
+    requires (Invocable<Func, Args...>)
+    inline auto async(launch policy, Func&& func, Args&&... args)
+    {
+        return future_detail::package_call(
+            [policy](auto&& task, auto& fut)
+            {
+                using task_type = decay_t<decltype(task)>;
+
+                switch (policy)
+                {
+                    case launch::async:
+                    {
+                        thread{move(task)}.detach().unwrap();
+                        break;
+                    }
+                    case launch::deferred:
+                    {
+                        future_detail::future_access::defer(
+                            fut, new future_detail::
+                                deferred_call_impl<task_type>{move(task)}
+                        );
+                        break;
+                    }
+                    default:
+                    {
+                        thread_pool::global().execute(move(task));
+                        break;
+                    }
+                }
+            },
+            forward<Func>(func), forward<Args>(args)...
+        );
+    }
+
+    template <typename Func, typename... Args>
+    requires (!IsSame<decay_t<Func>, launch> && Invocable<Func, Args...>)
+    inline auto async(Func&& func, Args&&... args)
+    {
+        return async(launch::pool, forward<Func>(func), forward<Args>(args)...);
+    }
+
+    // Ready once every future is, with all of their values in order,
+    // or with the first error as soon as any of them fails
+    template <typename T, typename Err>
+    inline auto when_all(hsd::vector<future<T, Err>>&& futures)
+    {
+        using value_type = conditional_t<IsVoid<T>, void, hsd::vector<T>>;
+        auto* _state = new async_detail::all_state<T, Err>{futures.size()};
+        future<value_type, Err> _result = _state->_promise.get_future();
+
+        for (usize _index = 0; _index < futures.size(); _index++)
+        {
+            future_detail::future_access::attach(
+                futures[_index],
+                new async_detail::all_continuation<T, Err>{_state, _index}
+            );
+        }
+
+        // Dropping the extra count, an empty set is ready right away
+        _state->finish();
+        return _result;
+    }
+
+    // Ready with the index (and the value) of whichever future is
+    // ready first, or with its error if that one failed. An empty
+    // input fails right away, with a default Err if it can't hold
+    // a message
+    template <typename T, typename Err>
+    inline auto when_any(hsd::vector<future<T, Err>>&& futures)
+    {
+        using value_type = typename async_detail::any_value<T>::type;
+        auto* _state = new async_detail::any_state<T, Err>{futures.size()};
+        future<value_type, Err> _result = _state->_promise.get_future();
+
+        for (usize _index = 0; _index < futures.size(); _index++)
+        {
+            future_detail::future_access::attach(
+                futures[_index],
+                new async_detail::any_continuation<T, Err>{_state, _index}
+            );
+        }
+
+        // Nothing could ever make it ready, so it fails right away
+        if (futures.size() == 0)
+        {
+            if constexpr (IsVoid<Err>)
+            {
+                _state->_promise.set_error();
+            }
+            else if constexpr (Constructible<Err, const char*>)
+            {
+                _state->_promise.set_error(Err{"when_any: no futures to wait on"});
+            }
+            else
+            {
+                _state->_promise.set_error(Err{});
+            }
+        }
+
+        _state->finish();
+        return _result;
+    }
+} // namespace hsd
@@ -24,6 +24,21 @@ namespace hsd
     static constexpr auto memory_order_acq_rel = memory_order::acq_rel;
     static constexpr auto memory_order_seq_cst = memory_order::seq_cst;
 
+    // Distance two objects need to be apart to avoid false sharing
+    static constexpr usize hardware_destructive_interference_size = 64;
+    static constexpr usize hardware_constructive_interference_size = 64;
+
+    // Tells the core that the caller is busy waiting, so that it
+    // can back off and leave resources to its sibling hyper-thread
+    static inline void cpu_relax()
+    {
+        #if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+        #elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield" ::: "memory");
+        #endif
+    }
+
     namespace atomic_detail
     {
         template <typename T>
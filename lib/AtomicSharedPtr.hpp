@@ -0,0 +1,150 @@
+#pragma once
+
+#include "SharedPtr.hpp"
+#include "Reclamation.hpp"
+
+namespace hsd
+{
+    // A safe_shared_ptr that can be read and replaced from many threads
+    // at once. The current value sits in a small heap node, readers pin
+    // the epoch domain just long enough to copy it out, writers swap in
+    // a new node and retire the old one, so a reader never holds up a
+    // writer and a writer never waits for readers to finish. Writers
+    // push the epoch on right away, so a replaced value (and whatever
+    // weak_ptr points to it) goes before the write returns unless a
+    // reader is still pinned, then it goes with a later write or collect
+    template < typename T, template <typename> typename Allocator = allocator >
+    class atomic_shared_ptr
+    {
+    public:
+        using shared_type = safe_shared_ptr<T, Allocator>;
+
+    private:
+        struct node
+        {
+            shared_type value;
+        };
+
+        atomic<node*> _node = nullptr;
+        epoch_domain* _domain;
+
+        static inline node* _make_node(shared_type&& value)
+        {
+            if (value == nullptr)
+                return nullptr;
+
+            return new node{move(value)};
+        }
+
+        inline void _retire(node* old)
+        {
+            if (old != nullptr)
+            {
+                _domain->retire(old);
+            }
+        }
+
+        // Two steps of the epoch free what was retired before them,
+        // writes are rare enough next to reads to pay for it
+        inline void _reclaim()
+        {
+            _domain->collect();
+            _domain->collect();
+        }
+
+        inline bool _compare_exchange(shared_type& expected, shared_type&& desired)
+        {
+            auto _guard = _domain->pin();
+            auto* _current = _node.load(memory_order_acquire);
+            auto* _current_ptr = _current == nullptr ? nullptr : _current->value.get();
+
+            if (_current_ptr != expected.get())
+            {
+                expected = _current == nullptr ? shared_type{} : _current->value;
+                return false;
+            }
+
+            // Nodes are never reused while we're pinned, so
+            // comparing their addresses can't suffer from ABA
+            auto* _desired = _make_node(move(desired));
+
+            if (_node.compare_exchange_strong(
+                _current, _desired, memory_order_acq_rel, memory_order_acquire))
+            {
+                _retire(_current);
+                return true;
+            }
+
+            expected = _current == nullptr ? shared_type{} : _current->value;
+            delete _desired;
+            return false;
+        }
+
+    public:
+        inline atomic_shared_ptr(epoch_domain& domain = epoch_domain::global())
+            : _domain{&domain}
+        {}
+
+        inline atomic_shared_ptr(shared_type value, epoch_domain& domain = epoch_domain::global())
+            : _node{_make_node(move(value))}, _domain{&domain}
+        {}
+
+        inline atomic_shared_ptr(const atomic_shared_ptr&) = delete;
+        inline atomic_shared_ptr& operator=(const atomic_shared_ptr&) = delete;
+
+        // Nobody else may be using it anymore
+        inline ~atomic_shared_ptr()
+        {
+            delete _node.load(memory_order_relaxed);
+        }
+
+        inline shared_type load() const
+        {
+            auto _guard = _domain->pin();
+            auto* _current = _node.load(memory_order_acquire);
+
+            // The node can't be freed while we're pinned, and it
+            // holds a reference, so the count can't drop to zero
+            return _current == nullptr ? shared_type{} : _current->value;
+        }
+
+        inline void store(shared_type value)
+        {
+            _retire(_node.exchange(_make_node(move(value)), memory_order_acq_rel));
+            _reclaim();
+        }
+
+        inline shared_type exchange(shared_type value)
+        {
+            shared_type _result;
+
+            {
+                auto _guard = _domain->pin();
+                auto* _old = _node.exchange(_make_node(move(value)), memory_order_acq_rel);
+
+                // Readers may still be copying from the old node,
+                // so take a new reference instead of moving out
+                _result = _old == nullptr ? shared_type{} : _old->value;
+                _retire(_old);
+            }
+
+            // Not pinned anymore, or the epoch couldn't move on
+            _reclaim();
+            return _result;
+        }
+
+        // Replaces the value with desired if it still owns the same
+        // object as expected, otherwise loads the current one into
+        // expected. Returns whether desired was stored
+        inline bool compare_exchange(shared_type& expected, shared_type desired)
+        {
+            if (_compare_exchange(expected, move(desired)))
+            {
+                _reclaim();
+                return true;
+            }
+
+            return false;
+        }
+    };
+} // namespace hsd
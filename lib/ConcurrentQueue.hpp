@@ -0,0 +1,461 @@
+#pragma once
+
+#include "Lock.hpp"
+#include "Span.hpp"
+
+#include <new>
+
+namespace hsd
+{
+    namespace queue_detail
+    {
+        static inline usize round_up_pow2(usize value)
+        {
+            usize _result = 2;
+
+            while (_result < value)
+            {
+                _result <<= 1;
+            }
+
+            return _result;
+        }
+
+        // Lets threads sleep until the other side made progress, the
+        // fast paths only pay for a fence and a load while nobody sleeps.
+        // A notify wakes everybody and clears the flag, so that a burst
+        // of notifies costs a single wake up, not one per operation
+        class event_count
+        {
+        private:
+            alignas(hardware_destructive_interference_size) atomic_u32 _epoch = 0;
+            atomic_u32 _has_sleepers = 0;
+            static inline futex_lock _waiter{};
+
+        public:
+            inline u32 prepare_wait()
+            {
+                u32 _current = _epoch.load(memory_order_acquire);
+                _has_sleepers.exchange(1, memory_order_seq_cst);
+                return _current;
+            }
+
+            inline void wait(u32 epoch)
+            {
+                _waiter.wait_on(reinterpret_cast<u32&>(_epoch), epoch);
+            }
+
+            inline void notify()
+            {
+                // Pairs with the exchange in prepare_wait, either the
+                // sleeper sees our change or we see the sleeper
+                atomic_thread_fence(memory_order_seq_cst);
+
+                if (_has_sleepers.load(memory_order_relaxed) != 0 &&
+                    _has_sleepers.exchange(0, memory_order_relaxed) != 0)
+                {
+                    _epoch.fetch_add(1, memory_order_release);
+                    _waiter.wake_up(reinterpret_cast<u32&>(_epoch));
+                }
+            }
+        };
+    } // namespace queue_detail
+
+    // Bounded multi-producer multi-consumer queue after Dmitry Vyukov's
+    // design: every slot carries a sequence number telling whether it
+    // is ready to be written or read for the current lap, so producers
+    // and consumers only ever contend on their own index
+    template <typename T>
+    class mpmc_queue
+    {
+    private:
+        struct alignas(hardware_destructive_interference_size) slot
+        {
+            atomic_usize sequence;
+            alignas(T) uchar storage[sizeof(T)];
+
+            inline T* get()
+            {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+        };
+
+        slot* _slots;
+        usize _mask;
+
+        alignas(hardware_destructive_interference_size) atomic_usize _tail = 0;
+        alignas(hardware_destructive_interference_size) atomic_usize _head = 0;
+
+        queue_detail::event_count _not_empty;
+        queue_detail::event_count _not_full;
+
+        template <typename... Args>
+        inline bool _emplace(Args&&... args)
+        {
+            usize _pos = _tail.load(memory_order_relaxed);
+
+            while (true)
+            {
+                auto& _slot = _slots[_pos & _mask];
+                usize _seq = _slot.sequence.load(memory_order_acquire);
+                isize _diff = static_cast<isize>(_seq) - static_cast<isize>(_pos);
+
+                if (_diff == 0)
+                {
+                    if (_tail.compare_exchange_weak(
+                        _pos, _pos + 1, memory_order_relaxed, memory_order_relaxed))
+                    {
+                        new (_slot.storage) T{forward<Args>(args)...};
+                        _slot.sequence.store(_pos + 1, memory_order_release);
+                        return true;
+                    }
+                }
+                else if (_diff < 0)
+                {
+                    // The consumers haven't freed this slot yet, it's full
+                    return false;
+                }
+                else
+                {
+                    _pos = _tail.load(memory_order_relaxed);
+                }
+            }
+        }
+
+        inline option<T> _take()
+        {
+            usize _pos = _head.load(memory_order_relaxed);
+
+            while (true)
+            {
+                auto& _slot = _slots[_pos & _mask];
+                usize _seq = _slot.sequence.load(memory_order_acquire);
+                isize _diff = static_cast<isize>(_seq) - static_cast<isize>(_pos + 1);
+
+                if (_diff == 0)
+                {
+                    if (_head.compare_exchange_weak(
+                        _pos, _pos + 1, memory_order_relaxed, memory_order_relaxed))
+                    {
+                        T* _value = _slot.get();
+                        option<T> _result = move(*_value);
+                        _value->~T();
+
+                        _slot.sequence.store(_pos + _mask + 1, memory_order_release);
+                        return _result;
+                    }
+                }
+                else if (_diff < 0)
+                {
+                    return {};
+                }
+                else
+                {
+                    _pos = _head.load(memory_order_relaxed);
+                }
+            }
+        }
+
+    public:
+        // The capacity gets rounded up to a power of two
+        inline explicit mpmc_queue(usize capacity)
+            : _slots{new slot[queue_detail::round_up_pow2(capacity)]},
+            _mask{queue_detail::round_up_pow2(capacity) - 1}
+        {
+            for (usize _index = 0; _index <= _mask; _index++)
+            {
+                _slots[_index].sequence.store(_index, memory_order_relaxed);
+            }
+        }
+
+        inline mpmc_queue(const mpmc_queue&) = delete;
+        inline mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+        inline ~mpmc_queue()
+        {
+            while (_take().is_ok())
+                ;
+
+            delete[] _slots;
+        }
+
+        inline usize capacity() const
+        {
+            return _mask + 1;
+        }
+
+        // Only a snapshot, other threads may change it right away
+        inline usize size() const
+        {
+            usize _tl = _tail.load(memory_order_relaxed);
+            usize _hd = _head.load(memory_order_relaxed);
+            return _tl > _hd ? _tl - _hd : 0;
+        }
+
+        inline bool empty() const
+        {
+            return size() == 0;
+        }
+
+        // Fails without blocking when the queue is full
+        template <typename... Args>
+        requires (Constructible<T, Args...>)
+        inline bool try_emplace(Args&&... args)
+        {
+            if (_emplace(forward<Args>(args)...) == false)
+                return false;
+
+            _not_empty.notify();
+            return true;
+        }
+
+        inline bool try_push(const T& value)
+        {
+            return try_emplace(value);
+        }
+
+        inline bool try_push(T&& value)
+        {
+            return try_emplace(move(value));
+        }
+
+        // Returns none without blocking when the queue is empty
+        inline option<T> try_pop()
+        {
+            auto _result = _take();
+
+            if (_result.is_ok())
+            {
+                _not_full.notify();
+            }
+
+            return _result;
+        }
+
+        // Park on the futex while the queue is full
+        inline void push(const T& value)
+        {
+            _push_blocking(value);
+        }
+
+        inline void push(T&& value)
+        {
+            _push_blocking(move(value));
+        }
+
+        // Parks on the futex while the queue is empty
+        inline T pop()
+        {
+            while (true)
+            {
+                if (auto _value = try_pop(); _value.is_ok())
+                    return _value.unwrap();
+
+                u32 _epoch = _not_empty.prepare_wait();
+
+                if (auto _value = try_pop(); _value.is_ok())
+                    return _value.unwrap();
+
+                _not_empty.wait(_epoch);
+            }
+        }
+
+    private:
+        // A failed attempt leaves the value untouched, so it's
+        // safe to keep retrying with the same rvalue reference
+        template <typename U>
+        inline void _push_blocking(U&& value)
+        {
+            while (true)
+            {
+                if (try_emplace(forward<U>(value)))
+                    return;
+
+                u32 _epoch = _not_full.prepare_wait();
+
+                if (try_emplace(forward<U>(value)))
+                    return;
+
+                _not_full.wait(_epoch);
+            }
+        }
+    };
+
+    // Wait-free ring for exactly one producer and one consumer. Each
+    // side keeps a cached copy of the other side's index and only goes
+    // to the shared one when the cache says full (or empty), so in the
+    // steady state the two threads touch each other's lines rarely
+    template <typename T>
+    class spsc_queue
+    {
+    private:
+        struct slot
+        {
+            alignas(T) uchar storage[sizeof(T)];
+
+            inline T* get()
+            {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+        };
+
+        slot* _slots;
+        usize _mask;
+
+        // Written by the producer
+        alignas(hardware_destructive_interference_size) atomic_usize _tail = 0;
+        usize _head_cache = 0;
+
+        // Written by the consumer
+        alignas(hardware_destructive_interference_size) atomic_usize _head = 0;
+        usize _tail_cache = 0;
+
+        // Free slots as the producer sees them, refreshing
+        // the cached head only if fewer than wanted are left
+        inline usize _writable(usize tail, usize wanted)
+        {
+            usize _free = capacity() - (tail - _head_cache);
+
+            if (_free < wanted)
+            {
+                _head_cache = _head.load(memory_order_acquire);
+                _free = capacity() - (tail - _head_cache);
+            }
+
+            return _free;
+        }
+
+        inline usize _readable(usize head, usize wanted)
+        {
+            usize _ready = _tail_cache - head;
+
+            if (_ready < wanted)
+            {
+                _tail_cache = _tail.load(memory_order_acquire);
+                _ready = _tail_cache - head;
+            }
+
+            return _ready;
+        }
+
+    public:
+        // The capacity gets rounded up to a power of two
+        inline explicit spsc_queue(usize capacity)
+            : _slots{new slot[queue_detail::round_up_pow2(capacity)]},
+            _mask{queue_detail::round_up_pow2(capacity) - 1}
+        {}
+
+        inline spsc_queue(const spsc_queue&) = delete;
+        inline spsc_queue& operator=(const spsc_queue&) = delete;
+
+        inline ~spsc_queue()
+        {
+            usize _tl = _tail.load(memory_order_acquire);
+
+            for (usize _pos = _head.load(memory_order_relaxed); _pos != _tl; _pos++)
+            {
+                _slots[_pos & _mask].get()->~T();
+            }
+
+            delete[] _slots;
+        }
+
+        inline usize capacity() const
+        {
+            return _mask + 1;
+        }
+
+        // Only a snapshot, other threads may change it right away
+        inline usize size() const
+        {
+            return _tail.load(memory_order_acquire) - _head.load(memory_order_acquire);
+        }
+
+        inline bool empty() const
+        {
+            return size() == 0;
+        }
+
+        // Producer only
+        template <typename... Args>
+        requires (Constructible<T, Args...>)
+        inline bool try_emplace(Args&&... args)
+        {
+            usize _tl = _tail.load(memory_order_relaxed);
+
+            if (_writable(_tl, 1) == 0)
+                return false;
+
+            new (_slots[_tl & _mask].storage) T{forward<Args>(args)...};
+            _tail.store(_tl + 1, memory_order_release);
+            return true;
+        }
+
+        inline bool try_push(const T& value)
+        {
+            return try_emplace(value);
+        }
+
+        inline bool try_push(T&& value)
+        {
+            return try_emplace(move(value));
+        }
+
+        // Producer only, copies as many values as fit
+        // with a single release, returns how many
+        template <typename Iter>
+        inline usize push_n(const span<Iter>& values)
+        {
+            usize _tl = _tail.load(memory_order_relaxed);
+            usize _count = _writable(_tl, values.size());
+            _count = _count < values.size() ? _count : values.size();
+
+            auto _iter = values.begin();
+
+            for (usize _index = 0; _index < _count; _index++, _iter++)
+            {
+                new (_slots[(_tl + _index) & _mask].storage) T{*_iter};
+            }
+
+            _tail.store(_tl + _count, memory_order_release);
+            return _count;
+        }
+
+        // Consumer only
+        inline option<T> try_pop()
+        {
+            usize _hd = _head.load(memory_order_relaxed);
+
+            if (_readable(_hd, 1) == 0)
+                return {};
+
+            T* _value = _slots[_hd & _mask].get();
+            option<T> _result = move(*_value);
+            _value->~T();
+
+            _head.store(_hd + 1, memory_order_release);
+            return _result;
+        }
+
+        // Consumer only, moves up to out.size() values into
+        // out with a single release, returns how many
+        inline usize pop_n(span<T*> out)
+        {
+            usize _hd = _head.load(memory_order_relaxed);
+            usize _count = _readable(_hd, out.size());
+            _count = _count < out.size() ? _count : out.size();
+
+            auto _iter = out.begin();
+
+            for (usize _index = 0; _index < _count; _index++, _iter++)
+            {
+                T* _value = _slots[(_hd + _index) & _mask].get();
+                *_iter = move(*_value);
+                _value->~T();
+            }
+
+            _head.store(_hd + _count, memory_order_release);
+            return _count;
+        }
+    };
+} // namespace hsd
@@ -0,0 +1,361 @@
+#pragma once
+
+#include "Lock.hpp"
+#include "Vector.hpp"
+#include "Hash.hpp"
+
+namespace hsd
+{
+    namespace cumap_detail
+    {
+        template <typename Key, typename T>
+        struct node
+        {
+            Key key;
+            T value;
+            usize hash;
+            node* next;
+        };
+
+        template <typename Lock, typename T>
+        class guarded_ref
+        {
+        private:
+            Lock _lock;
+            T* _value;
+
+        public:
+            inline guarded_ref(Lock&& lock, T* value)
+                : _lock{move(lock)}, _value{value}
+            {}
+
+            inline guarded_ref(guarded_ref&&) = default;
+            inline guarded_ref& operator=(guarded_ref&&) = default;
+
+            inline T& operator*() const
+            {
+                return *_value;
+            }
+
+            inline T* operator->() const
+            {
+                return _value;
+            }
+
+            inline T& get() const
+            {
+                return *_value;
+            }
+        };
+    } // namespace cumap_detail
+
+    // Hash map split into independently locked stripes, every stripe
+    // has its own shared_mutex and bucket array, so threads working on
+    // keys that land in different stripes never wait on each other
+    // and readers of the same stripe don't wait on each other either
+    template < typename Key, typename T, typename Hasher = hash<usize, Key>,
+        template <typename> typename Allocator = allocator >
+    class concurrent_unordered_map
+    {
+    private:
+        using node_type = cumap_detail::node<Key, T>;
+        using read_lock = shared_lock<shared_mutex>;
+        using write_lock = unique_lock<shared_mutex>;
+
+        static constexpr f64 _limit_ratio = 0.75;
+
+        struct alignas(hardware_destructive_interference_size) stripe
+        {
+            shared_mutex lock;
+            vector<node_type*, Allocator> buckets;
+            usize size = 0;
+        };
+
+        stripe* _stripes;
+        usize _stripe_bits;
+
+        static inline usize _hash(const Key& key)
+        {
+            return static_cast<usize>(Hasher::get_hash(key));
+        }
+
+        // The stripe takes the top bits of a multiplicative hash,
+        // the bucket inside of it takes the plain hash modulo
+        inline stripe& _stripe_for(usize hash) const
+        {
+            u64 _mixed = static_cast<u64>(hash) * 0x9E3779B97F4A7C15ull;
+            return _stripes[_stripe_bits == 0 ? 0 : _mixed >> (64 - _stripe_bits)];
+        }
+
+        static inline node_type** _slot_for(stripe& str, const Key& key, usize hash)
+        {
+            auto** _slot = &str.buckets[hash % str.buckets.size()];
+
+            while (*_slot != nullptr)
+            {
+                if ((*_slot)->hash == hash && (*_slot)->key == key)
+                    break;
+
+                _slot = &(*_slot)->next;
+            }
+
+            return _slot;
+        }
+
+        static inline void _rehash(stripe& str, usize new_size)
+        {
+            vector<node_type*, Allocator> _buckets;
+            _buckets.resize(new_size);
+
+            for (auto* _head : str.buckets)
+            {
+                while (_head != nullptr)
+                {
+                    auto* _next = _head->next;
+                    auto& _bucket = _buckets[_head->hash % new_size];
+                    _head->next = _bucket;
+                    _bucket = _head;
+                    _head = _next;
+                }
+            }
+
+            str.buckets = move(_buckets);
+        }
+
+        template <typename K, typename V>
+        static inline void _insert_new(
+            stripe& str, node_type** slot, K&& key, V&& value, usize hash)
+        {
+            Allocator<node_type> _alloc;
+            auto* _node = _alloc.allocate(1).unwrap();
+            new (_node) node_type{forward<K>(key), forward<V>(value), hash, nullptr};
+            *slot = _node;
+            str.size++;
+
+            if (static_cast<f64>(str.size) / static_cast<f64>(str.buckets.size()) >= _limit_ratio)
+            {
+                _rehash(str, str.buckets.size() * 2);
+            }
+        }
+
+        static inline void _destroy(node_type* node)
+        {
+            node->~node_type();
+            Allocator<node_type>{}.deallocate(node, 1).unwrap();
+        }
+
+        static inline void _clear(stripe& str)
+        {
+            for (auto*& _head : str.buckets)
+            {
+                while (_head != nullptr)
+                {
+                    _destroy(exchange(_head, _head->next));
+                }
+            }
+
+            str.size = 0;
+        }
+
+    public:
+        // The stripe count gets rounded up to a power of two
+        inline explicit concurrent_unordered_map(usize stripes = 64)
+        requires (DefaultConstructible<Allocator<node_type>>)
+            : _stripe_bits{0}
+        {
+            while ((usize{1} << _stripe_bits) < stripes)
+            {
+                _stripe_bits++;
+            }
+
+            _stripes = new stripe[usize{1} << _stripe_bits];
+
+            for (usize _index = 0; _index < (usize{1} << _stripe_bits); _index++)
+            {
+                _stripes[_index].buckets.resize(8);
+            }
+        }
+
+        inline concurrent_unordered_map(const concurrent_unordered_map&) = delete;
+        inline concurrent_unordered_map& operator=(const concurrent_unordered_map&) = delete;
+
+        inline ~concurrent_unordered_map()
+        {
+            for (usize _index = 0; _index < stripe_count(); _index++)
+            {
+                _clear(_stripes[_index]);
+            }
+
+            delete[] _stripes;
+        }
+
+        inline usize stripe_count() const
+        {
+            return usize{1} << _stripe_bits;
+        }
+
+        // Inserts the value, or overwrites it if the key is already
+        // there, returns true if the key was inserted
+        template <typename K, typename V>
+        requires (Constructible<Key, K> && Constructible<T, V>)
+        inline bool insert_or_assign(K&& key, V&& value)
+        {
+            usize _key_hash = _hash(key);
+            auto& _stripe = _stripe_for(_key_hash);
+            write_lock _lock{_stripe.lock};
+
+            auto** _slot = _slot_for(_stripe, key, _key_hash);
+
+            if (*_slot != nullptr)
+            {
+                (*_slot)->value = forward<V>(value);
+                return false;
+            }
+
+            _insert_new(_stripe, _slot, forward<K>(key), forward<V>(value), _key_hash);
+            return true;
+        }
+
+        // Inserts only if the key is missing, returns true if it was
+        template <typename K, typename V>
+        requires (Constructible<Key, K> && Constructible<T, V>)
+        inline bool insert(K&& key, V&& value)
+        {
+            usize _key_hash = _hash(key);
+            auto& _stripe = _stripe_for(_key_hash);
+            write_lock _lock{_stripe.lock};
+
+            auto** _slot = _slot_for(_stripe, key, _key_hash);
+
+            if (*_slot != nullptr)
+                return false;
+
+            _insert_new(_stripe, _slot, forward<K>(key), forward<V>(value), _key_hash);
+            return true;
+        }
+
+        // A copy of the value, taken under the stripe's shared lock
+        inline option<T> find(const Key& key) const
+        {
+            usize _key_hash = _hash(key);
+            auto& _stripe = _stripe_for(_key_hash);
+            read_lock _lock{_stripe.lock};
+
+            auto* _node = *_slot_for(_stripe, key, _key_hash);
+
+            if (_node == nullptr)
+                return {};
+
+            return _node->value;
+        }
+
+        // A reference that keeps the stripe's shared lock for as long
+        // as it lives, writers to the same stripe wait until it's gone
+        inline auto find_guarded(const Key& key) const
+            -> option<cumap_detail::guarded_ref<read_lock, const T>>
+        {
+            usize _key_hash = _hash(key);
+            auto& _stripe = _stripe_for(_key_hash);
+            read_lock _lock{_stripe.lock};
+
+            auto* _node = *_slot_for(_stripe, key, _key_hash);
+
+            if (_node == nullptr)
+                return {};
+
+            return cumap_detail::guarded_ref<read_lock, const T>{
+                move(_lock), &_node->value
+            };
+        }
+
+        inline bool contains(const Key& key) const
+        {
+            usize _key_hash = _hash(key);
+            auto& _stripe = _stripe_for(_key_hash);
+            read_lock _lock{_stripe.lock};
+
+            return *_slot_for(_stripe, key, _key_hash) != nullptr;
+        }
+
+        // Runs func on the value under the stripe's exclusive lock,
+        // returns false if the key isn't there
+        template <typename Func>
+        requires (Invocable<Func, T&>)
+        inline bool update(const Key& key, Func&& func)
+        {
+            usize _key_hash = _hash(key);
+            auto& _stripe = _stripe_for(_key_hash);
+            write_lock _lock{_stripe.lock};
+
+            auto* _node = *_slot_for(_stripe, key, _key_hash);
+
+            if (_node == nullptr)
+                return false;
+
+            func(_node->value);
+            return true;
+        }
+
+        inline bool erase(const Key& key)
+        {
+            usize _key_hash = _hash(key);
+            auto& _stripe = _stripe_for(_key_hash);
+            write_lock _lock{_stripe.lock};
+
+            auto** _slot = _slot_for(_stripe, key, _key_hash);
+
+            if (*_slot == nullptr)
+                return false;
+
+            _destroy(exchange(*_slot, (*_slot)->next));
+            _stripe.size--;
+            return true;
+        }
+
+        // Visits one stripe at a time under its shared lock, so it sees
+        // every element that was there for the whole walk, but changes
+        // made meanwhile to stripes it already went past are missed
+        template <typename Func>
+        requires (Invocable<Func, const Key&, const T&>)
+        inline void for_each(Func&& func) const
+        {
+            for (usize _index = 0; _index < stripe_count(); _index++)
+            {
+                auto& _stripe = _stripes[_index];
+                read_lock _lock{_stripe.lock};
+
+                for (auto* _node : _stripe.buckets)
+                {
+                    for (; _node != nullptr; _node = _node->next)
+                    {
+                        func(static_cast<const Key&>(_node->key),
+                            static_cast<const T&>(_node->value));
+                    }
+                }
+            }
+        }
+
+        // Same consistency as for_each
+        inline usize size() const
+        {
+            usize _result = 0;
+
+            for (usize _index = 0; _index < stripe_count(); _index++)
+            {
+                read_lock _lock{_stripes[_index].lock};
+                _result += _stripes[_index].size;
+            }
+
+            return _result;
+        }
+
+        inline void clear()
+        {
+            for (usize _index = 0; _index < stripe_count(); _index++)
+            {
+                write_lock _lock{_stripes[_index].lock};
+                _clear(_stripes[_index]);
+            }
+        }
+    };
+} // namespace hsd
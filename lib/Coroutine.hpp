@@ -0,0 +1,437 @@
+#pragma once
+
+#include "Async.hpp"
+
+#include <coroutine>
+
+namespace hsd
+{
+    namespace coroutine_detail
+    {
+        // Per-thread free lists of coroutine frames, bucketed by size,
+        // so that starting a task doesn't go to the heap every time
+        struct frame_cache
+        {
+            static constexpr usize granularity = 64;
+            static constexpr usize classes = 32;
+            static constexpr usize max_cached = 64;
+
+            struct node
+            {
+                node* next;
+            };
+
+            node* _lists[classes]{};
+            usize _counts[classes]{};
+
+            inline ~frame_cache()
+            {
+                for (auto* _list : _lists)
+                {
+                    while (_list != nullptr)
+                    {
+                        ::operator delete(exchange(_list, _list->next));
+                    }
+                }
+            }
+
+            static inline frame_cache& local()
+            {
+                static thread_local frame_cache _cache;
+                return _cache;
+            }
+        };
+    } // namespace coroutine_detail
+
+    // Allocator for coroutine frames, recycles freed frames
+    // through the cache of the thread that frees them
+    template <typename T>
+    class frame_allocator
+    {
+    private:
+        using cache_type = coroutine_detail::frame_cache;
+
+        static inline usize _size_class(usize bytes)
+        {
+            return (bytes + cache_type::granularity - 1) / cache_type::granularity;
+        }
+
+    public:
+        using pointer_type = T*;
+        using value_type = T;
+
+        inline frame_allocator() = default;
+
+        template <typename U = T>
+        inline frame_allocator(const frame_allocator<U>&)
+        {}
+
+        [[nodiscard]] inline auto allocate(usize size)
+            -> result<T*, allocator_detail::allocator_error>
+        {
+            if (size > limits<usize>::max / sizeof(T))
+            {
+                return allocator_detail::allocator_error{"Bad length for allocation"};
+            }
+
+            usize _class = _size_class(size * sizeof(T));
+            void* _result = nullptr;
+
+            if (_class < cache_type::classes)
+            {
+                auto& _cache = cache_type::local();
+
+                if (_cache._lists[_class] != nullptr)
+                {
+                    auto* _node = _cache._lists[_class];
+                    _cache._lists[_class] = _node->next;
+                    _cache._counts[_class]--;
+                    return static_cast<T*>(static_cast<void*>(_node));
+                }
+
+                _result = ::operator new(
+                    _class * cache_type::granularity, std::nothrow
+                );
+            }
+            else
+            {
+                _result = ::operator new(size * sizeof(T), std::nothrow);
+            }
+
+            if (_result == nullptr)
+            {
+                return allocator_detail::allocator_error{"No space left in RAM"};
+            }
+
+            return static_cast<T*>(_result);
+        }
+
+        inline auto deallocate(pointer_type ptr, usize size)
+            -> option_err<allocator_detail::allocator_error>
+        {
+            usize _class = _size_class(size * sizeof(T));
+
+            if (_class < cache_type::classes)
+            {
+                auto& _cache = cache_type::local();
+
+                if (_cache._counts[_class] < cache_type::max_cached)
+                {
+                    auto* _node = static_cast<cache_type::node*>(
+                        static_cast<void*>(ptr)
+                    );
+
+                    _node->next = _cache._lists[_class];
+                    _cache._lists[_class] = _node;
+                    _cache._counts[_class]++;
+                    return {};
+                }
+            }
+
+            ::operator delete(ptr);
+            return {};
+        }
+    };
+
+    template < typename T, typename Err = runtime_error,
+        template <typename> typename Allocator = frame_allocator >
+    class task;
+
+    namespace coroutine_detail
+    {
+        template <template <typename> typename Allocator>
+        struct frame_base
+        {
+            static inline void* operator new(usize size)
+            {
+                return Allocator<uchar>{}.allocate(size).unwrap();
+            }
+
+            static inline void operator delete(void* ptr, usize size)
+            {
+                Allocator<uchar>{}.deallocate(static_cast<uchar*>(ptr), size).unwrap();
+            }
+        };
+
+        // Fire and forget coroutine, frees itself when it's done
+        struct detached
+        {
+            struct promise_type : frame_base<frame_allocator>
+            {
+                inline detached get_return_object() { return {}; }
+                inline std::suspend_never initial_suspend() noexcept { return {}; }
+                inline std::suspend_never final_suspend() noexcept { return {}; }
+                inline void return_void() {}
+                inline void unhandled_exception() { abort(); }
+            };
+        };
+
+        template <typename Prom, typename Res>
+        static inline void fulfill(Prom& prom, Res& res)
+        {
+            if (res.is_ok() == false)
+            {
+                future_detail::forward_error(prom, res);
+            }
+            else if constexpr (IsVoid<typename future_detail::result_traits<Res>::value_type>)
+            {
+                prom.set_value();
+            }
+            else
+            {
+                prom.set_value(res.unwrap());
+            }
+        }
+
+        template <typename T, typename Err>
+        class future_awaiter
+        {
+        private:
+            using res_type = future_detail::promise_data_res_type<T, Err>;
+
+            struct resume_continuation final
+                : future_detail::continuation<res_type>
+            {
+                future_awaiter* _awaiter;
+
+                inline resume_continuation(future_awaiter* awaiter)
+                    : _awaiter{awaiter}
+                {}
+
+                virtual void run(res_type& result) override
+                {
+                    _awaiter->_result = move(result);
+
+                    // Whoever comes second resumes, see await_suspend
+                    if (_awaiter->_ready.exchange(true) == true)
+                    {
+                        _awaiter->_handle.resume();
+                    }
+                }
+            };
+
+            future<T, Err> _future;
+            option<res_type> _result{};
+            atomic_bool _ready = false;
+            std::coroutine_handle<> _handle{};
+
+        public:
+            inline future_awaiter(future<T, Err>&& fut)
+                : _future{move(fut)}
+            {}
+
+            inline bool await_ready() const
+            {
+                return false;
+            }
+
+            inline bool await_suspend(std::coroutine_handle<> handle)
+            {
+                _handle = handle;
+
+                future_detail::future_access::attach(
+                    _future, new resume_continuation{this}
+                );
+
+                // If the result was already there, don't suspend at all
+                return _ready.exchange(true) == false;
+            }
+
+            inline res_type await_resume()
+            {
+                return _result.unwrap();
+            }
+        };
+
+        class schedule_awaiter
+        {
+        private:
+            thread_pool* _pool;
+
+        public:
+            inline schedule_awaiter(thread_pool& pool)
+                : _pool{&pool}
+            {}
+
+            inline bool await_ready() const
+            {
+                return false;
+            }
+
+            inline void await_suspend(std::coroutine_handle<> handle)
+            {
+                _pool->execute([handle] { handle.resume(); });
+            }
+
+            inline void await_resume() {}
+        };
+    } // namespace coroutine_detail
+
+    // Lazily started coroutine: nothing runs until it is awaited,
+    // its co_return value is either a value or an error. For void
+    // tasks co_return {} to succeed or co_return an error to fail
+    template <typename T, typename Err, template <typename> typename Allocator>
+    class task
+    {
+    public:
+        using res_type = future_detail::promise_data_res_type<T, Err>;
+
+        struct promise_type : coroutine_detail::frame_base<Allocator>
+        {
+            option<res_type> _result{};
+            std::coroutine_handle<> _continuation = std::noop_coroutine();
+
+            struct final_awaiter
+            {
+                inline bool await_ready() const noexcept
+                {
+                    return false;
+                }
+
+                inline std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<promise_type> handle) noexcept
+                {
+                    return handle.promise()._continuation;
+                }
+
+                inline void await_resume() noexcept {}
+            };
+
+            inline task get_return_object()
+            {
+                return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            inline std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            inline final_awaiter final_suspend() noexcept
+            {
+                return {};
+            }
+
+            inline void return_value(res_type&& value)
+            {
+                _result = move(value);
+            }
+
+            inline void unhandled_exception()
+            {
+                abort();
+            }
+        };
+
+    private:
+        std::coroutine_handle<promise_type> _handle{};
+
+        inline explicit task(std::coroutine_handle<promise_type> handle)
+            : _handle{handle}
+        {}
+
+        class awaiter
+        {
+        private:
+            std::coroutine_handle<promise_type> _handle;
+
+        public:
+            inline awaiter(std::coroutine_handle<promise_type> handle)
+                : _handle{handle}
+            {}
+
+            inline bool await_ready() const
+            {
+                return _handle.done();
+            }
+
+            inline std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<> handle)
+            {
+                _handle.promise()._continuation = handle;
+                return _handle;
+            }
+
+            inline res_type await_resume()
+            {
+                return _handle.promise()._result.unwrap();
+            }
+        };
+
+    public:
+        inline task() = default;
+        inline task(const task&) = delete;
+        inline task& operator=(const task&) = delete;
+
+        inline task(task&& other)
+            : _handle{other._handle}
+        {
+            other._handle = nullptr;
+        }
+
+        inline task& operator=(task&& rhs)
+        {
+            auto _tmp = _handle;
+            _handle = rhs._handle;
+            rhs._handle = _tmp;
+            return *this;
+        }
+
+        inline ~task()
+        {
+            if (_handle)
+            {
+                _handle.destroy();
+            }
+        }
+
+        inline bool is_valid() const
+        {
+            return static_cast<bool>(_handle);
+        }
+
+        inline awaiter operator co_await() &&
+        {
+            return awaiter{_handle};
+        }
+    };
+
+    template <typename T, typename Err>
+    inline auto operator co_await(future<T, Err>&& fut)
+    {
+        return coroutine_detail::future_awaiter<T, Err>{move(fut)};
+    }
+
+    // Resumes the awaiting coroutine on one of the workers of pool
+    inline auto schedule(thread_pool& pool = thread_pool::global())
+    {
+        return coroutine_detail::schedule_awaiter{pool};
+    }
+
+    // Starts the task right away, on the calling thread, and
+    // hands its result over to a future, which it consumes
+    template <typename T, typename Err, template <typename> typename Allocator>
+    inline future<T, Err> to_future(task<T, Err, Allocator>&& work)
+    {
+        promise<T, Err> _promise;
+        auto _future = _promise.get_future();
+
+        [](task<T, Err, Allocator> work, promise<T, Err> prom)
+            -> coroutine_detail::detached
+        {
+            auto _res = co_await move(work);
+            coroutine_detail::fulfill(prom, _res);
+        }(move(work), move(_promise));
+
+        return _future;
+    }
+
+    template <typename T, typename Err, template <typename> typename Allocator>
+    inline auto sync_wait(task<T, Err, Allocator>&& work)
+    {
+        auto _future = to_future(move(work));
+        _future.wait();
+
+        return future_detail::promise_data_res_type<T, Err>{move(_future.get())};
+    }
+} // namespace hsd
@@ -29,12 +29,12 @@ namespace hsd
     template <typename _Ta, typename _Tb>
     class _compressed_pair_ab
     {
-        _Ta a;
-        _Tb b;
+        _Ta a{};
+        _Tb b{};
 
     public:
         template <typename _Aa, typename _Ab>
-        _compressed_pair_ab(_Aa&& _a, _Ab&& _b)
+        constexpr _compressed_pair_ab(_Aa&& _a, _Ab&& _b)
             : a(static_cast<_Ta>(forward<_Aa>(_a))), 
             b(static_cast<_Tb>(forward<_Ab>(_b)))
         {}
@@ -66,11 +66,11 @@ namespace hsd
     template <typename _Ta, typename _Tb>
     class _compressed_pair_b : private _Ta
     {
-        _Tb b;
+        _Tb b{};
 
     public:
         template <typename _Aa, typename _Ab>
-        _compressed_pair_b(_Aa&& _a, _Ab&& _b)
+        constexpr _compressed_pair_b(_Aa&& _a, _Ab&& _b)
             : _Ta(forward<_Aa>(_a)), b(forward<_Ab>(_b)) {}
 
         constexpr _Ta& first()
@@ -100,11 +100,11 @@ namespace hsd
     template <typename _Ta, typename _Tb>
     class _compressed_pair_a : private _Tb
     {
-        _Ta a;
+        _Ta a{};
 
     public:
         template <typename _Aa, typename _Ab>
-        _compressed_pair_a(_Aa&& _a, _Ab&& _b)
+        constexpr _compressed_pair_a(_Aa&& _a, _Ab&& _b)
             : _Tb(forward<_Ab>(_b)), a(forward<_Aa>(_a)) {}
 
         constexpr _Ta& first()
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "../List.hpp"
+#include "../MappedFile.hpp"
+#include "../Pair.hpp"
 #include "../String.hpp"
+#include "../Thread.hpp"
 #include "../UniquePtr.hpp"
 #include "../UnorderedMap.hpp"
 #include "../Variant.hpp"
+#include "../ConditionVariable.hpp"
 
 namespace hsd
 {
@@ -297,6 +301,17 @@ namespace hsd
         option_err<JsonError> lex_file(string_view filename)
         {
             //static const char* const s_keywords[] = {"null", "true", "false"};
+            if constexpr (is_same<CharT, char>::value)
+            {
+                // Narrow files are lexed straight out of the mapping
+                auto _file = mapped_file::open(filename.data());
+
+                if (!_file)
+                    return JsonError{"Couldn't open file", static_cast<usize>(-1)};
+
+                return lex(_file.unwrap().view());
+            }
+
             auto* _stream = fopen(filename.data(), "r");
             
             if (!_stream)
@@ -816,4 +831,196 @@ namespace hsd
             }
         }
     };
+
+    enum class JsonDelivery
+    {
+        Ordered,  // records reach the callback in file order, one at a time
+        Unordered // records reach the callback from the workers, as they are parsed
+    };
+
+    /// @brief Parallel reader for newline-delimited JSON (JSON Lines)
+    template <typename CharT>
+    class JsonLinesReader
+    {
+        static_assert(
+            is_same<CharT, char>::value, 
+            "JSON Lines are only implemented for char"
+        );
+
+        using vstr = basic_string_view<CharT>;
+        using chunk_type = pair<usize, usize>;
+
+    public:
+        using record_type = result<unique_ptr<JsonValue>, JsonError>;
+
+    private:
+        usize _workers;
+        usize _chunk_size;
+
+        // Cuts the input into pieces of roughly _chunk_size bytes, every
+        // piece except the last one ending right after a new line
+        vector<chunk_type> _split(vstr data) const
+        {
+            vector<chunk_type> _chunks;
+            usize _begin = 0;
+
+            while (_begin < data.size())
+            {
+                usize _end = _begin + _chunk_size;
+
+                if (_end >= data.size())
+                {
+                    _end = data.size();
+                }
+                else
+                {
+                    while (_end < data.size() and data[_end - 1] != static_cast<CharT>('\n'))
+                        ++_end;
+                }
+
+                _chunks.emplace_back(_begin, _end);
+                _begin = _end;
+            }
+
+            return _chunks;
+        }
+
+        static record_type _parse_line(vstr line, usize offset)
+        {
+            JsonStream<CharT> _lexer;
+            auto _lex_res = _lexer.lex(line);
+
+            if (_lex_res)
+                _lex_res = _lexer.push_eot();
+
+            if (!_lex_res)
+            {
+                auto _err = _lex_res.unwrap_err();
+                _err.position += offset;
+                return _err;
+            }
+
+            JsonParser<CharT> _parser = _lexer;
+            auto _value = _parser.parse_next();
+
+            if (!_value)
+            {
+                auto _err = _value.unwrap_err();
+                _err.position += offset;
+                return _err;
+            }
+            if (_lexer.get_tokens().front() != JsonToken::Eof)
+            {
+                return JsonError{"Syntax error: trailing data after record", offset};
+            }
+
+            return _value;
+        }
+
+        template <typename Func>
+        static void _parse_chunk(vstr data, const chunk_type& chunk, Func&& func)
+        {
+            for (usize _begin = chunk.first; _begin < chunk.second;)
+            {
+                usize _end = _begin;
+                
+                while (_end < chunk.second and data[_end] != static_cast<CharT>('\n'))
+                    ++_end;
+
+                usize _next = _end + 1;
+
+                if (_end > _begin and data[_end - 1] == static_cast<CharT>('\r'))
+                    --_end;
+
+                bool _blank = true;
+
+                for (usize _index = _begin; _index < _end and _blank; _index++)
+                    _blank = basic_cstring<CharT>::iswhitespace(data[_index]);
+
+                if (!_blank)
+                    func(_parse_line({data.data() + _begin, _end - _begin}, _begin));
+
+                _begin = _next;
+            }
+        }
+
+    public:
+        JsonLinesReader(
+            usize workers = static_cast<usize>(thread::hardware_concurrency()), 
+            usize chunk_size = 4 * 1024 * 1024)
+            : _workers{workers == 0 ? 1 : workers}, 
+            _chunk_size{chunk_size == 0 ? 1 : chunk_size}
+        {}
+
+        // Func is called with a record_type&& for every non-blank line,
+        // errors carry the byte offset of the line inside of data. In the
+        // unordered mode Func is called concurrently from every worker
+        template <typename Func>
+        void parse(vstr data, Func&& func, JsonDelivery delivery = JsonDelivery::Ordered)
+        {
+            auto _chunks = _split(data);
+            atomic_usize _next_chunk = 0;
+            
+            usize _turn = 0;
+            mutex _mutex;
+            condition_variable _turn_cv;
+
+            auto _worker = [&]
+            {
+                vector<record_type> _records;
+
+                for (usize _index = _next_chunk.fetch_add(1); 
+                    _index < _chunks.size(); _index = _next_chunk.fetch_add(1))
+                {
+                    if (delivery == JsonDelivery::Unordered)
+                    {
+                        _parse_chunk(data, _chunks[_index], func);
+                        continue;
+                    }
+
+                    _parse_chunk(data, _chunks[_index], [&](record_type&& record)
+                    {
+                        _records.push_back(move(record));
+                    });
+
+                    // Every chunk before this one is already claimed,
+                    // so its owner can only be parsing or delivering
+                    unique_lock<mutex> _lock{_mutex};
+                    _turn_cv.wait(_lock, [&] { return _turn == _index; });
+
+                    for (auto& _record : _records)
+                        func(move(_record));
+
+                    _records.clear();
+                    ++_turn;
+                    _turn_cv.notify_all();
+                }
+            };
+
+            usize _thread_count = (_workers < _chunks.size() ? _workers : _chunks.size());
+            vector<thread> _threads;
+
+            for (usize _index = 1; _index < _thread_count; _index++)
+                _threads.emplace_back(_worker);
+
+            _worker();
+
+            for (auto& _thread : _threads)
+                _thread.join().unwrap();
+        }
+
+        template <typename Func>
+        option_err<JsonError> parse_file(
+            string_view filename, Func&& func, JsonDelivery delivery = JsonDelivery::Ordered)
+        {
+            auto _file = mapped_file::open(filename.data());
+
+            if (!_file)
+                return JsonError{"Couldn't open file", static_cast<usize>(-1)};
+
+            auto _mapping = _file.unwrap();
+            parse(_mapping.view(), forward<Func>(func), delivery);
+            return {};
+        }
+    };
 }
@@ -4,15 +4,21 @@
 #include "Result.hpp"
 #include "UniquePtr.hpp"
 
+#include <new>
+
 namespace hsd
 {
     template <typename> class function;
-    
+    template <typename> class unique_function;
+
     namespace func_detail
     {
+        // Common base of function and unique_function
+        struct function_tag {};
+
         template < typename Func, typename Res, typename... Args >
         concept IsFunction = (
-            !is_same<Func, function<Res(Args...)>>::value && 
+            !std::is_base_of_v<function_tag, Func> &&
             InvocableRet<Res, Func, Args...>
         );
 
@@ -38,29 +44,47 @@ namespace hsd
 
         template <typename T>
         using store_ref_t = typename store_ref<T>::type;
-    } // namespace func_detail
 
-    template < typename ResultType, typename... Args >
-    class function<ResultType(Args...)> 
-    {
-    private:
-        struct callable_base
+        // Callables up to this size are stored inside the function
+        static constexpr usize small_size = 3 * sizeof(void*);
+
+        template <typename Func>
+        static constexpr bool stored_inline = (
+            sizeof(Func) <= small_size &&
+            alignof(Func) <= alignof(void*) &&
+            std::is_nothrow_move_constructible_v<Func>
+        );
+
+        // Hand-rolled vtable, one static instance per callable type,
+        // copy is null for the move-only unique_function
+        template < typename ResultType, typename... Args >
+        struct vtable
         {
-            virtual unique_ptr<callable_base> clone() const = 0;
-            virtual ResultType operator()(Args&&...) = 0;
-            virtual ~callable_base() = default;
+            ResultType (*invoke)(void*, Args&&...);
+            void (*move)(void* dest, void* src);
+            void (*copy)(void* dest, const void* src);
+            void (*destroy)(void*);
         };
 
-        template <typename Func>
-        struct callable : callable_base
+        template < typename Func, typename ResultType, typename... Args >
+        struct ops
         {
-            Func _func;
-            callable(Func func)
-                : _func{func}
-            {}
+            static inline Func* get(void* storage)
+            {
+                if constexpr (stored_inline<Func>)
+                {
+                    return std::launder(reinterpret_cast<Func*>(storage));
+                }
+                else
+                {
+                    return *static_cast<Func**>(storage);
+                }
+            }
 
-            virtual ResultType operator()(Args&&... args) override
+            static inline ResultType invoke(void* storage, Args&&... args)
             {
+                auto& _func = *get(storage);
+
                 if constexpr (requires {{_func(forward<Args>(args)...)} -> IsSame<ResultType>;})
                 {
                     return _func(forward<Args>(args)...);
@@ -71,112 +95,315 @@ namespace hsd
                 }
             }
 
-            virtual unique_ptr<callable_base> clone() const override
+            // Leaves src empty, it won't be destroyed afterwards
+            static inline void move(void* dest, void* src)
+            {
+                if constexpr (stored_inline<Func>)
+                {
+                    ::new (dest) Func{hsd::move(*get(src))};
+                    get(src)->~Func();
+                }
+                else
+                {
+                    *static_cast<Func**>(dest) = get(src);
+                }
+            }
+
+            static inline void copy(void* dest, const void* src)
             {
-                return make_unique<callable<Func>>(_func);
+                auto& _func = *get(const_cast<void*>(src));
+
+                if constexpr (stored_inline<Func>)
+                {
+                    ::new (dest) Func{_func};
+                }
+                else
+                {
+                    *static_cast<Func**>(dest) = new Func{_func};
+                }
             }
+
+            static inline void destroy(void* storage)
+            {
+                if constexpr (stored_inline<Func>)
+                {
+                    get(storage)->~Func();
+                }
+                else
+                {
+                    delete get(storage);
+                }
+            }
+
+            template <typename F>
+            static inline void create(void* storage, F&& func)
+            {
+                if constexpr (stored_inline<Func>)
+                {
+                    ::new (storage) Func{forward<F>(func)};
+                }
+                else
+                {
+                    *static_cast<Func**>(storage) = new Func{forward<F>(func)};
+                }
+            }
+
+            static constexpr vtable<ResultType, Args...> copyable_table = {
+                &invoke, &move, &copy, &destroy
+            };
+
+            static constexpr vtable<ResultType, Args...> move_only_table = {
+                &invoke, &move, nullptr, &destroy
+            };
         };
-        
-        unique_ptr<callable_base> _func_impl{};
 
-        inline void reset()
+        // Type-erased callable, small ones live in the inline
+        // buffer, so neither building nor calling them allocates
+        template < bool Copyable, typename ResultType, typename... Args >
+        class function_impl : public function_tag
         {
-            _func_impl = nullptr;
-        }
+        private:
+            using vtable_type = vtable<ResultType, Args...>;
 
-    public:
-        inline function() = default;
-        inline function(NullType) {}
+            const vtable_type* _vtable = nullptr;
+            alignas(void*) uchar _storage[small_size];
 
-        inline function(auto func)
-        requires (func_detail::IsFunction<decltype(func), ResultType, Args...>);
+            template <typename Func>
+            inline void _create(Func&& func)
+            {
+                using ops_type = ops<decay_t<Func>, ResultType, Args...>;
 
-        inline function(const function&);
+                ops_type::create(_storage, forward<Func>(func));
+                if constexpr (Copyable)
+                {
+                    _vtable = &ops_type::copyable_table;
+                }
+                else
+                {
+                    _vtable = &ops_type::move_only_table;
+                }
+            }
 
-        inline function(function&& other)
-        {
-            swap(_func_impl, other._func_impl);
-        }
+            inline void _copy_from(const function_impl& other)
+            {
+                if (other._vtable != nullptr)
+                {
+                    other._vtable->copy(_storage, other._storage);
+                    _vtable = other._vtable;
+                }
+            }
 
-        inline ~function()
-        {
-            reset();
-        }
+            inline void _move_from(function_impl& other)
+            {
+                if (other._vtable != nullptr)
+                {
+                    other._vtable->move(_storage, other._storage);
+                    _vtable = exchange(other._vtable, nullptr);
+                }
+            }
 
-        inline function& operator=(const function& other);
+            inline void _reset()
+            {
+                if (_vtable != nullptr)
+                {
+                    exchange(_vtable, nullptr)->destroy(_storage);
+                }
+            }
 
-        inline function& operator=(auto func)
-        requires (func_detail::IsFunction<decltype(func), ResultType, Args...>);
+            inline ResultType _invoke(Args&&... args) const
+            {
+                return _vtable->invoke(
+                    const_cast<uchar*>(_storage), forward<Args>(args)...
+                );
+            }
 
-        inline function& operator=(function&& other)
-        {
-            swap(_func_impl, other._func_impl);
-            return *this;
-        }
+        public:
+            inline function_impl() = default;
+            inline function_impl(NullType) {}
 
-        inline function& operator=(NullType)
-        {
-            reset();
-            return *this;
-        }
+            template <typename Func>
+            requires (IsFunction<decay_t<Func>, ResultType, Args...>)
+            inline function_impl(Func&& func)
+            {
+                _create(forward<Func>(func));
+            }
 
-        inline explicit operator bool() const
-        {
-            return _func_impl.get() != nullptr;
-        }
+            inline function_impl(const function_impl& other)
+            requires (Copyable)
+            {
+                _copy_from(other);
+            }
 
-        inline auto operator()(Args... args) 
-            -> result<
-                func_detail::store_ref_t<ResultType>, 
-                func_detail::bad_function >
-        requires (!is_void<ResultType>::value)
-        {
-            if (_func_impl == nullptr)
+            inline function_impl(function_impl&& other)
             {
-                return func_detail::bad_function{};
+                _move_from(other);
             }
 
-            return {_func_impl->operator()(forward<Args>(args)...)};
-        }
+            inline ~function_impl()
+            {
+                _reset();
+            }
 
-        inline auto operator()(Args... args) 
-            -> option_err<func_detail::bad_function>
-        requires (is_void<ResultType>::value)
-        {
-            if (_func_impl == nullptr)
+            inline function_impl& operator=(const function_impl& rhs)
+            requires (Copyable)
             {
-                return func_detail::bad_function{};
+                if (this != &rhs)
+                {
+                    _reset();
+                    _copy_from(rhs);
+                }
+
+                return *this;
             }
 
-            _func_impl->operator()(forward<Args>(args)...);
-            return {};
-        }
+            inline function_impl& operator=(function_impl&& rhs)
+            {
+                if (this != &rhs)
+                {
+                    _reset();
+                    _move_from(rhs);
+                }
 
-        inline auto operator()(Args... args) const
-            -> result<
-                func_detail::store_ref_t<ResultType>, 
-                func_detail::bad_function >
-        requires (!is_void<ResultType>::value)
-        {
-            if (_func_impl == nullptr)
+                return *this;
+            }
+
+            template <typename Func>
+            requires (IsFunction<decay_t<Func>, ResultType, Args...>)
+            inline function_impl& operator=(Func&& func)
             {
-                return func_detail::bad_function{};
+                _reset();
+                _create(forward<Func>(func));
+                return *this;
             }
 
-            return {_func_impl->operator()(forward<Args>(args)...)};
-        }
+            inline function_impl& operator=(NullType)
+            {
+                _reset();
+                return *this;
+            }
+
+            inline explicit operator bool() const
+            {
+                return _vtable != nullptr;
+            }
+
+            inline auto operator()(Args... args) const
+                -> result<store_ref_t<ResultType>, bad_function>
+            requires (!is_void<ResultType>::value)
+            {
+                if (_vtable == nullptr)
+                {
+                    return bad_function{};
+                }
+
+                return {_invoke(forward<Args>(args)...)};
+            }
+
+            inline auto operator()(Args... args) const
+                -> option_err<bad_function>
+            requires (is_void<ResultType>::value)
+            {
+                if (_vtable == nullptr)
+                {
+                    return bad_function{};
+                }
+
+                _invoke(forward<Args>(args)...);
+                return {};
+            }
+        };
+    } // namespace func_detail
+
+    template < typename ResultType, typename... Args >
+    class function<ResultType(Args...)>
+        : public func_detail::function_impl<true, ResultType, Args...>
+    {
+    private:
+        using base_type = func_detail::function_impl<true, ResultType, Args...>;
+
+    public:
+        using base_type::base_type;
+        using base_type::operator=;
+    };
+
+    // Same as function, but can hold move-only callables
+    // and therefore can't be copied itself
+    template < typename ResultType, typename... Args >
+    class unique_function<ResultType(Args...)>
+        : public func_detail::function_impl<false, ResultType, Args...>
+    {
+    private:
+        using base_type = func_detail::function_impl<false, ResultType, Args...>;
+
+    public:
+        using base_type::base_type;
+        using base_type::operator=;
+    };
+
+    template <typename> class function_ref;
 
-        inline auto operator()(Args... args) const
-            -> option_err<func_detail::bad_function>
-        requires (is_void<ResultType>::value)
+    // Non-owning view of a callable, just an object pointer and a
+    // thunk, so taking one as a parameter costs two pointers and no
+    // allocation. The callable has to outlive the function_ref
+    template < typename ResultType, typename... Args >
+    class function_ref<ResultType(Args...)>
+    {
+    private:
+        union target
         {
-            if (_func_impl == nullptr)
+            void* object;
+            void (*function)();
+        };
+
+        target _target;
+        ResultType (*_thunk)(target, Args&&...);
+
+        template <typename Func>
+        static inline ResultType _call(Func& func, Args&&... args)
+        {
+            if constexpr (requires {{func(forward<Args>(args)...)} -> IsSame<ResultType>;})
+            {
+                return func(forward<Args>(args)...);
+            }
+            else if constexpr (UnwrapInvocable<Func&, Args...>)
             {
-                return func_detail::bad_function{};
+                return func(forward<Args>(args)...).unwrap();
             }
+        }
 
-            _func_impl->operator()(forward<Args>(args)...);
-            return {};
+    public:
+        template <typename Func>
+        requires (
+            !is_same<decay_t<Func>, function_ref>::value &&
+            !is_pointer<decay_t<Func>>::value &&
+            InvocableRet<ResultType, Func&, Args...>
+        )
+        inline function_ref(Func&& func)
+            : _thunk{[](target tgt, Args&&... args) -> ResultType {
+                using func_type = remove_reference_t<Func>;
+                return _call(*static_cast<func_type*>(tgt.object), forward<Args>(args)...);
+            }}
+        {
+            _target.object = const_cast<void*>(static_cast<const void*>(&func));
+        }
+
+        template <typename Res, typename... FuncArgs>
+        requires (InvocableRet<ResultType, Res(*)(FuncArgs...), Args...>)
+        inline function_ref(Res(*func)(FuncArgs...))
+            : _thunk{[](target tgt, Args&&... args) -> ResultType {
+                auto* _func = reinterpret_cast<Res(*)(FuncArgs...)>(tgt.function);
+                return _call(_func, forward<Args>(args)...);
+            }}
+        {
+            _target.function = reinterpret_cast<void(*)()>(func);
+        }
+
+        inline function_ref(const function_ref&) = default;
+        inline function_ref& operator=(const function_ref&) = default;
+
+        inline ResultType operator()(Args... args) const
+        {
+            return _thunk(_target, forward<Args>(args)...);
         }
     };
 
@@ -210,40 +437,6 @@ namespace hsd
         };
     } // namespace functional_helper
 
-    template < typename Res, typename... Args >
-    inline function<Res(Args...)>::function(const function& other)
-    {
-        _func_impl = other._func_impl->clone();
-    }
-
-    template < typename Res, typename... Args >
-    inline function<Res(Args...)>::function(auto func)
-    requires (func_detail::IsFunction<decltype(func), Res, Args...>)
-    {
-        _func_impl = make_unique<callable<decltype(func)>>(func);
-    }
-
-    template < typename Res, typename... Args >
-    inline auto function<Res(Args...)>::operator=(const function<Res(Args...)>& other)
-        -> function<Res(Args...)>&
-    {
-        reset();
-        _func_impl = other._func_impl->clone();
-        return *this;
-    }
-
-    template < typename Res, typename... Args >
-    inline auto function<Res(Args...)>::operator=(auto func)
-        -> function<Res(Args...)>&
-    requires (func_detail::IsFunction<decltype(func), Res, Args...>)
-    {
-        using func_type = decltype(func);
-
-        reset();
-        _func_impl = make_unique<callable<func_type>>(forward<func_type>(func));
-        return *this;
-    }
-
     template < typename Func, typename T, typename... Args >
     requires (std::is_member_function_pointer_v<Func>)
     static inline auto bind(Func func, T&& value, Args&&... args)
@@ -428,4 +621,12 @@ namespace hsd
     function(Func) -> function<
         typename functional_helper::as_function<Op>::type
     >;
+
+    template < typename Res, typename... Args > 
+    unique_function(Res(*)(Args...)) -> unique_function<Res(Args...)>;
+    
+    template < typename Func, typename Op = decltype(&Func::operator()) > 
+    unique_function(Func) -> unique_function<
+        typename functional_helper::as_function<Op>::type
+    >;
 } // namespace hsd
\ No newline at end of file
@@ -12,8 +12,44 @@ namespace hsd
     template <typename T, typename Err = runtime_error>
     class promise;
 
+    class thread_pool;
+
     namespace future_detail
     {
+        struct future_access;
+
+        // Runs once the result is published, from the thread that
+        // publishes it (or the one attaching, if it's already there)
+        template <typename T>
+        struct continuation
+        {
+            virtual void run(T& result) = 0;
+            virtual ~continuation() = default;
+        };
+
+        // Work of a deferred future, run by the first wait on it
+        struct deferred_call
+        {
+            virtual void run() = 0;
+            virtual ~deferred_call() = default;
+        };
+
+        template <typename Func>
+        struct deferred_call_impl final : deferred_call
+        {
+            Func _func;
+
+            template <typename F>
+            inline deferred_call_impl(F&& func)
+                : _func{forward<F>(func)}
+            {}
+
+            virtual void run() override
+            {
+                _func();
+            }
+        };
+
         template <typename T>
         struct promise_data_impl
         {
@@ -21,6 +57,7 @@ namespace hsd
             mutex _mutex{};
             bool _is_set = false;
             condition_variable _cond_var{};
+            continuation<T>* _continuation = nullptr;
 
             inline promise_data_impl() requires(Constructible<T>) = default;
 
@@ -35,9 +72,16 @@ namespace hsd
                 : _result{move(other._result)},
                 _mutex{move(other._mutex)}, 
                 _is_set{other._is_set},
-                _cond_var{move(other._cond_var)}
+                _cond_var{move(other._cond_var)},
+                _continuation{other._continuation}
             {
                 other._is_set = false;
+                other._continuation = nullptr;
+            }
+
+            inline ~promise_data_impl()
+            {
+                delete _continuation;
             }
 
             inline promise_data_impl& operator=(const promise_data_impl&) = delete;
@@ -49,13 +93,49 @@ namespace hsd
                 swap(_mutex, rhs._mutex);
                 swap(_is_set, rhs._is_set);
                 swap(_cond_var, rhs._cond_var);
+                swap(_continuation, rhs._continuation);
                 return *this;
             }
+
+            inline void publish(T&& result)
+            {
+                unique_lock<mutex> _lock{_mutex};
+                _result = move(result);
+                _is_set = true;
+                auto* _next = exchange(_continuation, nullptr);
+                _cond_var.notify_all();
+                _lock.unlock().unwrap();
+
+                if (_next != nullptr)
+                {
+                    _next->run(_result);
+                    delete _next;
+                }
+            }
+
+            // A result is handed to at most one continuation
+            inline void attach(continuation<T>* next)
+            {
+                unique_lock<mutex> _lock{_mutex};
+
+                if (_is_set == false)
+                {
+                    delete exchange(_continuation, next);
+                    return;
+                }
+
+                _lock.unlock().unwrap();
+                next->run(_result);
+                delete next;
+            }
         };
 
         template <typename, typename>
         struct promise_data;
 
+        template <typename Res, typename Func>
+        struct then_promise;
+
         template <typename T, typename Err>
         requires (!IsVoid<T> && !IsVoid<Err>)
         struct promise_data<T, Err> :
@@ -91,15 +171,30 @@ namespace hsd
     private:
         using promise_data_ptr_t = 
             future_detail::promise_data_ptr<T, Err>;
+        using res_type = 
+            future_detail::promise_data_res_type<T, Err>;
+        
         promise_data_ptr_t _promise_ptr{};
+        mutable future_detail::deferred_call* _deferred = nullptr;
         
         bool _is_valid = false;
         friend class promise<T, Err>;
+        friend struct future_detail::future_access;
 
         inline future(promise_data_ptr_t& promise_ptr)
             : _promise_ptr{promise_ptr}, _is_valid{true}
         {}
 
+        inline void _run_deferred() const
+        {
+            if (_deferred != nullptr)
+            {
+                auto* _call = exchange(_deferred, nullptr);
+                _call->run();
+                delete _call;
+            }
+        }
+
     public:
         inline future() = default;
         inline future(const future&) = delete;
@@ -107,17 +202,26 @@ namespace hsd
 
         inline future(future&& other)
             : _promise_ptr{move(other._promise_ptr)}, 
+            _deferred{exchange(other._deferred, nullptr)},
             _is_valid{other._is_valid}
         {}
 
         inline future& operator=(future&& rhs)
         {
             swap(_promise_ptr, rhs._promise_ptr);
+            swap(_deferred, rhs._deferred);
+            swap(_is_valid, rhs._is_valid);
             return *this;
         }
 
+        inline ~future()
+        {
+            delete _deferred;
+        }
+
         inline auto& get() const
         {
+            _run_deferred();
             return _promise_ptr->_result;
         }
 
@@ -128,6 +232,7 @@ namespace hsd
 
         inline void wait()
         {
+            _run_deferred();
             unique_lock<mutex> _lock{_promise_ptr->_mutex};
             _promise_ptr->_cond_var.wait(
                 _lock, [this] {
@@ -138,6 +243,7 @@ namespace hsd
 
         inline void wait_for(const precise_clock& rel_time)
         {
+            _run_deferred();
             unique_lock<mutex> _lock{_promise_ptr->_mutex};
             _promise_ptr->_cond_var.wait_for(
                 _lock, rel_time, [this] {
@@ -148,6 +254,7 @@ namespace hsd
 
         inline void wait_until(const precise_clock& abs_time)
         {
+            _run_deferred();
             unique_lock<mutex> _lock{_promise_ptr->_mutex};
             _promise_ptr->_cond_var.wait_until(
                 _lock, abs_time, [this] {
@@ -155,6 +262,61 @@ namespace hsd
                 }
             );
         }
+
+        // Schedules func on exec once the result is ready and returns
+        // the future of its result. func either takes the whole result
+        // (result/option/option_err) or just the value, in which case
+        // an error skips it and is forwarded to the returned future.
+        // The result is moved into func, so this future is consumed
+        template <typename Executor, typename Func>
+        inline auto then(Executor& exec, Func&& func)
+        {
+            using then_promise = 
+                future_detail::then_promise<res_type, decay_t<Func>>;
+            using next_promise = typename then_promise::type;
+
+            struct then_continuation final
+                : future_detail::continuation<res_type>
+            {
+                Executor* _exec;
+                decay_t<Func> _func;
+                next_promise _next;
+
+                inline then_continuation(
+                    Executor* exec, decay_t<Func>&& func, next_promise&& next)
+                    : _exec{exec}, _func{move(func)}, _next{move(next)}
+                {}
+
+                virtual void run(res_type& result) override
+                {
+                    _exec->execute([
+                        _func = move(_func), _next = move(_next),
+                        _result = move(result)]() mutable
+                    {
+                        then_promise::invoke(_next, _func, _result);
+                    });
+                }
+            };
+
+            next_promise _next;
+            auto _next_future = _next.get_future();
+
+            _run_deferred();
+            auto _data = move(_promise_ptr);
+            _is_valid = false;
+
+            _data->attach(new then_continuation{
+                &exec, decay_t<Func>{forward<Func>(func)}, move(_next)
+            });
+
+            return _next_future;
+        }
+
+        template <typename Executor = thread_pool, typename Func>
+        inline auto then(Func&& func)
+        {
+            return then(Executor::global(), forward<Func>(func));
+        }
     };
 
     template <typename T, typename Err>
@@ -169,10 +331,7 @@ namespace hsd
         
         inline void _set(res_type&& result)
         {
-            hsd::unique_lock<hsd::mutex> _lock{_promise_ptr->_mutex};
-            swap(_promise_ptr->_result, result);
-            _promise_ptr->_is_set = true;
-            _promise_ptr->_cond_var.notify_all();
+            _promise_ptr->publish(move(result));
         }
 
     public:
@@ -252,10 +411,7 @@ namespace hsd
         
         inline void _set(res_type&& result)
         {
-            hsd::unique_lock<hsd::mutex> _lock{_promise_ptr->_mutex};
-            swap(_promise_ptr->_result, result);
-            _promise_ptr->_is_set = true;
-            _promise_ptr->_cond_var.notify_all();
+            _promise_ptr->publish(move(result));
         }
 
     public:
@@ -316,10 +472,7 @@ namespace hsd
         
         inline void _set(res_type&& result)
         {
-            hsd::unique_lock<hsd::mutex> _lock{_promise_ptr->_mutex};
-            swap(_promise_ptr->_result, result);
-            _promise_ptr->_is_set = true;
-            _promise_ptr->_cond_var.notify_all();
+            _promise_ptr->publish(move(result));
         }
 
     public:
@@ -382,70 +535,110 @@ namespace hsd
         }
     };
 
-    template <typename Res, typename... Args>
-    class packaged_task<Res(Args...)>
+    namespace future_detail
     {
-    private:
-        function<Res(Args...)> _func;
-        promise<Res, runtime_error> _promise;
-
-    public:
-        inline packaged_task(function<Res(Args...)>&& func)
-            : _func{move(func)}, _promise{}
-        {}
-
-        inline packaged_task(const packaged_task&) = delete;
-        inline packaged_task& operator=(const packaged_task&) = delete;
+        // Maps the return type of a callable to the promise that
+        // carries it, results and options pass their error along
+        template <typename Res>
+        struct task_promise
+        {
+            using type = promise<Res, runtime_error>;
 
-        inline packaged_task(packaged_task&& other)
-            : _func{move(other._func)}, _promise{move(other._promise)}
-        {}
+            template <typename Func>
+            static inline void invoke(type& prom, Func& func)
+            {
+                prom.set_value(func());
+            }
+        };
 
-        inline packaged_task& operator=(packaged_task&& rhs)
+        template <>
+        struct task_promise<void>
         {
-            swap(*this, rhs);
-            return *this;
-        }
+            using type = promise<void, runtime_error>;
 
-        inline friend void swap(packaged_task& lhs, packaged_task& rhs)
-        {
-            swap(lhs._func, rhs._func);
-            swap(lhs._promise, rhs._promise);
-        }
+            template <typename Func>
+            static inline void invoke(type& prom, Func& func)
+            {
+                func();
+                prom.set_value();
+            }
+        };
 
-        inline auto get_future()
+        template <typename Ok, typename Err>
+        struct task_promise<result<Ok, Err>>
         {
-            return _promise.get_future();
-        }
+            using type = promise<Ok, Err>;
 
-        inline void operator()(Args... args)
-        {
-            if constexpr (IsSame<Res, void>)
+            template <typename Func>
+            static inline void invoke(type& prom, Func& func)
             {
-                _func(forward<Args>(args)...).unwrap();
-                _promise.set_value();
+                auto _res = func();
+
+                if (_res.is_ok())
+                {
+                    prom.set_value(_res.unwrap());
+                }
+                else
+                {
+                    prom.set_error(_res.unwrap_err());
+                }
             }
-            else
+        };
+
+        template <typename Ok>
+        struct task_promise<option<Ok>>
+        {
+            using type = promise<Ok, void>;
+
+            template <typename Func>
+            static inline void invoke(type& prom, Func& func)
             {
-                _promise.set_value(_func(forward<Args>(args)...).unwrap());
+                auto _res = func();
+
+                if (_res.is_ok())
+                {
+                    prom.set_value(_res.unwrap());
+                }
+                else
+                {
+                    prom.set_error();
+                }
             }
-        }
+        };
 
-        inline bool valid() const
+        template <typename Err>
+        struct task_promise<option_err<Err>>
         {
-            return static_cast<bool>(_func) && get_future().valid();
-        }
-    };
+            using type = promise<void, Err>;
+
+            template <typename Func>
+            static inline void invoke(type& prom, Func& func)
+            {
+                auto _res = func();
 
-    template <typename Ok, typename Err, typename... Args>
-    class packaged_task<result<Ok, Err>(Args...)>
+                if (_res.is_ok())
+                {
+                    prom.set_value();
+                }
+                else
+                {
+                    prom.set_error(_res.unwrap_err());
+                }
+            }
+        };
+    } // namespace future_detail
+
+    template <typename Res, typename... Args>
+    class packaged_task<Res(Args...)>
     {
     private:
-        function<result<Ok, Err>(Args...)> _func;
-        promise<Ok, Err> _promise;
+        using task_type = future_detail::task_promise<Res>;
+
+        function<Res(Args...)> _func;
+        typename task_type::type _promise;
 
     public:
-        inline packaged_task(function<result<Ok, Err>(Args...)>&& func)
+        inline packaged_task(function<Res(Args...)>&& func)
             : _func{move(func)}, _promise{}
         {}
 
@@ -475,16 +668,8 @@ namespace hsd
 
         inline void operator()(Args... args)
         {
-            auto _res = _func(forward<Args>(args)...).unwrap();
-            
-            if (_res.is_ok())
-            {
-                _promise.set_value(_res.unwrap());
-            }
-            else
-            {
-                _promise.set_error(_res.unwrap_err());
-            }
+            auto _call = [&] { return _func(forward<Args>(args)...).unwrap(); };
+            task_type::invoke(_promise, _call);
         }
 
         inline bool valid() const
@@ -492,118 +677,200 @@ namespace hsd
             return static_cast<bool>(_func) && get_future().valid();
         }
     };
-    
-    template <typename Ok, typename... Args>
-    class packaged_task<option<Ok>(Args...)>
-    {
-    private:
-        function<option<Ok>(Args...)> _func;
-        promise<Ok, void> _promise;
 
-    public:
-        inline packaged_task(function<option<Ok>(Args...)>&& func)
-            : _func{move(func)}, _promise{}
-        {}
-
-        inline packaged_task(const packaged_task&) = delete;
-        inline packaged_task& operator=(const packaged_task&) = delete;
-
-        inline packaged_task(packaged_task&& other)
-            : _func{move(other._func)}, _promise{move(other._promise)}
-        {}
+    namespace future_detail
+    {
+        template <typename Res>
+        struct result_traits;
 
-        inline packaged_task& operator=(packaged_task&& rhs)
+        template <typename Ok, typename Err>
+        struct result_traits<result<Ok, Err>>
         {
-            swap(*this, rhs);
-            return *this;
-        }
+            using value_type = Ok;
+            using error_type = Err;
+        };
 
-        inline friend void swap(packaged_task& lhs, packaged_task& rhs)
+        template <typename Ok>
+        struct result_traits<option<Ok>>
         {
-            swap(lhs._func, rhs._func);
-            swap(lhs._promise, rhs._promise);
-        }
+            using value_type = Ok;
+            using error_type = void;
+        };
 
-        inline auto get_future()
+        template <typename Err>
+        struct result_traits<option_err<Err>>
         {
-            return _promise.get_future();
-        }
+            using value_type = void;
+            using error_type = Err;
+        };
 
-        inline void operator()(Args... args)
+        // Like task_promise, but keeps the error type of the future
+        // the continuation was attached to, so its errors can pass
+        template <typename Res, typename Err>
+        struct value_promise
         {
-            auto _res = _func(forward<Args>(args)...).unwrap();
-            
-            if (_res.is_ok())
-            {
-                _promise.set_value(_res.unwrap());
-            }
-            else
+            using type = promise<Res, Err>;
+
+            template <typename Func>
+            static inline void invoke(type& prom, Func& func)
             {
-                _promise.set_error();
+                prom.set_value(func());
             }
-        }
+        };
 
-        inline bool valid() const
+        template <typename Err>
+        struct value_promise<void, Err>
         {
-            return static_cast<bool>(_func) && get_future().valid();
-        }
-    };
+            using type = promise<void, Err>;
 
-    template <typename Err, typename... Args>
-    class packaged_task<option_err<Err>(Args...)>
-    {
-    private:
-        function<option_err<Err>(Args...)> _func;
-        promise<void, Err> _promise;
+            template <typename Func>
+            static inline void invoke(type& prom, Func& func)
+            {
+                func();
+                prom.set_value();
+            }
+        };
 
-    public:
-        inline packaged_task(function<option_err<Err>(Args...)>&& func)
-            : _func{move(func)}, _promise{}
-        {}
+        template <typename Ok, typename Err>
+        struct value_promise<result<Ok, Err>, Err>
+            : task_promise<result<Ok, Err>> {};
 
-        inline packaged_task(const packaged_task&) = delete;
-        inline packaged_task& operator=(const packaged_task&) = delete;
+        template <typename Ok>
+        struct value_promise<option<Ok>, void>
+            : task_promise<option<Ok>> {};
 
-        inline packaged_task(packaged_task&& other)
-            : _func{move(other._func)}, _promise{move(other._promise)}
-        {}
+        template <typename Err>
+        struct value_promise<option_err<Err>, Err>
+            : task_promise<option_err<Err>> {};
 
-        inline packaged_task& operator=(packaged_task&& rhs)
+        template <typename Value, typename Func>
+        struct value_call
         {
-            swap(*this, rhs);
-            return *this;
-        }
+            using type = decay_t<decltype(declval<Func&>()(declval<Value&&>()))>;
+        };
 
-        inline friend void swap(packaged_task& lhs, packaged_task& rhs)
+        template <typename Func>
+        struct value_call<void, Func>
         {
-            swap(lhs._func, rhs._func);
-            swap(lhs._promise, rhs._promise);
-        }
+            using type = decay_t<decltype(declval<Func&>()())>;
+        };
 
-        inline auto get_future()
+        template <typename Prom, typename Res>
+        static inline void forward_error(Prom& prom, Res& res)
         {
-            return _promise.get_future();
+            if constexpr (requires { prom.set_error(); })
+            {
+                prom.set_error();
+            }
+            else
+            {
+                prom.set_error(res.unwrap_err());
+            }
         }
 
-        inline void operator()(Args... args)
+        // Continuation taking only the value, errors skip it
+        template <typename Res, typename Func>
+        struct then_promise
+            : value_promise<
+                typename value_call<
+                    typename result_traits<Res>::value_type, Func
+                >::type,
+                typename result_traits<Res>::error_type
+            >
+        {
+            using value_type = typename result_traits<Res>::value_type;
+            using base_type = value_promise<
+                typename value_call<value_type, Func>::type,
+                typename result_traits<Res>::error_type
+            >;
+
+            static inline void invoke(
+                typename base_type::type& prom, Func& func, Res& res)
+            {
+                if (res.is_ok() == false)
+                {
+                    forward_error(prom, res);
+                }
+                else if constexpr (IsVoid<value_type>)
+                {
+                    auto _call = [&] { return func(); };
+                    base_type::invoke(prom, _call);
+                }
+                else
+                {
+                    auto _call = [&] { return func(res.unwrap()); };
+                    base_type::invoke(prom, _call);
+                }
+            }
+        };
+
+        // Continuation taking the whole result
+        template <typename Res, typename Func>
+        requires (Invocable<Func&, Res&>)
+        struct then_promise<Res, Func>
+            : task_promise<decay_t<decltype(declval<Func&>()(declval<Res&>()))>>
         {
-            auto _res = _func(forward<Args>(args)...).unwrap();
-            
-            if (_res.is_ok())
+            using base_type = task_promise<
+                decay_t<decltype(declval<Func&>()(declval<Res&>()))>
+            >;
+
+            static inline void invoke(
+                typename base_type::type& prom, Func& func, Res& res)
             {
-                _promise.set_value();
+                auto _call = [&] { return func(res); };
+                base_type::invoke(prom, _call);
             }
-            else
+        };
+
+        struct future_access
+        {
+            template <typename T, typename Err>
+            static inline void defer(future<T, Err>& fut, deferred_call* call)
             {
-                _promise.set_error(_res.unwrap_err());
+                delete exchange(fut._deferred, call);
             }
-        }
 
-        inline bool valid() const
+            template <typename T, typename Err>
+            static inline void attach(
+                future<T, Err>& fut,
+                continuation<promise_data_res_type<T, Err>>* next)
+            {
+                fut._run_deferred();
+                auto _data = move(fut._promise_ptr);
+                fut._is_valid = false;
+                _data->attach(next);
+            }
+        };
+
+        // Wraps func(args...) so that running it fulfills
+        // a promise, sink receives the wrapped call
+        template <typename Sink, typename Func, typename... Args>
+        inline auto package_call(Sink&& sink, Func&& func, Args&&... args)
         {
-            return static_cast<bool>(_func) && get_future().valid();
+            using res_type = decay_t<decltype(
+                declval<decay_t<Func>&>()(declval<decay_t<Args>&>()...)
+            )>;
+
+            using promise_type = task_promise<res_type>;
+
+            typename promise_type::type _promise;
+            auto _future = _promise.get_future();
+
+            sink([
+                _func = decay_t<Func>{forward<Func>(func)},
+                _args = tuple<decay_t<Args>...>{forward<Args>(args)...},
+                _prom = move(_promise)]() mutable
+            {
+                auto _call = [&]() -> res_type {
+                    return apply(_func, _args);
+                };
+
+                promise_type::invoke(_prom, _call);
+            }, _future);
+
+            return _future;
         }
-    };
+    } // namespace future_detail
 
     template < typename Res, typename... Args > 
     packaged_task(Res(*)(Args...)) -> packaged_task<Res(Args...)>;
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "SharedPtr.hpp"
+
+namespace hsd
+{
+    namespace intrusive_detail
+    {
+        // Embeds the reference count in the object itself, derive T
+        // from it (CRTP). The last release deletes the object as a T,
+        // so T's destructor has to be virtual if it's used as a base
+        template <typename T, typename Policy>
+        class ref_counted
+        {
+        private:
+            mutable typename Policy::count_type _ref_count = 0;
+
+        public:
+            inline ref_counted() = default;
+
+            // Copies are new objects, nobody refers to them yet
+            inline ref_counted(const ref_counted&) {}
+
+            inline ref_counted& operator=(const ref_counted&)
+            {
+                return *this;
+            }
+
+            inline void add_ref() const
+            {
+                Policy::increment(_ref_count);
+            }
+
+            inline void release() const
+            {
+                if (Policy::release(_ref_count))
+                {
+                    delete static_cast<const T*>(this);
+                }
+            }
+
+            inline usize get_count() const
+            {
+                return Policy::load(_ref_count);
+            }
+
+        protected:
+            ~ref_counted() = default;
+        };
+    } // namespace intrusive_detail
+
+    template <typename T>
+    using safe_ref_counted = intrusive_detail::ref_counted<T, shared_detail::safe_count>;
+    template <typename T>
+    using unsafe_ref_counted = intrusive_detail::ref_counted<T, shared_detail::unsafe_count>;
+
+    // Owning pointer to an object that counts its own references
+    // through add_ref() and release(), e.g. by deriving from one of
+    // the ref_counted bases. There's no control block to allocate,
+    // and since the count travels with the object, a raw pointer to
+    // it (like this) can always be turned into another owner
+    template <typename T>
+    class intrusive_ptr
+    {
+    private:
+        T* _ptr = nullptr;
+
+        template <typename U>
+        friend class intrusive_ptr;
+
+        inline void _delete()
+        {
+            if (_ptr != nullptr)
+            {
+                exchange(_ptr, nullptr)->release();
+            }
+        }
+
+    public:
+        using pointer_type = T*;
+        using value_type = T;
+        using reference_type = T&;
+
+        inline intrusive_ptr() = default;
+        inline intrusive_ptr(NullType) {}
+
+        // Set add_ref to false to adopt a reference taken by someone else
+        inline intrusive_ptr(T* ptr, bool add_ref = true)
+            : _ptr{ptr}
+        {
+            if (_ptr != nullptr && add_ref)
+                _ptr->add_ref();
+        }
+
+        inline intrusive_ptr(const intrusive_ptr& other)
+            : intrusive_ptr{other._ptr}
+        {}
+
+        inline intrusive_ptr(intrusive_ptr&& other)
+            : _ptr{exchange(other._ptr, nullptr)}
+        {}
+
+        template <typename U = T>
+        inline intrusive_ptr(const intrusive_ptr<U>& other)
+        requires(shared_detail::ConvertibleDerived<T, U>)
+            : intrusive_ptr{static_cast<T*>(other._ptr)}
+        {}
+
+        template <typename U = T>
+        inline intrusive_ptr(intrusive_ptr<U>&& other)
+        requires(shared_detail::ConvertibleDerived<T, U>)
+            : _ptr{exchange(other._ptr, nullptr)}
+        {}
+
+        inline ~intrusive_ptr()
+        {
+            _delete();
+        }
+
+        inline intrusive_ptr& operator=(NullType)
+        {
+            _delete();
+            return *this;
+        }
+
+        inline intrusive_ptr& operator=(const intrusive_ptr& rhs)
+        {
+            if (rhs._ptr != nullptr)
+                rhs._ptr->add_ref();
+
+            _delete();
+            _ptr = rhs._ptr;
+            return *this;
+        }
+
+        inline intrusive_ptr& operator=(intrusive_ptr&& rhs)
+        {
+            if (this != &rhs)
+            {
+                _delete();
+                _ptr = exchange(rhs._ptr, nullptr);
+            }
+
+            return *this;
+        }
+
+        template <typename U = T>
+        requires(shared_detail::ConvertibleDerived<T, U>)
+        inline intrusive_ptr& operator=(const intrusive_ptr<U>& rhs)
+        {
+            return *this = intrusive_ptr{rhs};
+        }
+
+        template <typename U = T>
+        requires(shared_detail::ConvertibleDerived<T, U>)
+        inline intrusive_ptr& operator=(intrusive_ptr<U>&& rhs)
+        {
+            _delete();
+            _ptr = exchange(rhs._ptr, nullptr);
+            return *this;
+        }
+
+        // Gives up ownership without releasing the reference
+        inline T* detach()
+        {
+            return exchange(_ptr, nullptr);
+        }
+
+        inline bool operator==(const intrusive_ptr& rhs) const
+        {
+            return _ptr == rhs._ptr;
+        }
+
+        inline bool operator!=(const intrusive_ptr& rhs) const
+        {
+            return _ptr != rhs._ptr;
+        }
+
+        inline bool operator==(NullType) const
+        {
+            return _ptr == nullptr;
+        }
+
+        inline bool operator!=(NullType) const
+        {
+            return _ptr != nullptr;
+        }
+
+        inline T* get() const
+        {
+            return _ptr;
+        }
+
+        inline T* operator->() const
+        {
+            return _ptr;
+        }
+
+        inline T& operator*() const
+        {
+            return *_ptr;
+        }
+    };
+
+    template <typename T, typename... Args>
+    static inline intrusive_ptr<T> make_intrusive(Args&&... args)
+    {
+        return intrusive_ptr<T>{new T{forward<Args>(args)...}};
+    }
+} // namespace hsd
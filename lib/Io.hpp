@@ -1,13 +1,16 @@
 #pragma once
 
 #include "FormatGenerator.hpp"
+#include "MappedFile.hpp"
 #include "SStream.hpp"
 
 #if defined(HSD_PLATFORM_WINDOWS)
 #include <windows.h>
 #else
 #include <unistd.h>
+#include <limits.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <string.h>
 #include <errno.h>
@@ -29,6 +32,12 @@ namespace hsd
 
     namespace io_detail
     {
+        struct io_vec
+        {
+            void* iov_base;
+            usize iov_len;
+        };
+
         static inline auto file_error_code()
         {
             return ::GetLastError();
@@ -124,7 +133,12 @@ namespace hsd
 
             inline bool only_write() const
             {
-                return _mode == io_options::write;
+                return _mode == io_options::write || _mode == io_options::append;
+            }
+
+            inline bool is_terminal() const
+            {
+                return GetFileType(_handle) == FILE_TYPE_CHAR;
             }
 
             inline auto write(const void* data, u64 size)
@@ -147,6 +161,27 @@ namespace hsd
                 return _written;
             }
 
+            // There is no gather write for regular handles,
+            // so the segments are written one after another
+            inline auto write_vectored(io_vec* vecs, usize count)
+            {
+                DWORD _total = 0;
+
+                for (usize _index = 0; _index < count; ++_index)
+                {
+                    auto _written = write(vecs[_index].iov_base, vecs[_index].iov_len);
+
+                    if (_written == static_cast<DWORD>(-1))
+                    {
+                        return _written;
+                    }
+
+                    _total += _written;
+                }
+
+                return _total;
+            }
+
             inline auto read(void* data, u64 size)
             {
                 DWORD _read = 0;
@@ -260,6 +295,8 @@ namespace hsd
 
     namespace io_detail
     {
+        using io_vec = iovec;
+
         static inline auto file_error_code()
         {
             return errno;
@@ -325,7 +362,12 @@ namespace hsd
 
             inline bool only_write() const
             {
-                return _mode == io_options::write;
+                return _mode == io_options::write || _mode == io_options::append;
+            }
+
+            inline bool is_terminal() const
+            {
+                return isatty(_fd) == 1;
             }
 
             inline isize write(const char* data, usize size)
@@ -333,6 +375,45 @@ namespace hsd
                 return ::write(_fd, data, size);
             }
 
+            // Writes every segment, resuming after partial writes
+            inline isize write_vectored(io_vec* vecs, usize count)
+            {
+                isize _total = 0;
+
+                while (count != 0)
+                {
+                    isize _written = ::writev(
+                        _fd, vecs, static_cast<i32>(count < IOV_MAX ? count : IOV_MAX)
+                    );
+
+                    if (_written == -1)
+                    {
+                        if (errno == EINTR)
+                            continue;
+
+                        return -1;
+                    }
+
+                    _total += _written;
+                    
+                    for (usize _rest = static_cast<usize>(_written); count != 0;)
+                    {
+                        if (_rest < vecs->iov_len)
+                        {
+                            vecs->iov_base = static_cast<char*>(vecs->iov_base) + _rest;
+                            vecs->iov_len -= _rest;
+                            break;
+                        }
+
+                        _rest -= vecs->iov_len;
+                        ++vecs;
+                        --count;
+                    }
+                }
+
+                return _total;
+            }
+
             inline isize read(char* data, usize size)
             {
                 return ::read(_fd, data, size);
@@ -342,9 +423,9 @@ namespace hsd
                 const char* path, io_options mode)
             {
                 file_handler fd;
-                fd._fd = ::open(path, static_cast<i32>(mode));
+                fd._fd = ::open(path, static_cast<i32>(mode), 0644);
                 fd._mode = mode;
-                fd.is_external = true;
+                fd.is_external = false;
 
                 return fd;
             }
@@ -354,7 +435,7 @@ namespace hsd
                 file_handler fd;
                 fd._fd = 0;
                 fd._mode = io_options::read;
-                fd.is_external = false;
+                fd.is_external = true;
 
                 return fd;
             }
@@ -364,7 +445,7 @@ namespace hsd
                 file_handler fd;
                 fd._fd = 1;
                 fd._mode = io_options::write;
-                fd.is_external = false;
+                fd.is_external = true;
 
                 return fd;
             }
@@ -374,7 +455,7 @@ namespace hsd
                 file_handler fd;
                 fd._fd = 2;
                 fd._mode = io_options::write;
-                fd.is_external = false;
+                fd.is_external = true;
 
                 return fd;
             }
@@ -382,30 +463,203 @@ namespace hsd
     } // namespace io_detail
     #endif
 
+    namespace io_detail
+    {
+        // Data referenced in place, to be written
+        // after `offset` bytes of the buffered output
+        struct io_segment
+        {
+            usize offset;
+            const char* data;
+            usize size;
+        };
+
+        // Formats small pieces into the buffer and
+        // records the long strings as external segments
+        class vectored_writer : public format_detail::writer<char>
+        {
+        private:
+            vector<io_segment>& _segments;
+            usize _threshold;
+
+        public:
+            inline vectored_writer(char* dest, usize space, 
+                vector<io_segment>& segments, usize threshold)
+                : writer{dest, space}, _segments{segments}, _threshold{threshold}
+            {}
+
+            inline void put_external(const char* str, usize size)
+            {
+                if (size < _threshold)
+                {
+                    put(str, size);
+                }
+                else
+                {
+                    _segments.push_back({_length, str, size});
+                }
+            }
+        };
+    } // namespace io_detail
+
+    enum class io_buffering
+    {
+        full, // written out when the buffer fills up
+        line, // written out after every new line
+        none  // written out after every print
+    };
+
     class io : private sstream
     {
     private:
         io_detail::file_handler _file;
+        io_buffering _buffering = io_buffering::full;
+        usize _vectored_threshold = 0;
+        hsd::vector<io_detail::io_segment> _segments;
+        hsd::vector<io_detail::io_vec> _vecs;
+        io* _tied = nullptr;
         bool _is_eof = false;
 
-        inline io(io_detail::file_handler&& file)
-            : _file{move(file)}
+        inline io(io_detail::file_handler&& file, 
+            io_buffering buffering = io_buffering::full)
+            : _file{move(file)}, _buffering{buffering}
         {}
 
+        // Runs format(writer) until the output fits into the buffer,
+        // flushing or growing the buffer on the way
+        template <typename Func>
+        inline void _buffered_write(Func&& format)
+        {
+            if (get_stream().capacity() == 0)
+            {
+                get_stream().reserve(default_buffer_size);
+            }
+
+            usize _len = 0;
+
+            while (true)
+            {
+                usize _space = get_stream().capacity() - this->_size;
+                char* _dest = get_stream().data() + this->_size;
+                _segments.clear();
+
+                if (_vectored_threshold != 0)
+                {
+                    io_detail::vectored_writer _out{
+                        _dest, _space, _segments, _vectored_threshold
+                    };
+
+                    format(_out);
+                    _len = _out.finish();
+                }
+                else
+                {
+                    format_detail::writer<char> _out{_dest, _space};
+                    format(_out);
+                    _len = _out.finish();
+                }
+
+                if (_len < _space)
+                {
+                    break;
+                }
+                else if (this->_size != 0)
+                {
+                    flush().unwrap();
+                }
+                else
+                {
+                    get_stream().reserve(_len + 1);
+                }
+            }
+
+            this->_size += _len;
+
+            if (_segments.size() != 0)
+            {
+                // The referenced strings may not outlive this call
+                _flush_vectored(this->_size - _len).unwrap();
+            }
+            else if (_buffering == io_buffering::none)
+            {
+                flush().unwrap();
+            }
+            else if (_buffering == io_buffering::line)
+            {
+                for (usize _index = this->_size - _len; _index < this->_size; ++_index)
+                {
+                    if (get_stream().data()[_index] == '\n')
+                    {
+                        flush().unwrap();
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Writes the buffer with the external segments of the
+        // last print (starting at `start`) with a single writev
+        inline result<reference<io>, runtime_error> _flush_vectored(usize start)
+        {
+            if (_file.is_open() == false)
+            {
+                return runtime_error {
+                    "Cannot write file. It is not open"
+                };
+            }
+
+            char* _buf = get_stream().data();
+            usize _pos = 0;
+            _vecs.clear();
+
+            auto _push = [&](const char* data, usize size)
+            {
+                if (size != 0)
+                    _vecs.push_back({const_cast<char*>(data), size});
+            };
+
+            for (auto& _segment : _segments)
+            {
+                _push(_buf + _pos, start + _segment.offset - _pos);
+                _push(_segment.data, _segment.size);
+                _pos = start + _segment.offset;
+            }
+
+            _push(_buf + _pos, this->_size - _pos);
+            _segments.clear();
+
+            auto _sz = _file.write_vectored(_vecs.data(), _vecs.size());
+            this->_size = 0;
+            _buf[0] = '\0';
+
+            if (_sz == static_cast<decltype(_sz)>(-1))
+            {
+                return runtime_error {io_detail::file_error_msg()};
+            }
+
+            return {*this};
+        }
+
     public:
+        static constexpr usize default_buffer_size = 4096;
+        static constexpr usize default_vectored_threshold = 1024;
 
         inline io(const io&) = delete;
         inline io& operator=(const io&) = delete;
 
         inline io(io&& other)
-            : sstream{move(other.get_stream())}, 
-            _file{move(other._file)}, _is_eof{other._is_eof} 
+            : sstream{move(other.get_stream())}, _file{move(other._file)}, 
+            _buffering{other._buffering}, _vectored_threshold{other._vectored_threshold},
+            _tied{other._tied}, _is_eof{other._is_eof} 
         {}
 
         inline io& operator=(io&& rhs)
         {
             swap(get_stream(), rhs.get_stream());
             swap(_file, rhs._file);
+            swap(_buffering, rhs._buffering);
+            swap(_vectored_threshold, rhs._vectored_threshold);
+            swap(_tied, rhs._tied);
             swap(_is_eof, rhs._is_eof);
 
             return *this;
@@ -413,6 +667,13 @@ namespace hsd
 
         inline ~io()
         {
+            // Pending output of the standard streams is
+            // written out at exit by their static instances
+            if (_file.is_open() && _file.only_write() && this->_size != 0)
+            {
+                [[maybe_unused]] auto _res = flush();
+            }
+
             close();
         }
 
@@ -431,6 +692,46 @@ namespace hsd
             return _is_eof;
         }
 
+        inline io_buffering get_buffering() const
+        {
+            return _buffering;
+        }
+
+        inline io& set_buffering(io_buffering buffering)
+        {
+            _buffering = buffering;
+            return *this;
+        }
+
+        inline usize get_vectored_threshold() const
+        {
+            return _vectored_threshold;
+        }
+
+        // Strings of at least `threshold` characters are written in
+        // place with the buffered output (using writev), instead of
+        // being copied into the buffer first. Such a print returns
+        // only after everything was written. Zero disables it
+        inline io& set_vectored_threshold(
+            usize threshold = default_vectored_threshold)
+        {
+            _vectored_threshold = threshold;
+            return *this;
+        }
+
+        inline io* get_tied() const
+        {
+            return _tied;
+        }
+
+        // The tied stream is flushed before every read, so a prompt
+        // without a new line shows up before waiting for the answer
+        inline io& tie(io* stream)
+        {
+            _tied = stream;
+            return *this;
+        }
+
         inline void close()
         {
             _file.close();
@@ -451,8 +752,14 @@ namespace hsd
                 };
             }
 
-            auto _sz = _file.write(get_stream().data(), get_stream().size());
-            get_stream().clear();
+            if (this->_size == 0)
+            {
+                return {*this};
+            }
+
+            auto _sz = _file.write(get_stream().data(), this->_size);
+            this->_size = 0;
+            get_stream().data()[0] = '\0';
             
             if (_sz == static_cast<decltype(_sz)>(-1))
             {
@@ -477,6 +784,11 @@ namespace hsd
                 };
             }
 
+            if (_tied != nullptr)
+            {
+                [[maybe_unused]] auto _res = _tied->flush();
+            }
+
             auto _sz = _file.read(
                 get_stream().data() + this->_size, 
                 get_stream().capacity() - this->_size - 1
@@ -530,93 +842,54 @@ namespace hsd
 
         template < basic_string_literal fmt, typename... Args >
         inline io& print(Args&&... args)
-        {   
-            using char_type = typename decltype(fmt)::char_type;
-            using tup_type = type_tuple<Args...>;
-
-            static constexpr auto _fmt_buf =
-                parse_literal<fmt, sizeof...(Args) + 1>().unwrap();
-
-            static constexpr auto _last = _fmt_buf[tup_type::size];
-            static constexpr auto _last_fmt = 
-                format_literal<char_type, _last.length + 1>
-                {
-                    .format = {_last.format, _last.length},
-                    .base = _last.base
-                };
-
-
+        {
             static_assert(
-                _fmt_buf.size() == sizeof...(Args) + 1, 
-                "The number of arguments doesn't match"
+                is_same<typename decltype(fmt)::char_type, char>::value, 
+                "Unsupported character type"
             );
 
-            if constexpr (sizeof...(Args) != 0)
-            {
-                static constexpr auto _print_fmt =
-                    []<usize... Ints>(index_sequence<Ints...>)
-                    {
-                        constexpr auto _gen_fmt = []<usize I>()
-                        {
-                            constexpr auto _curr_fmt = 
-                                format_literal<char_type, _fmt_buf[I].length + 1>
-                                {
-                                    .format = {_fmt_buf[I].format, _fmt_buf[I].length},
-                                    .base = _fmt_buf[I].base
-                                };
-
-                            
-                            constexpr auto _pretty_fmt = 
-                                format<_curr_fmt, typename tup_type::template type_at<I>>();
-                            
-                            constexpr auto _sz = 
-                                basic_cstring<char_type>::length(_pretty_fmt.data);
-                            
-                            static_assert(_pretty_fmt.size() == _sz + 1);
-                            return _pretty_fmt;
-                        };
-
-                        return ((_gen_fmt.template operator()<Ints>()) + ...);
-                    }(make_index_sequence<tup_type::size>{}) + _last_fmt.format;
-
-                const tuple _args = (make_args(args) + ...);
-
-                [&]<usize... Ints>(index_sequence<Ints...>)
-                {
-                    this->_size += snprintf(
-                        get_stream().data() + this->_size, 
-                        get_stream().capacity() - this->_size, 
-                        _print_fmt.data, _args.template get<Ints>()...
-                    );
-                }(make_index_sequence<decltype(_args)::size()>{});
-            }
-            else
+            _buffered_write([&](auto& out)
             {
-                this->_size += snprintf(
-                    get_stream().data() + this->_size, 
-                    get_stream().capacity() - this->_size, 
-                    "%s", _last_fmt.format.data
-                );
-            }
+                format_detail::write_format<fmt>(out, args...);
+            });
 
             return *this;
         }
 
         static inline auto& cout()
         {
-            static io _cout{io_detail::file_handler::get_stdout()};
+            static io _cout = []
+            {
+                auto _file = io_detail::file_handler::get_stdout();
+                
+                auto _buffering = _file.is_terminal() ? 
+                    io_buffering::line : io_buffering::full;
+
+                return io{move(_file), _buffering};
+            }();
+
             return _cout;
         }
 
         static inline auto& cerr()
         {
-            static io _cerr{io_detail::file_handler::get_stderr()};
+            static io _cerr{
+                io_detail::file_handler::get_stderr(), io_buffering::none
+            };
+
             return _cerr;
         }
 
         static inline auto& cin()
         {
-            static io _cin{io_detail::file_handler::get_stdin()};
+            static io _cin = []
+            {
+                io _in{io_detail::file_handler::get_stdin()};
+                _in.tie(&cout());
+
+                return _in;
+            }();
+
             return _cin;
         }
 
@@ -635,6 +908,15 @@ namespace hsd
 
             return io{move(_file)};
         }
+
+        // Whole-file read-only access without copying
+        // through the stream buffer, see mapped_file
+        static inline auto map_file(
+            const char* file_path, mapped_access access = mapped_access::sequential)
+            -> result<mapped_file, runtime_error>
+        {
+            return mapped_file::open(file_path, access);
+        }
     };
 
     namespace format_literals
@@ -649,64 +931,42 @@ namespace hsd
     template <typename T, typename... Args>
     static void print(T&&, Args&&... args)
     {
-        if (hsd::io::cout().get_stream().capacity() == 0)
-        {
-            hsd::io::cout().get_stream().reserve(1024);
-        }
-
         static constexpr T _func{};
 
         hsd::io::cout().template 
-        print<_func()>(hsd::forward<Args>(args)...).
-        flush().
-        unwrap();
+        print<_func()>(hsd::forward<Args>(args)...);
     }
 
     template <typename T, typename... Args>
     static void println(T&&, Args&&... args)
     {
-        if (hsd::io::cout().get_stream().capacity() == 0)
-        {
-            hsd::io::cout().get_stream().reserve(1024);
-        }
-
         static constexpr T _func{};
 
         hsd::io::cout().template 
-        print<_func() + "\n">(hsd::forward<Args>(args)...).
-        flush().
-        unwrap();
+        print<_func() + "\n">(hsd::forward<Args>(args)...);
     }
 
     template <typename T, typename... Args>
     static void print_err(T&&, Args&&... args)
     {
-        if (hsd::io::cerr().get_stream().capacity() == 0)
-        {
-            hsd::io::cerr().get_stream().reserve(1024);
-        }
-
         static constexpr T _func{};
 
         hsd::io::cerr().template 
-        print<_func()>(hsd::forward<Args>(args)...).
-        flush().
-        unwrap();
+        print<_func()>(hsd::forward<Args>(args)...);
     }
 
     template <typename T, typename... Args>
     static void println_err(T&&, Args&&... args)
     {
-        if (hsd::io::cerr().get_stream().capacity() == 0)
-        {
-            hsd::io::cerr().get_stream().reserve(1024);
-        }
-
         static constexpr T _func{};
 
         hsd::io::cerr().template 
-        print<_func() + "\n">(hsd::forward<Args>(args)...).
-        flush().
-        unwrap();
+        print<_func() + "\n">(hsd::forward<Args>(args)...);
+    }
+
+    static inline void flush()
+    {
+        hsd::io::cout().flush().unwrap();
+        hsd::io::cerr().flush().unwrap();
     }
-} // namespace hsd
+} // namespace hsd
\ No newline at end of file
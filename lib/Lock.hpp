@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Atomic.hpp"
+#include "ParkingLot.hpp"
 #include "Result.hpp"
 
 #include <limits.h>
@@ -27,6 +28,11 @@ namespace hsd
         {
             WakeByAddressAll(value);
         }
+
+        static inline void wake_one(void* value)
+        {
+            WakeByAddressSingle(value);
+        }
     } // namespace futex_detail
 
     namespace mutex_detail
@@ -79,6 +85,14 @@ namespace hsd
                 1, INT_MAX, nullptr, nullptr, 0
             );
         }
+
+        static inline void wake_one(void* value)
+        {
+            syscall(
+                SYS_futex, reinterpret_cast<u32*>(value), 
+                1, 1, nullptr, nullptr, 0
+            );
+        }
     } // namespace futex_detail
     #endif
 
@@ -115,7 +129,8 @@ namespace hsd
     } // namespace mutex_detail
     #endif
 
-    #if defined(HSD_PLATFORM_WINDOWS) || (defined(HSD_PLATFORM_POSIX) && defined(SYS_futex))
+    #if !defined(HSD_FORCE_PARKING_LOT) && (defined(HSD_PLATFORM_WINDOWS) || \
+        (defined(HSD_PLATFORM_POSIX) && defined(SYS_futex)))
     struct futex_lock
     {
         inline bool wait_on(u32& addr, u32 cmp_addr)
@@ -127,60 +142,34 @@ namespace hsd
         {
             futex_detail::wake(&addr);
         }
+
+        inline void wake_one(u32& addr)
+        {
+            futex_detail::wake_one(&addr);
+        }
     };
     #else
-    class futex_lock
+    // Without a native futex the waits go through the parking lot,
+    // define HSD_FORCE_PARKING_LOT to use it everywhere
+    struct futex_lock
     {
-    private:
-        atomic_u32 _lock;
-
-    public:
-        inline futex_lock()
-            : _lock{0}
-        {}
-
-        inline futex_lock(const futex_lock&) = delete;
-        inline futex_lock &operator=(const futex_lock&) = delete;
-
-        inline futex_lock(futex_lock&& other)
-            : _lock{other._lock.load()}
+        inline bool wait_on(u32& addr, u32 cmp_addr)
         {
-            other._lock = 0;
-        }
+            parking_lot::park(&addr, [&addr, cmp_addr] {
+                return __atomic_load_n(&addr, __ATOMIC_SEQ_CST) == cmp_addr;
+            });
 
-        inline futex_lock& operator=(futex_lock&& rhs)
-        {
-            rhs._lock = _lock.exchange(
-                rhs._lock.load(), memory_order_acquire
-            );
-            return *this;
+            return true;
         }
 
-        inline bool wait_on(u32& addr, u32 cmp_addr)
+        inline void wake_up(u32& addr)
         {
-            if (_lock.load() == 0)
-            {
-                _lock.store(addr);
-            }
-            if (addr != cmp_addr)
-            {
-                return true;
-            }
-            else
-            {
-                while (_lock.load(memory_order_acquire))
-                    ;
-
-                return true;
-            }
+            parking_lot::unpark_all(&addr);
         }
 
-        inline void wake_up(u32& addr)
+        inline void wake_one(u32& addr)
         {
-            if (_lock.load() != addr)
-            {
-                _lock.store(0, memory_order_release);
-            }
+            parking_lot::unpark_one(&addr);
         }
     };
     #endif
@@ -237,8 +226,9 @@ namespace hsd
                 {
                     if (expected & waitersBit)
                     {
-                        if (!waiter.wait_on(reinterpret_cast<u32&>(_lock), expected))
-                            hsd::panic("waiter.wait_on() failed");
+                        // Fails when the lock changed before going to
+                        // sleep (or on a signal), either way just retry
+                        waiter.wait_on(reinterpret_cast<u32&>(_lock), expected);
 
                         expected = 0;
                     }
@@ -322,6 +312,363 @@ namespace hsd
         }
     };
 
+    // Reader-writer lock on a single futex word. Readers get in with
+    // one atomic add, a waiting writer stops new readers from getting
+    // in, so a steady stream of readers can't starve the writers
+    class shared_mutex
+    {
+    private:
+        static constexpr u32 _writer = 1u << 31;
+        static constexpr u32 _writer_waiting = 1u << 30;
+        static constexpr u32 _sleepers = 1u << 29;
+        static constexpr u32 _readers_mask = _sleepers - 1;
+
+        atomic_u32 _state;
+        static inline futex_lock _waiter{};
+
+        inline u32& _word()
+        {
+            return reinterpret_cast<u32&>(_state);
+        }
+
+        // Flags the word as having sleepers, then sleeps
+        // for as long as it still holds the same value
+        inline void _sleep(u32 state)
+        {
+            if ((state & _sleepers) == 0)
+            {
+                if (!_state.compare_exchange_strong(
+                    state, state | _sleepers,
+                    memory_order_relaxed, memory_order_relaxed))
+                {
+                    return;
+                }
+
+                state |= _sleepers;
+            }
+
+            _waiter.wait_on(_word(), state);
+        }
+
+        inline void _wake()
+        {
+            _state.fetch_and(~_sleepers, memory_order_relaxed);
+            _waiter.wake_up(_word());
+        }
+
+        inline void _release_reader()
+        {
+            u32 _prev = _state.fetch_sub(1, memory_order_release);
+
+            // The last reader out lets a waiting writer in
+            if ((_prev & _readers_mask) == 1 && (_prev & _sleepers))
+            {
+                _wake();
+            }
+        }
+
+        inline void _lock_shared_slow()
+        {
+            u32 _prev = _state.fetch_sub(1, memory_order_relaxed);
+
+            // Taking back the fast path's add. Only a writer still
+            // waiting to get in can have slept on it, never one
+            // that already holds the lock
+            if ((_prev & _readers_mask) == 1 && (_prev & _sleepers) && (_prev & _writer) == 0)
+            {
+                _wake();
+            }
+
+            while (true)
+            {
+                u32 _current = _state.load(memory_order_relaxed);
+
+                if ((_current & (_writer | _writer_waiting)) == 0)
+                {
+                    if (_state.compare_exchange_strong(
+                        _current, _current + 1,
+                        memory_order_acquire, memory_order_relaxed))
+                    {
+                        return;
+                    }
+                }
+                else
+                {
+                    _sleep(_current);
+                }
+            }
+        }
+
+        inline void _lock_slow()
+        {
+            while (true)
+            {
+                u32 _current = _state.load(memory_order_relaxed);
+
+                if ((_current & (_writer | _readers_mask)) == 0)
+                {
+                    u32 _desired = (_current | _writer) & ~_writer_waiting;
+
+                    if (_state.compare_exchange_strong(
+                        _current, _desired,
+                        memory_order_acquire, memory_order_relaxed))
+                    {
+                        return;
+                    }
+                }
+                else if ((_current & _writer_waiting) == 0)
+                {
+                    _state.compare_exchange_strong(
+                        _current, _current | _writer_waiting,
+                        memory_order_relaxed, memory_order_relaxed
+                    );
+                }
+                else
+                {
+                    _sleep(_current);
+                }
+            }
+        }
+
+    public:
+        inline shared_mutex()
+            : _state{0}
+        {}
+
+        inline shared_mutex(const shared_mutex&) = delete;
+        inline shared_mutex& operator=(const shared_mutex&) = delete;
+
+        inline void lock()
+        {
+            u32 _expected = 0;
+
+            if (!_state.compare_exchange_strong(
+                _expected, _writer, memory_order_acquire, memory_order_relaxed))
+            {
+                _lock_slow();
+            }
+        }
+
+        inline bool try_lock()
+        {
+            u32 _current = _state.load(memory_order_relaxed);
+
+            if ((_current & (_writer | _readers_mask)) != 0)
+                return false;
+
+            return _state.compare_exchange_strong(
+                _current, (_current | _writer) & ~_writer_waiting,
+                memory_order_acquire, memory_order_relaxed
+            );
+        }
+
+        inline void unlock()
+        {
+            u32 _prev = _state.fetch_and(
+                ~(_writer | _sleepers), memory_order_release
+            );
+
+            if (_prev & _sleepers)
+            {
+                _waiter.wake_up(_word());
+            }
+        }
+
+        inline void lock_shared()
+        {
+            u32 _prev = _state.fetch_add(1, memory_order_acquire);
+
+            if ((_prev & (_writer | _writer_waiting)) != 0)
+            {
+                _lock_shared_slow();
+            }
+        }
+
+        inline bool try_lock_shared()
+        {
+            u32 _current = _state.load(memory_order_relaxed);
+
+            if ((_current & (_writer | _writer_waiting)) != 0)
+                return false;
+
+            return _state.compare_exchange_strong(
+                _current, _current + 1,
+                memory_order_acquire, memory_order_relaxed
+            );
+        }
+
+        inline void unlock_shared()
+        {
+            _release_reader();
+        }
+
+        inline auto* native_handle()
+        {
+            return &_state;
+        }
+    };
+
+    struct adaptive_mutex_stats
+    {
+        u64 contended;      // lock() calls that didn't get in right away
+        u64 spin_acquired;  // ... and got in while spinning
+        u64 parked;         // times a thread went to sleep on the futex
+        u32 spin_limit;     // current self-tuned spin budget
+    };
+
+    // Spins for a while before going to sleep on the futex, with
+    // the spin budget tuned after how long the owners hold it,
+    // so that short critical sections never pay for a syscall
+    // and long ones don't burn cycles on the waiters
+    class adaptive_mutex
+    {
+    public:
+        // Bounds of the self-tuned spin budget
+        static constexpr u32 min_spins = 16;
+        static constexpr u32 max_spins = 4096;
+
+    private:
+        static constexpr u32 _unlocked = 0;
+        static constexpr u32 _locked = 1;
+        static constexpr u32 _contended = 2;
+
+        static constexpr u32 _max_backoff = 64;
+
+        atomic_u32 _state;
+        atomic_u32 _spin_limit;
+        atomic_u64 _contended_count;
+        atomic_u64 _spin_count;
+        atomic_u64 _park_count;
+        static inline futex_lock _waiter{};
+
+        inline u32& _word()
+        {
+            return reinterpret_cast<u32&>(_state);
+        }
+
+        inline bool _try_spin()
+        {
+            u32 _limit = _spin_limit.load(memory_order_relaxed);
+            u32 _budget = _limit * 2 < max_spins ? _limit * 2 : max_spins;
+            u32 _backoff = 1;
+            u32 _spent = 0;
+
+            while (_spent < _budget)
+            {
+                // Test before test-and-set, only try when it looks free
+                if (_state.load(memory_order_relaxed) == _unlocked)
+                {
+                    u32 _expected = _unlocked;
+
+                    if (_state.compare_exchange_strong(
+                        _expected, _locked,
+                        memory_order_acquire, memory_order_relaxed))
+                    {
+                        // Move the budget an eighth of the way
+                        // towards what it actually took to get in
+                        i32 _delta = static_cast<i32>(_spent) - static_cast<i32>(_limit);
+                        u32 _tuned = static_cast<u32>(static_cast<i32>(_limit) + _delta / 8);
+
+                        // The last backoff may overshoot the budget
+                        _spin_limit.store(
+                            _tuned < min_spins ? min_spins :
+                            _tuned > max_spins ? max_spins : _tuned,
+                            memory_order_relaxed
+                        );
+                        return true;
+                    }
+                }
+
+                for (u32 _pause = 0; _pause < _backoff; _pause++)
+                {
+                    cpu_relax();
+                }
+
+                _spent += _backoff;
+                _backoff = _backoff * 2 < _max_backoff ? _backoff * 2 : _max_backoff;
+            }
+
+            // Didn't pay off, spin less next time
+            u32 _shrunk = _limit - _limit / 8;
+            _spin_limit.store(
+                _shrunk > min_spins ? _shrunk : min_spins, memory_order_relaxed
+            );
+
+            return false;
+        }
+
+        inline void _lock_slow()
+        {
+            _contended_count.fetch_add(1, memory_order_relaxed);
+
+            if (_try_spin())
+            {
+                _spin_count.fetch_add(1, memory_order_relaxed);
+                return;
+            }
+
+            // From here on the lock is marked as contended, so
+            // that whoever unlocks it knows to wake somebody up
+            while (_state.exchange(_contended, memory_order_acquire) != _unlocked)
+            {
+                _park_count.fetch_add(1, memory_order_relaxed);
+                _waiter.wait_on(_word(), _contended);
+            }
+        }
+
+    public:
+        inline adaptive_mutex()
+            : _state{_unlocked}, _spin_limit{min_spins * 4},
+            _contended_count{0}, _spin_count{0}, _park_count{0}
+        {}
+
+        inline adaptive_mutex(const adaptive_mutex&) = delete;
+        inline adaptive_mutex& operator=(const adaptive_mutex&) = delete;
+
+        inline void lock()
+        {
+            u32 _expected = _unlocked;
+
+            if (!_state.compare_exchange_strong(
+                _expected, _locked, memory_order_acquire, memory_order_relaxed))
+            {
+                _lock_slow();
+            }
+        }
+
+        inline bool try_lock()
+        {
+            u32 _expected = _unlocked;
+
+            return _state.compare_exchange_strong(
+                _expected, _locked, memory_order_acquire, memory_order_relaxed
+            );
+        }
+
+        inline void unlock()
+        {
+            if (_state.exchange(_unlocked, memory_order_release) == _contended)
+            {
+                _waiter.wake_one(_word());
+            }
+        }
+
+        inline adaptive_mutex_stats stats() const
+        {
+            return {
+                _contended_count.load(memory_order_relaxed),
+                _spin_count.load(memory_order_relaxed),
+                _park_count.load(memory_order_relaxed),
+                _spin_limit.load(memory_order_relaxed)
+            };
+        }
+
+        inline auto* native_handle()
+        {
+            return &_state;
+        }
+    };
+
     class spin
     {
     private:
@@ -333,7 +680,12 @@ namespace hsd
         inline void lock()
         {
             while (_spin.test_and_set(memory_order_acquire))
-                ;
+            {
+                // Wait on a plain load so the cache line isn't
+                // bounced around by the test_and_set writes
+                while (_spin.test(memory_order_relaxed))
+                    cpu_relax();
+            }
         }
 
         inline bool try_lock()
@@ -535,7 +887,7 @@ namespace hsd
 
         inline Mutex* get_mutex() const
         {
-            return &_mutex;
+            return _mutex;
         }
 
         inline bool is_locked()
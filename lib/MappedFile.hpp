@@ -0,0 +1,457 @@
+#pragma once
+
+#include "_SStreamDetail.hpp"
+#include "Span.hpp"
+#include "String.hpp"
+#include "Vector.hpp"
+
+#if defined(HSD_PLATFORM_WINDOWS)
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace hsd
+{
+    // Access pattern hint forwarded to the kernel for mapped files
+    enum class mapped_access
+    {
+        normal,
+        sequential,
+        random
+    };
+
+    namespace mapped_detail
+    {
+        #if defined(HSD_PLATFORM_POSIX)
+        static inline i32 to_advice(mapped_access access)
+        {
+            switch (access)
+            {
+                case mapped_access::sequential:
+                    return MADV_SEQUENTIAL;
+                case mapped_access::random:
+                    return MADV_RANDOM;
+                default:
+                    return MADV_NORMAL;
+            }
+        }
+        #else
+        static inline DWORD to_flags(mapped_access access)
+        {
+            switch (access)
+            {
+                case mapped_access::sequential:
+                    return FILE_FLAG_SEQUENTIAL_SCAN;
+                case mapped_access::random:
+                    return FILE_FLAG_RANDOM_ACCESS;
+                default:
+                    return FILE_ATTRIBUTE_NORMAL;
+            }
+        }
+        #endif
+    } // namespace mapped_detail
+
+    // Read-only view of a whole file. Regular files are mapped into
+    // memory, anything that can't be mapped (pipes, terminals, character
+    // devices) is drained into an owned buffer with plain reads instead
+    class mapped_file
+    {
+    private:
+        static constexpr char _default_seps[] = " \t\n\r";
+        const char* _separators = _default_seps;
+
+        const char* _data = nullptr;
+        usize _size = 0;
+        usize _cursor = 0;
+        bool _is_mapped = false;
+        hsd::vector<char> _buffer;
+
+        #if defined(HSD_PLATFORM_WINDOWS)
+        HANDLE _mapping = nullptr;
+        #endif
+
+        inline void _unmap()
+        {
+            #if defined(HSD_PLATFORM_POSIX)
+            if (_is_mapped == true)
+                munmap(const_cast<char*>(_data), _size);
+            #else
+            if (_is_mapped == true)
+                UnmapViewOfFile(_data);
+            if (_mapping != nullptr)
+                CloseHandle(_mapping);
+
+            _mapping = nullptr;
+            #endif
+
+            _data = nullptr;
+            _size = 0;
+            _cursor = 0;
+            _is_mapped = false;
+        }
+
+        inline bool _is_separator(char ch) const
+        {
+            return ch != '\0' && cstring::find(_separators, ch) != nullptr;
+        }
+
+        #if defined(HSD_PLATFORM_POSIX)
+        inline option_err<runtime_error> _read_all(i32 fd)
+        {
+            constexpr usize _chunk_size = 64 * 1024;
+            usize _filled = 0;
+
+            while (true)
+            {
+                if (_buffer.size() - _filled < _chunk_size)
+                {
+                    _buffer.resize(_buffer.size() * 2 + _chunk_size);
+                }
+
+                auto _sz = ::read(
+                    fd, _buffer.data() + _filled, _buffer.size() - _filled
+                );
+
+                if (_sz == 0)
+                {
+                    break;
+                }
+                else if (_sz == -1)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    return runtime_error{"Couldn't read from file"};
+                }
+
+                _filled += static_cast<usize>(_sz);
+            }
+
+            _buffer.resize(_filled);
+            _data = _buffer.data();
+            _size = _buffer.size();
+            return {};
+        }
+        #else
+        inline option_err<runtime_error> _read_all(HANDLE handle)
+        {
+            constexpr usize _chunk_size = 64 * 1024;
+            usize _filled = 0;
+
+            while (true)
+            {
+                if (_buffer.size() - _filled < _chunk_size)
+                {
+                    _buffer.resize(_buffer.size() * 2 + _chunk_size);
+                }
+
+                DWORD _sz = 0;
+
+                auto _res = ReadFile(
+                    handle, _buffer.data() + _filled,
+                    static_cast<DWORD>(_buffer.size() - _filled),
+                    &_sz, nullptr
+                );
+
+                if (!_res && GetLastError() != ERROR_BROKEN_PIPE)
+                    return runtime_error{"Couldn't read from file"};
+
+                if (_sz == 0)
+                    break;
+
+                _filled += _sz;
+            }
+
+            _buffer.resize(_filled);
+            _data = _buffer.data();
+            _size = _buffer.size();
+            return {};
+        }
+        #endif
+
+    public:
+        inline mapped_file() = default;
+        inline mapped_file(const mapped_file&) = delete;
+        inline mapped_file& operator=(const mapped_file&) = delete;
+
+        inline mapped_file(mapped_file&& other)
+        {
+            swap(other);
+        }
+
+        inline mapped_file& operator=(mapped_file&& rhs)
+        {
+            swap(rhs);
+            return *this;
+        }
+
+        inline ~mapped_file()
+        {
+            _unmap();
+        }
+
+        inline void swap(mapped_file& other)
+        {
+            hsd::swap(_separators, other._separators);
+            hsd::swap(_data, other._data);
+            hsd::swap(_size, other._size);
+            hsd::swap(_cursor, other._cursor);
+            hsd::swap(_is_mapped, other._is_mapped);
+            hsd::swap(_buffer, other._buffer);
+
+            #if defined(HSD_PLATFORM_WINDOWS)
+            hsd::swap(_mapping, other._mapping);
+            #endif
+        }
+
+        static inline auto open(
+            const char* filename, mapped_access access = mapped_access::sequential)
+            -> result<mapped_file, runtime_error>
+        {
+            mapped_file _file;
+
+            #if defined(HSD_PLATFORM_POSIX)
+            i32 _fd = ::open(filename, O_RDONLY);
+
+            if (_fd == -1)
+                return runtime_error{"Couldn't open file"};
+
+            struct stat _info;
+
+            if (fstat(_fd, &_info) == -1)
+            {
+                close(_fd);
+                return runtime_error{"Couldn't get the file size"};
+            }
+
+            if (S_ISREG(_info.st_mode) == false)
+            {
+                auto _res = _file._read_all(_fd);
+                close(_fd);
+
+                if (!_res)
+                    return _res.unwrap_err();
+
+                return move(_file);
+            }
+
+            _file._size = static_cast<usize>(_info.st_size);
+
+            if (_file._size != 0)
+            {
+                void* _addr = mmap(nullptr, _file._size, PROT_READ, MAP_PRIVATE, _fd, 0);
+
+                if (_addr == MAP_FAILED)
+                {
+                    close(_fd);
+                    _file._size = 0;
+                    return runtime_error{"Couldn't map file"};
+                }
+
+                madvise(_addr, _file._size, mapped_detail::to_advice(access));
+                _file._data = static_cast<const char*>(_addr);
+                _file._is_mapped = true;
+            }
+
+            close(_fd);
+            #else
+            HANDLE _handle = CreateFileA(
+                filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, mapped_detail::to_flags(access), nullptr
+            );
+
+            if (_handle == INVALID_HANDLE_VALUE)
+                return runtime_error{"Couldn't open file"};
+
+            if (GetFileType(_handle) != FILE_TYPE_DISK)
+            {
+                auto _res = _file._read_all(_handle);
+                CloseHandle(_handle);
+
+                if (!_res)
+                    return _res.unwrap_err();
+
+                return move(_file);
+            }
+
+            LARGE_INTEGER _file_size;
+
+            if (!GetFileSizeEx(_handle, &_file_size))
+            {
+                CloseHandle(_handle);
+                return runtime_error{"Couldn't get the file size"};
+            }
+
+            _file._size = static_cast<usize>(_file_size.QuadPart);
+
+            if (_file._size != 0)
+            {
+                _file._mapping = CreateFileMappingA(
+                    _handle, nullptr, PAGE_READONLY, 0, 0, nullptr
+                );
+
+                if (_file._mapping == nullptr)
+                {
+                    CloseHandle(_handle);
+                    _file._size = 0;
+                    return runtime_error{"Couldn't map file"};
+                }
+
+                _file._data = static_cast<const char*>(
+                    MapViewOfFile(_file._mapping, FILE_MAP_READ, 0, 0, 0)
+                );
+
+                if (_file._data == nullptr)
+                {
+                    CloseHandle(_handle);
+                    _file._size = 0;
+                    return runtime_error{"Couldn't map file"};
+                }
+
+                _file._is_mapped = true;
+            }
+
+            CloseHandle(_handle);
+            #endif
+
+            return move(_file);
+        }
+
+        // Changes the access hint of an already opened mapping,
+        // buffered (non-mapped) files ignore it
+        inline option_err<runtime_error> advise(mapped_access access)
+        {
+            #if defined(HSD_PLATFORM_POSIX)
+            if (_is_mapped == true)
+            {
+                if (madvise(
+                    const_cast<char*>(_data), _size,
+                    mapped_detail::to_advice(access)) == -1)
+                {
+                    return runtime_error{"Couldn't apply the access hint"};
+                }
+            }
+            #else
+            (void)access;
+            #endif
+
+            return {};
+        }
+
+        inline bool is_mapped() const
+        {
+            return _is_mapped;
+        }
+
+        inline bool is_eof()
+        {
+            while (_cursor < _size && _is_separator(_data[_cursor]))
+                _cursor++;
+
+            return _cursor >= _size;
+        }
+
+        inline const char* data() const
+        {
+            return _data;
+        }
+
+        inline usize size() const
+        {
+            return _size;
+        }
+
+        inline string_view view() const
+        {
+            return {_data, _size};
+        }
+
+        inline auto to_span() const
+        {
+            return span<const char*>{_data, _data + _size, _size};
+        }
+
+        inline usize tell() const
+        {
+            return _cursor;
+        }
+
+        inline void seek(usize offset)
+        {
+            _cursor = offset < _size ? offset : _size;
+        }
+
+        inline void set_separators(const char* separators)
+        {
+            _separators = separators;
+        }
+
+        inline const char* get_separators() const
+        {
+            return _separators;
+        }
+
+        // Parses the next separator-delimited token straight
+        // out of the mapping. string_view results point into it
+        template <typename T> 
+        requires (DefaultConstructible<T> || is_same<T, string_view>::value)
+        inline T read_value()
+        {
+            if (is_eof() == true)
+            {
+                if constexpr (is_same<T, string_view>::value)
+                    return string_view{_data + _size, 0};
+                else
+                    return T{};
+            }
+
+            const char* _begin = _data + _cursor;
+
+            while (_cursor < _size && !_is_separator(_data[_cursor]))
+                _cursor++;
+
+            usize _len = static_cast<usize>(_data + _cursor - _begin);
+
+            if constexpr (is_same<T, string_view>::value)
+            {
+                return string_view{_begin, _len};
+            }
+            else if constexpr (is_same<T, string>::value)
+            {
+                return string{_begin, _len};
+            }
+            else
+            {
+                // Numbers and characters are short, so only
+                // the token itself gets NUL-terminated
+                char _stack_buf[128];
+                hsd::vector<char> _heap_buf;
+                char* _token = _stack_buf;
+
+                if (_len >= sizeof(_stack_buf))
+                {
+                    _heap_buf.resize(_len + 1);
+                    _token = _heap_buf.data();
+                }
+
+                for (usize _index = 0; _index < _len; _index++)
+                    _token[_index] = _begin[_index];
+
+                _token[_len] = '\0';
+
+                T value{};
+                const char* _tokens[] = {_token};
+                sstream_detail::stream_parser<char> _parser = 
+                    pair<const char**, usize>{_tokens, usize{1}};
+                _parse_impl(_parser, value).unwrap();
+
+                return value;
+            }
+        }
+    };
+} // namespace hsd
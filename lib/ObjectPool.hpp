@@ -0,0 +1,359 @@
+#pragma once
+
+#include "UniquePtr.hpp"
+#include "Lock.hpp"
+#include "ThreadRegistry.hpp"
+
+#include <new>
+#include <stddef.h>
+
+namespace hsd
+{
+    struct object_pool_stats
+    {
+        u64 created;    // objects built by the pool
+        u64 reused;     // acquires served by an idle object
+        u64 in_use;     // handles currently out
+        u64 idle;       // objects waiting in the pool
+    };
+
+    namespace pool_detail
+    {
+        struct link
+        {
+            link* next;
+        };
+
+        // The object sits right after the link, a handle
+        // finds its way back to the node from the object
+        template <typename T>
+        struct node
+        {
+            link hook;
+            alignas(T) uchar storage[sizeof(T)];
+
+            inline T* get()
+            {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+
+            static inline node* from(T* ptr)
+            {
+                return reinterpret_cast<node*>(
+                    reinterpret_cast<uchar*>(ptr) - offsetof(node, storage)
+                );
+            }
+        };
+
+        // Idle objects of one thread, taken and given back without any
+        // locking. The counters have a single writer, stats() sums them
+        // up over all the records
+        struct alignas(hardware_destructive_interference_size) record
+            : registry_detail::record_base<record>
+        {
+            link* head = nullptr;
+            usize count = 0;
+
+            atomic_u64 created = 0;
+            atomic_u64 reused = 0;
+            atomic_u64 acquired = 0;
+            atomic_u64 released = 0;
+
+            static inline void bump(atomic_u64& counter)
+            {
+                counter.store(counter.load(memory_order_relaxed) + 1, memory_order_relaxed);
+            }
+        };
+
+        // Everything that doesn't depend on the type of the objects:
+        // the per-thread caches and the shared list behind them
+        class pool_core
+        {
+        protected:
+            // Idle objects a thread keeps for itself, past that a
+            // batch of them moves to the shared list, and back when
+            // a thread runs out
+            static constexpr usize _local_limit = 64;
+            static constexpr usize _batch = 32;
+
+            spin _lock;
+            link* _shared = nullptr;
+            thread_registry<pool_core, record> _registry;
+            atomic_u64 _trimmed = 0;
+
+            friend class thread_registry<pool_core, record>;
+
+            inline record& _local()
+            {
+                return _registry.local(this);
+            }
+
+            // Takes a batch from the shared list when the thread ran out
+            inline link* _pop(record& rec)
+            {
+                if (rec.head == nullptr)
+                {
+                    unique_lock<spin> _guard{_lock};
+
+                    while (_shared != nullptr && rec.count < _batch)
+                    {
+                        auto* _node = exchange(_shared, _shared->next);
+                        _node->next = rec.head;
+                        rec.head = _node;
+                        rec.count++;
+                    }
+
+                    if (rec.head == nullptr)
+                        return nullptr;
+                }
+
+                rec.count--;
+                return exchange(rec.head, rec.head->next);
+            }
+
+            inline void _push(record& rec, link* node)
+            {
+                node->next = rec.head;
+                rec.head = node;
+
+                if (++rec.count > _local_limit)
+                {
+                    _give_back(rec, _batch);
+                }
+            }
+
+            // Moves up to count idle objects of rec to the shared list
+            inline void _give_back(record& rec, usize count)
+            {
+                if (rec.head == nullptr || count == 0)
+                    return;
+
+                auto* _first = rec.head;
+                auto* _last = _first;
+                usize _moved = 1;
+
+                while (_moved < count && _last->next != nullptr)
+                {
+                    _last = _last->next;
+                    _moved++;
+                }
+
+                rec.head = exchange(_last->next, nullptr);
+                rec.count -= _moved;
+
+                unique_lock<spin> _guard{_lock};
+                _last->next = _shared;
+                _shared = _first;
+            }
+
+            // The thread is gone, its idle objects are left to the others
+            inline void _thread_exit(record& rec)
+            {
+                _give_back(rec, rec.count);
+            }
+
+            inline pool_core() = default;
+            inline ~pool_core() = default;
+
+        public:
+            inline pool_core(const pool_core&) = delete;
+            inline pool_core& operator=(const pool_core&) = delete;
+
+            inline object_pool_stats stats() const
+            {
+                object_pool_stats _stats{};
+                u64 _acquired = 0;
+                u64 _released = 0;
+
+                for (auto* _rec = _registry.records(); _rec != nullptr; _rec = _rec->next)
+                {
+                    _stats.created += _rec->created.load(memory_order_relaxed);
+                    _stats.reused += _rec->reused.load(memory_order_relaxed);
+                    _acquired += _rec->acquired.load(memory_order_relaxed);
+                    _released += _rec->released.load(memory_order_relaxed);
+                }
+
+                // Other threads keep going while we add up, so
+                // the numbers are only exact once they're done
+                _stats.in_use = _acquired > _released ? _acquired - _released : 0;
+                u64 _alive = _stats.created - _trimmed.load(memory_order_relaxed);
+                _stats.idle = _alive > _stats.in_use ? _alive - _stats.in_use : 0;
+
+                return _stats;
+            }
+        };
+
+        template <typename T>
+        class recycler
+        {
+        public:
+            virtual void recycle(T* ptr) = 0;
+
+        protected:
+            ~recycler() = default;
+        };
+
+        // What a pooled unique_ptr uses instead of an allocator,
+        // it only knows how to hand the object back to its pool
+        template <typename T>
+        class recycling_allocator
+        {
+        private:
+            recycler<T>* _pool = nullptr;
+
+        public:
+            using pointer_type = T*;
+            using value_type = T;
+
+            inline recycling_allocator() = default;
+
+            inline recycling_allocator(recycler<T>* pool)
+                : _pool{pool}
+            {}
+
+            inline void recycle(T* ptr)
+            {
+                _pool->recycle(ptr);
+            }
+        };
+    } // namespace pool_detail
+
+    template <typename T>
+    using pooled_ptr = unique_ptr<T, pool_detail::recycling_allocator>;
+
+    // Keeps objects that are expensive to build (buffers, parser
+    // states) around for the next user. acquire() hands out a
+    // pooled_ptr, which gives the object back when it goes away.
+    // With a reset hook, given back objects stay alive and only get
+    // reset, so whatever memory they own is reused too. Without one,
+    // they're destroyed and only their memory is kept. Each thread
+    // keeps a few idle objects to itself, so acquire and release
+    // don't touch anything shared most of the time. The pool has
+    // to outlive its handles, not the threads that used it
+    template < typename T, template <typename> typename Allocator = allocator >
+    class object_pool final
+        : public pool_detail::pool_core,
+        private pool_detail::recycler<T>
+    {
+    public:
+        using reset_type = void (*)(T&);
+
+    private:
+        using node_type = pool_detail::node<T>;
+        using record = pool_detail::record;
+
+        Allocator<node_type> _alloc;
+        reset_type _reset;
+
+        inline void _free(pool_detail::link* list)
+        {
+            while (list != nullptr)
+            {
+                auto* _node = reinterpret_cast<node_type*>(exchange(list, list->next));
+
+                if (_reset != nullptr)
+                {
+                    _node->get()->~T();
+                }
+
+                _alloc.deallocate(_node, 1).unwrap();
+            }
+        }
+
+        inline pool_detail::recycling_allocator<T> _handle_alloc()
+        {
+            return static_cast<pool_detail::recycler<T>*>(this);
+        }
+
+        virtual void recycle(T* ptr) override
+        {
+            if (_reset != nullptr)
+            {
+                _reset(*ptr);
+            }
+            else
+            {
+                ptr->~T();
+            }
+
+            auto& _rec = _local();
+            record::bump(_rec.released);
+            _push(_rec, &node_type::from(ptr)->hook);
+        }
+
+    public:
+        inline object_pool(reset_type reset = nullptr)
+        requires (DefaultConstructible<Allocator<node_type>>)
+            : _reset{reset}
+        {}
+
+        inline object_pool(const Allocator<node_type>& alloc, reset_type reset = nullptr)
+            : _alloc{alloc}, _reset{reset}
+        {}
+
+        inline ~object_pool()
+        {
+            _registry.close([this](record& rec) {
+                _free(exchange(rec.head, nullptr));
+                rec.count = 0;
+            });
+
+            _free(exchange(_shared, nullptr));
+        }
+
+        // args only matter when a new object has to be built,
+        // with a reset hook idle objects are handed out as they are
+        template <typename... Args>
+        inline pooled_ptr<T> acquire(Args&&... args)
+        {
+            auto& _rec = _local();
+            record::bump(_rec.acquired);
+
+            auto* _node = reinterpret_cast<node_type*>(_pop(_rec));
+
+            if (_node == nullptr)
+            {
+                _node = _alloc.allocate(1).unwrap();
+                record::bump(_rec.created);
+            }
+            else
+            {
+                record::bump(_rec.reused);
+
+                if (_reset != nullptr)
+                {
+                    return {_node->get(), _handle_alloc(), 1u};
+                }
+            }
+
+            auto* _object = ::new (_node->storage) T{forward<Args>(args)...};
+            return {_object, _handle_alloc(), 1u};
+        }
+
+        // Frees the idle objects of the calling thread and the shared
+        // ones, the other threads' caches stay as they are
+        inline usize trim()
+        {
+            auto& _rec = _local();
+            _give_back(_rec, _rec.count);
+
+            pool_detail::link* _list = nullptr;
+
+            {
+                unique_lock<spin> _guard{_lock};
+                _list = exchange(_shared, nullptr);
+            }
+
+            usize _count = 0;
+
+            for (auto* _it = _list; _it != nullptr; _it = _it->next)
+            {
+                _count++;
+            }
+
+            _free(_list);
+            _trimmed.fetch_add(_count, memory_order_relaxed);
+            return _count;
+        }
+    };
+} // namespace hsd
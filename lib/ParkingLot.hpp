@@ -0,0 +1,241 @@
+#pragma once
+
+#include "Atomic.hpp"
+
+#if defined(HSD_PLATFORM_WINDOWS)
+#include <windows.h>
+#elif defined(HSD_PLATFORM_POSIX)
+#include <pthread.h>
+#endif
+
+namespace hsd
+{
+    namespace parking_detail
+    {
+        #if defined(HSD_PLATFORM_WINDOWS)
+        using lock_type = SRWLOCK;
+        using cond_type = CONDITION_VARIABLE;
+
+        #define HSD_PARKING_LOCK_INIT SRWLOCK_INIT
+
+        static inline void lock(lock_type& lck) { AcquireSRWLockExclusive(&lck); }
+        static inline void unlock(lock_type& lck) { ReleaseSRWLockExclusive(&lck); }
+        static inline void init(cond_type& cond) { InitializeConditionVariable(&cond); }
+        static inline void destroy(cond_type&) {}
+        static inline void signal(cond_type& cond) { WakeConditionVariable(&cond); }
+
+        static inline void wait(cond_type& cond, lock_type& lck)
+        {
+            SleepConditionVariableSRW(&cond, &lck, INFINITE, 0);
+        }
+        #else
+        using lock_type = pthread_mutex_t;
+        using cond_type = pthread_cond_t;
+
+        #define HSD_PARKING_LOCK_INIT PTHREAD_MUTEX_INITIALIZER
+
+        static inline void lock(lock_type& lck) { pthread_mutex_lock(&lck); }
+        static inline void unlock(lock_type& lck) { pthread_mutex_unlock(&lck); }
+        static inline void init(cond_type& cond) { pthread_cond_init(&cond, nullptr); }
+        static inline void destroy(cond_type& cond) { pthread_cond_destroy(&cond); }
+        static inline void signal(cond_type& cond) { pthread_cond_signal(&cond); }
+
+        static inline void wait(cond_type& cond, lock_type& lck)
+        {
+            pthread_cond_wait(&cond, &lck);
+        }
+        #endif
+
+        // Lives on the stack of the parked thread
+        struct waiter
+        {
+            const void* address;
+            waiter* next = nullptr;
+            bool unparked = false;
+            cond_type cond{};
+        };
+
+        struct alignas(hardware_destructive_interference_size) bucket
+        {
+            lock_type lock = HSD_PARKING_LOCK_INIT;
+            waiter* head = nullptr;
+            waiter* tail = nullptr;
+        };
+
+        #undef HSD_PARKING_LOCK_INIT
+
+        static constexpr usize bucket_bits = 8;
+        static constexpr usize bucket_count = 1ull << bucket_bits;
+
+        static inline bucket& bucket_for(const void* address)
+        {
+            static bucket _table[bucket_count];
+
+            // Fibonacci hashing, so that neighbouring
+            // addresses end up in different buckets
+            u64 _hash = static_cast<u64>(reinterpret_cast<uptr>(address));
+            _hash *= 0x9E3779B97F4A7C15ull;
+            return _table[_hash >> (64 - bucket_bits)];
+        }
+    } // namespace parking_detail
+
+    struct unpark_result
+    {
+        bool unparked;  // a thread was woken up
+        bool has_more;  // other threads still wait on the same address
+    };
+
+    // Hashed table of wait queues keyed by address, after WebKit's
+    // ParkingLot. Any word can be waited on without storing anything
+    // in it, threads waiting on unrelated addresses mostly end up in
+    // different buckets, so they don't share a lock or a wake up
+    class parking_lot
+    {
+    public:
+        // Sleeps on address if validate() still holds, both checked and
+        // queued under the bucket lock, so an unpark can't slip between.
+        // before_sleep runs after queuing, right before going to sleep.
+        // Returns false if validate() failed and the thread never parked
+        template <typename Validate, typename BeforeSleep>
+        static inline bool park(
+            const void* address, Validate&& validate, BeforeSleep&& before_sleep)
+        {
+            auto& _bucket = parking_detail::bucket_for(address);
+            parking_detail::waiter _self{address};
+
+            parking_detail::lock(_bucket.lock);
+
+            if (!validate())
+            {
+                parking_detail::unlock(_bucket.lock);
+                return false;
+            }
+
+            parking_detail::init(_self.cond);
+
+            if (_bucket.tail == nullptr)
+            {
+                _bucket.head = &_self;
+            }
+            else
+            {
+                _bucket.tail->next = &_self;
+            }
+
+            _bucket.tail = &_self;
+            parking_detail::unlock(_bucket.lock);
+
+            before_sleep();
+
+            parking_detail::lock(_bucket.lock);
+
+            while (_self.unparked == false)
+            {
+                parking_detail::wait(_self.cond, _bucket.lock);
+            }
+
+            parking_detail::unlock(_bucket.lock);
+            parking_detail::destroy(_self.cond);
+            return true;
+        }
+
+        template <typename Validate>
+        static inline bool park(const void* address, Validate&& validate)
+        {
+            return park(address, forward<Validate>(validate), [] {});
+        }
+
+        // Wakes up the longest waiting thread parked on address
+        static inline unpark_result unpark_one(const void* address)
+        {
+            auto& _bucket = parking_detail::bucket_for(address);
+            unpark_result _result{false, false};
+
+            parking_detail::lock(_bucket.lock);
+
+            parking_detail::waiter* _prev = nullptr;
+            auto* _current = _bucket.head;
+
+            while (_current != nullptr && _current->address != address)
+            {
+                _prev = _current;
+                _current = _current->next;
+            }
+
+            if (_current != nullptr)
+            {
+                _unlink(_bucket, _prev, _current);
+                _result.unparked = true;
+
+                for (auto* _rest = _current->next; _rest != nullptr; _rest = _rest->next)
+                {
+                    if (_rest->address == address)
+                    {
+                        _result.has_more = true;
+                        break;
+                    }
+                }
+
+                _current->unparked = true;
+                parking_detail::signal(_current->cond);
+            }
+
+            parking_detail::unlock(_bucket.lock);
+            return _result;
+        }
+
+        // Wakes up every thread parked on address, returns how many
+        static inline usize unpark_all(const void* address)
+        {
+            auto& _bucket = parking_detail::bucket_for(address);
+            usize _count = 0;
+
+            parking_detail::lock(_bucket.lock);
+
+            parking_detail::waiter* _prev = nullptr;
+            auto* _current = _bucket.head;
+
+            while (_current != nullptr)
+            {
+                auto* _next = _current->next;
+
+                if (_current->address == address)
+                {
+                    _unlink(_bucket, _prev, _current);
+                    _current->unparked = true;
+                    parking_detail::signal(_current->cond);
+                    _count++;
+                }
+                else
+                {
+                    _prev = _current;
+                }
+
+                _current = _next;
+            }
+
+            parking_detail::unlock(_bucket.lock);
+            return _count;
+        }
+
+    private:
+        static inline void _unlink(
+            parking_detail::bucket& bucket, parking_detail::waiter* prev,
+            parking_detail::waiter* node)
+        {
+            if (prev == nullptr)
+            {
+                bucket.head = node->next;
+            }
+            else
+            {
+                prev->next = node->next;
+            }
+
+            if (bucket.tail == node)
+            {
+                bucket.tail = prev;
+            }
+        }
+    };
+} // namespace hsd
@@ -0,0 +1,297 @@
+#pragma once
+
+#include "ThreadRegistry.hpp"
+
+namespace hsd
+{
+    class epoch_domain;
+    class epoch_guard;
+
+    namespace reclamation_detail
+    {
+        struct retired
+        {
+            void* ptr;
+            void (*deleter)(void*);
+            u64 epoch;
+        };
+
+        // One per thread and domain
+        struct alignas(hardware_destructive_interference_size) record
+            : registry_detail::record_base<record>
+        {
+            static constexpr u64 pinned = 1;
+
+            // Epoch shifted left by one, the lowest bit is pinned
+            atomic_u64 epoch_state = 0;
+
+            // Only touched by the owning thread
+            usize nesting = 0;
+            usize since_collect = 0;
+            hsd::vector<retired> garbage;
+        };
+    } // namespace reclamation_detail
+
+    // Epoch based reclamation (Fraser, "Practical lock-freedom").
+    // Readers pin the current epoch while they hold pointers into a
+    // shared structure, writers retire what they unlinked instead of
+    // deleting it. Whatever was retired in epoch e gets freed once the
+    // global epoch reached e + 2, since by then every thread that was
+    // pinned while it was still reachable has moved on. Retired objects
+    // go to a per-thread list that gets freed in batches. A thread's
+    // leftovers are freed when it exits, or with the domain
+    class epoch_domain
+    {
+    private:
+        using record = reclamation_detail::record;
+
+        static constexpr usize _collect_every = 64;
+
+        alignas(hardware_destructive_interference_size) atomic_u64 _epoch = 0;
+        alignas(hardware_destructive_interference_size) thread_registry<epoch_domain, record> _registry;
+
+        friend class epoch_guard;
+        friend class thread_registry<epoch_domain, record>;
+
+        inline record& _local() const
+        {
+            auto* _self = const_cast<epoch_domain*>(this);
+            return _self->_registry.local(_self);
+        }
+
+        inline void _pin(record& rec)
+        {
+            if (rec.nesting++ != 0)
+                return;
+
+            u64 _current = _epoch.load(memory_order_relaxed);
+            rec.epoch_state.store((_current << 1) | record::pinned, memory_order_relaxed);
+
+            // Publish the pin before reading anything it protects
+            atomic_thread_fence(memory_order_seq_cst);
+        }
+
+        inline void _unpin(record& rec)
+        {
+            if (--rec.nesting == 0)
+            {
+                rec.epoch_state.store(0, memory_order_release);
+            }
+        }
+
+        // Moves the global epoch on if every pinned thread has seen it
+        inline bool _try_advance()
+        {
+            u64 _current = _epoch.load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+
+            for (auto* _rec = _registry.records(); _rec != nullptr; _rec = _rec->next)
+            {
+                // Acquire, pairs with the release in _unpin so that the
+                // reads a thread did while pinned happen before any free
+                u64 _state = _rec->epoch_state.load(memory_order_acquire);
+
+                if ((_state & record::pinned) && (_state >> 1) != _current)
+                    return false;
+            }
+
+            return _epoch.compare_exchange_strong(
+                _current, _current + 1, memory_order_release, memory_order_relaxed
+            );
+        }
+
+        static inline void _free_expired(record& rec, u64 epoch)
+        {
+            usize _kept = 0;
+
+            for (usize _index = 0; _index < rec.garbage.size(); _index++)
+            {
+                auto& _item = rec.garbage[_index];
+
+                if (_item.epoch + 2 <= epoch)
+                {
+                    _item.deleter(_item.ptr);
+                }
+                else
+                {
+                    rec.garbage[_kept++] = _item;
+                }
+            }
+
+            rec.garbage.resize(_kept);
+        }
+
+        inline void _collect(record& rec)
+        {
+            rec.since_collect = 0;
+            _try_advance();
+            _free_expired(rec, _epoch.load(memory_order_acquire));
+        }
+
+        // The thread is gone, whatever it can free goes now
+        inline void _thread_exit(record& rec)
+        {
+            _collect(rec);
+        }
+
+    public:
+        inline epoch_domain() = default;
+        inline epoch_domain(const epoch_domain&) = delete;
+        inline epoch_domain& operator=(const epoch_domain&) = delete;
+
+        // Nobody can be pinned anymore, so everything goes. The
+        // records of threads still running are freed by them
+        inline ~epoch_domain()
+        {
+            _registry.close([](record& rec) {
+                for (auto& _item : rec.garbage)
+                {
+                    _item.deleter(_item.ptr);
+                }
+
+                rec.garbage.clear();
+            });
+        }
+
+        // Keeps everything reachable right now alive
+        // until the returned guard is destroyed
+        inline epoch_guard pin();
+
+        // Frees ptr with deleter once no thread can still be using it.
+        // Only call it after ptr is no longer reachable for new readers
+        inline void retire(void* ptr, void (*deleter)(void*))
+        {
+            auto& _rec = _local();
+
+            // The unlink has to be visible before the epoch is read
+            atomic_thread_fence(memory_order_seq_cst);
+
+            _rec.garbage.push_back(
+                reclamation_detail::retired{ptr, deleter, _epoch.load(memory_order_relaxed)}
+            );
+
+            if (++_rec.since_collect >= _collect_every)
+            {
+                _collect(_rec);
+            }
+        }
+
+        template <typename T>
+        inline void retire(T* ptr)
+        {
+            retire(static_cast<void*>(ptr), [](void* value) {
+                delete static_cast<T*>(value);
+            });
+        }
+
+        // Tries to move the epoch on and frees what the
+        // calling thread retired and nobody can reach anymore
+        inline void collect()
+        {
+            _collect(_local());
+        }
+
+        inline u64 epoch() const
+        {
+            return _epoch.load(memory_order_relaxed);
+        }
+
+        // Objects retired by the calling thread, not freed yet
+        inline usize pending() const
+        {
+            return _local().garbage.size();
+        }
+
+        static inline epoch_domain& global()
+        {
+            static epoch_domain _domain;
+            return _domain;
+        }
+    };
+
+    class epoch_guard
+    {
+    private:
+        epoch_domain* _domain;
+        reclamation_detail::record* _record;
+
+    public:
+        inline epoch_guard(epoch_domain& domain)
+            : _domain{&domain}, _record{&domain._local()}
+        {
+            _domain->_pin(*_record);
+        }
+
+        inline epoch_guard(const epoch_guard&) = delete;
+        inline epoch_guard& operator=(const epoch_guard&) = delete;
+
+        inline epoch_guard(epoch_guard&& other)
+            : _domain{exchange(other._domain, nullptr)},
+            _record{exchange(other._record, nullptr)}
+        {}
+
+        inline ~epoch_guard()
+        {
+            if (_domain != nullptr)
+            {
+                _domain->_unpin(*_record);
+            }
+        }
+
+        template <typename T>
+        inline void retire(T* ptr)
+        {
+            _domain->retire(ptr);
+        }
+    };
+
+    inline epoch_guard epoch_domain::pin()
+    {
+        return epoch_guard{*this};
+    }
+
+    // Pointer for read-mostly data: readers get the current version
+    // without taking any lock, writers swap in a new version and
+    // the old one is freed once the readers are done with it
+    template <typename T>
+    class rcu_cell
+    {
+    private:
+        atomic<T*> _value;
+        epoch_domain* _domain;
+
+    public:
+        inline explicit rcu_cell(T* value, epoch_domain& domain = epoch_domain::global())
+            : _value{value}, _domain{&domain}
+        {}
+
+        inline rcu_cell(const rcu_cell&) = delete;
+        inline rcu_cell& operator=(const rcu_cell&) = delete;
+
+        inline ~rcu_cell()
+        {
+            delete _value.load(memory_order_relaxed);
+        }
+
+        // The pointer stays valid for as long as guard lives
+        inline const T* read(const epoch_guard&) const
+        {
+            return _value.load(memory_order_acquire);
+        }
+
+        inline void update(T* value)
+        {
+            auto* _old = _value.exchange(value, memory_order_acq_rel);
+
+            if (_old != nullptr)
+            {
+                _domain->retire(_old);
+            }
+        }
+
+        inline epoch_guard pin() const
+        {
+            return _domain->pin();
+        }
+    };
+} // namespace hsd
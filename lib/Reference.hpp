@@ -4,12 +4,21 @@
 
 namespace hsd
 {
+    template <typename T>
+    struct niche_traits;
+
     template <typename T>
     class reference 
     {
     private:
         T* _ptr = nullptr;
 
+        // Unbound, only used as the niche of result and option
+        template <typename U>
+        friend struct niche_traits;
+
+        constexpr reference() = default;
+
     public:
         using value_type = T;
 
@@ -2,6 +2,7 @@
 
 #include "Concepts.hpp"
 #include "Pair.hpp"
+#include "Reference.hpp"
 
 // Required to unlock std::construct_at which
 // allows us to in-place construct at compile time 
@@ -87,6 +88,141 @@ namespace hsd
 
     struct ok_value {};
     struct err_value {};
+
+    // Describes a bit pattern of T that no real value has. When the
+    // payload of a result or an option has one, that pattern marks
+    // the other state and no separate flag is stored. Specialize it
+    // with niche() and is_niche() for trivially copyable types
+    template <typename T>
+    struct niche_traits
+    {
+        static constexpr bool has_niche = false;
+    };
+
+    // Nothing can live at the very last address
+    template <typename T>
+    struct niche_traits<T*>
+    {
+        static constexpr bool has_niche = true;
+
+        static inline T* niche()
+        {
+            return reinterpret_cast<T*>(~uptr{0});
+        }
+
+        static inline bool is_niche(T* value)
+        {
+            return reinterpret_cast<uptr>(value) == ~uptr{0};
+        }
+    };
+
+    // A reference is always bound
+    template <typename T>
+    struct niche_traits<reference<T>>
+    {
+        static constexpr bool has_niche = true;
+
+        static constexpr reference<T> niche()
+        {
+            return reference<T>{};
+        }
+
+        static constexpr bool is_niche(const reference<T>& value)
+        {
+            return value._ptr == nullptr;
+        }
+    };
+
+    // An unsigned integer that is never its maximum (like an
+    // index or a count), so that value can be used as the niche
+    template <UnsignedType T>
+    class nonmax
+    {
+    private:
+        T _value;
+
+        template <typename U>
+        friend struct niche_traits;
+
+        constexpr nonmax()
+            : _value{invalid}
+        {}
+
+    public:
+        static constexpr T invalid = static_cast<T>(~T{0});
+
+        constexpr nonmax(T value)
+            : _value{value}
+        {
+            if (value == invalid)
+            {
+                panic("nonmax was given its maximum value");
+            }
+        }
+
+        constexpr T get() const
+        {
+            return _value;
+        }
+
+        constexpr operator T() const
+        {
+            return _value;
+        }
+    };
+
+    template <typename T>
+    struct niche_traits<nonmax<T>>
+    {
+        static constexpr bool has_niche = true;
+
+        static constexpr nonmax<T> niche()
+        {
+            return nonmax<T>{};
+        }
+
+        static constexpr bool is_niche(const nonmax<T>& value)
+        {
+            return value._value == nonmax<T>::invalid;
+        }
+    };
+
+    namespace result_detail
+    {
+        // Takes the place of the flag when the niche is used
+        struct no_flag
+        {
+            constexpr no_flag() = default;
+            constexpr no_flag(bool) {}
+        };
+
+        template <bool Niche>
+        using flag_type = conditional_t<Niche, no_flag, bool>;
+
+        template <typename T>
+        concept HasNiche = (
+            niche_traits<T>::has_niche &&
+            std::is_trivially_copyable_v<T>
+        );
+
+        // Carries no state, so it can be made up again when asked for
+        template <typename T>
+        concept StatelessValue = (
+            std::is_empty_v<T> &&
+            std::is_trivially_copyable_v<T> &&
+            std::is_trivially_default_constructible_v<T>
+        );
+
+        template <typename... Ts>
+        static constexpr bool trivially_copyable = (
+            std::is_trivially_copyable_v<Ts> && ...
+        );
+
+        template <typename... Ts>
+        static constexpr bool trivially_destructible = (
+            std::is_trivially_destructible_v<Ts> && ...
+        );
+    } // namespace result_detail
     
     class runtime_error
     {
@@ -108,13 +244,68 @@ namespace hsd
     class [[nodiscard("Result type should not be discarded")]] result
     {
     private:
+        // An error that carries nothing is stored as the niche of Ok
+        static constexpr bool _niche = (
+            result_detail::HasNiche<Ok> &&
+            result_detail::StatelessValue<Err>
+        );
+
         union
         {
             Ok _ok_data;
             Err _err_data;
         };
 
-        bool _initialized = false;
+        [[no_unique_address]] result_detail::flag_type<_niche> _initialized = false;
+
+        constexpr bool _has_ok() const
+        {
+            if constexpr (_niche)
+            {
+                return !niche_traits<Ok>::is_niche(_ok_data);
+            }
+            else
+            {
+                return _initialized;
+            }
+        }
+
+        template <typename... Args>
+        constexpr void _construct_err(Args&&... args)
+        {
+            if constexpr (_niche)
+            {
+                std::construct_at(&_ok_data, niche_traits<Ok>::niche());
+            }
+            else
+            {
+                std::construct_at(&_err_data, forward<Args>(args)...);
+            }
+        }
+
+        constexpr Err _take_err()
+        {
+            if constexpr (_niche)
+            {
+                return Err{};
+            }
+            else
+            {
+                return release(_err_data);
+            }
+        }
+
+        constexpr void _destroy()
+        {
+            if (_has_ok())
+            {
+                _ok_data.~Ok();
+            }
+            else
+            {
+                _err_data.~Err();
+            }
+        }
         
     public:
         constexpr result(const Ok& value)
@@ -129,53 +320,60 @@ namespace hsd
 
         constexpr result(const Err& value)
         requires (CopyConstructible<Err>)
-            : _err_data{value}, _initialized{false}
-        {}
+            : _initialized{false}
+        {
+            _construct_err(value);
+        }
 
         constexpr result(Err&& value)
         requires (MoveConstructible<Err>)
-            : _err_data{move(value)}, _initialized{false}
-        {}
+            : _initialized{false}
+        {
+            _construct_err(move(value));
+        }
 
         constexpr result(const result&) = delete;
         constexpr result& operator=(const result&) = delete;
 
+        // Trivially copyable payloads keep the result trivially
+        // copyable, so it's returned in registers, not memory
+        constexpr result(result&&)
+        requires (result_detail::trivially_copyable<Ok, Err>) = default;
+
+        constexpr result& operator=(result&&)
+        requires (result_detail::trivially_copyable<Ok, Err>) = default;
+
+        constexpr ~result()
+        requires (result_detail::trivially_destructible<Ok, Err>) = default;
+
         constexpr result(result&& other)
             : _initialized{other._initialized}
         {
-            if(_initialized)
+            if (other._has_ok())
             {
                 std::construct_at(&_ok_data, move(other._ok_data));
             }
             else
             {
-                std::construct_at(&_err_data, move(other._err_data));
+                _construct_err(move(other._err_data));
             }
         }
 
         constexpr result& operator=(result&& rhs)
         {
-            result _tmp = move(rhs);
-            swap(_initialized, rhs._initialized);
-
-            if (rhs._initialized)
+            if (this != &rhs)
             {
-                std::construct_at(&rhs._ok_data, move(_ok_data));
-            }
-            else
-            {
-                std::construct_at(&rhs._err_data, move(_err_data));
-            }
-
-            swap(_initialized, _tmp._initialized);
+                _destroy();
+                _initialized = rhs._initialized;
 
-            if (_initialized)
-            {
-                std::construct_at(&_ok_data, move(_tmp._ok_data));
-            }
-            else
-            {
-                std::construct_at(&_err_data, move(_tmp._err_data));
+                if (rhs._has_ok())
+                {
+                    std::construct_at(&_ok_data, move(rhs._ok_data));
+                }
+                else
+                {
+                    _construct_err(move(rhs._err_data));
+                }
             }
 
             return *this;
@@ -183,24 +381,17 @@ namespace hsd
 
         constexpr ~result()
         {
-            if (_initialized)
-            {
-                _ok_data.~Ok();
-            }
-            else
-            {
-                _err_data.~Err();
-            }
+            _destroy();
         }
 
         constexpr bool is_ok() const
         {
-            return _initialized;
+            return _has_ok();
         }
 
         explicit constexpr operator bool() const
         {
-            return _initialized;
+            return _has_ok();
         }
 
         constexpr auto unwrap(
@@ -208,7 +399,7 @@ namespace hsd
             const char* file_name = __builtin_FILE(), 
             usize line = __builtin_LINE())
         {
-            if (_initialized)
+            if (_has_ok()) [[likely]]
             {
                 return release(_ok_data);
             }
@@ -216,7 +407,7 @@ namespace hsd
             {
                 if constexpr (requires (Err _err) {_err.pretty_error() -> template IsSame<const char*>;})
                 {
-                    panic(_err_data.pretty_error(), func, file_name, line);
+                    panic(_take_err().pretty_error(), func, file_name, line);
                 }
                 else
                 {
@@ -231,7 +422,7 @@ namespace hsd
             const char* file_name = __builtin_FILE(), 
             usize line = __builtin_LINE())
         {
-            if (_initialized)
+            if (_has_ok()) [[likely]]
             {
                 return release(_ok_data);
             }
@@ -245,7 +436,7 @@ namespace hsd
         constexpr auto unwrap_or(Args&&... args)
         requires (Constructible<Ok, Args...>)
         {
-            if (_initialized)
+            if (_has_ok()) [[likely]]
             {
                 return release(_ok_data);
             }
@@ -258,7 +449,7 @@ namespace hsd
         constexpr auto unwrap_or_default()
         requires (DefaultConstructible<Ok>)
         {
-            if (_initialized)
+            if (_has_ok()) [[likely]]
             {
                 return release(_ok_data);
             }
@@ -272,7 +463,7 @@ namespace hsd
         requires (InvocableRet<Ok, Func>)
         constexpr auto unwrap_or_else(Func&& func)
         {
-            if (_initialized)
+            if (_has_ok()) [[likely]]
             {
                 return release(_ok_data);
             }
@@ -287,9 +478,9 @@ namespace hsd
             const char* file_name = __builtin_FILE(),
             usize line = __builtin_LINE())
         {
-            if (!_initialized)
+            if (!_has_ok())
             {
-                return release(_err_data);
+                return _take_err();
             }
             else
             {
@@ -303,9 +494,9 @@ namespace hsd
             const char* file_name = __builtin_FILE(), 
             usize line = __builtin_LINE())
         {
-            if (!_initialized)
+            if (!_has_ok())
             {
-                return release(_err_data);
+                return _take_err();
             }
             else
             {
@@ -318,12 +509,34 @@ namespace hsd
     class [[nodiscard("Option type should not be discarded")]] option
     {
     private:
+        static constexpr bool _niche = result_detail::HasNiche<Ok>;
+
         union
         {
             Ok _ok_data;
         };
 
-        bool _initialized = false;
+        [[no_unique_address]] result_detail::flag_type<_niche> _initialized = false;
+
+        constexpr bool _has_ok() const
+        {
+            if constexpr (_niche)
+            {
+                return !niche_traits<Ok>::is_niche(_ok_data);
+            }
+            else
+            {
+                return _initialized;
+            }
+        }
+
+        constexpr void _destroy()
+        {
+            if (_has_ok())
+            {
+                _ok_data.~Ok();
+            }
+        }
         
     public:
         constexpr option(const Ok& value)
@@ -338,35 +551,45 @@ namespace hsd
 
         constexpr option(err_value = {})
             : _initialized{false}
-        {}
-
-        constexpr option(option&& other)
-            : _initialized{other._initialized}
         {
-            if(_initialized)
+            if constexpr (_niche)
             {
-                std::construct_at(&_ok_data, move(other._ok_data));
+                std::construct_at(&_ok_data, niche_traits<Ok>::niche());
             }
         }
 
         constexpr option(const option&) = delete;
         constexpr option& operator=(const option&) = delete;
 
-        constexpr option& operator=(option&& rhs)
-        {
-            option _tmp = move(rhs);
-            swap(_initialized, rhs._initialized);
+        constexpr option(option&&)
+        requires (result_detail::trivially_copyable<Ok>) = default;
+
+        constexpr option& operator=(option&&)
+        requires (result_detail::trivially_copyable<Ok>) = default;
 
-            if (rhs._initialized)
+        constexpr ~option()
+        requires (result_detail::trivially_destructible<Ok>) = default;
+
+        constexpr option(option&& other)
+            : _initialized{other._initialized}
+        {
+            if (other._has_ok())
             {
-                std::construct_at(&rhs._ok_data, move(_ok_data));
+                std::construct_at(&_ok_data, move(other._ok_data));
             }
+        }
 
-            swap(_initialized, _tmp._initialized);
-
-            if (_initialized)
+        constexpr option& operator=(option&& rhs)
+        {
+            if (this != &rhs)
             {
-                std::construct_at(&_ok_data, move(_tmp._ok_data));
+                _destroy();
+                _initialized = rhs._initialized;
+
+                if (rhs._has_ok())
+                {
+                    std::construct_at(&_ok_data, move(rhs._ok_data));
+                }
             }
 
             return *this;
@@ -374,20 +597,17 @@ namespace hsd
 
         constexpr ~option()
         {
-            if (_initialized)
-            {
-                _ok_data.~Ok();
-            }
+            _destroy();
         }
 
         constexpr bool is_ok() const
         {
-            return _initialized;
+            return _has_ok();
         }
 
         explicit constexpr operator bool() const
         {
-            return _initialized;
+            return _has_ok();
         }
 
         constexpr auto unwrap(
@@ -395,7 +615,7 @@ namespace hsd
             const char* file_name = __builtin_FILE(), 
             usize line = __builtin_LINE())
         {
-            if (_initialized)
+            if (_has_ok()) [[likely]]
             {
                 return release(_ok_data);
             }
@@ -411,7 +631,7 @@ namespace hsd
             const char* file_name = __builtin_FILE(), 
             usize line = __builtin_LINE())
         {
-            if (_initialized)
+            if (_has_ok()) [[likely]]
             {
                 return release(_ok_data);
             }
@@ -425,7 +645,7 @@ namespace hsd
         constexpr auto unwrap_or(Args&&... args)
         requires (Constructible<Ok, Args...>)
         {
-            if (_initialized)
+            if (_has_ok()) [[likely]]
             {
                 return release(_ok_data);
             }
@@ -438,7 +658,7 @@ namespace hsd
         constexpr auto unwrap_or_default()
         requires (DefaultConstructible<Ok>)
         {
-            if (_initialized)
+            if (_has_ok()) [[likely]]
             {
                 return release(_ok_data);
             }
@@ -452,7 +672,7 @@ namespace hsd
         requires (InvocableRet<Ok, Func>)
         constexpr auto unwrap_or_else(Func&& func)
         {
-            if (_initialized)
+            if (_has_ok()) [[likely]]
             {
                 return release(_ok_data);
             }
@@ -467,7 +687,7 @@ namespace hsd
             const char* file_name = __builtin_FILE(),
             usize line = __builtin_LINE())
         {
-            if (_initialized)
+            if (_has_ok())
             {
                 panic_type_err<void, Ok>(func, file_name, line);
             }
@@ -479,7 +699,7 @@ namespace hsd
             const char* file_name = __builtin_FILE(), 
             usize line = __builtin_LINE())
         {
-            if (_initialized)
+            if (_has_ok())
             {
                 panic(message, func, file_name, line);
             }
@@ -490,12 +710,34 @@ namespace hsd
     class [[nodiscard("Option type should not be discarded")]] option_err
     {
     private:
+        static constexpr bool _niche = result_detail::HasNiche<Err>;
+
         union
         {
             Err _err_data;
         };
 
-        bool _initialized = false;
+        [[no_unique_address]] result_detail::flag_type<_niche> _initialized = false;
+
+        constexpr bool _has_ok() const
+        {
+            if constexpr (_niche)
+            {
+                return niche_traits<Err>::is_niche(_err_data);
+            }
+            else
+            {
+                return _initialized;
+            }
+        }
+
+        constexpr void _destroy()
+        {
+            if (!_has_ok())
+            {
+                _err_data.~Err();
+            }
+        }
         
     public:
         constexpr option_err(const Err& value)
@@ -510,35 +752,45 @@ namespace hsd
 
         constexpr option_err(ok_value = {})
             : _initialized{true}
-        {}
-
-        constexpr option_err(option_err&& other)
-            : _initialized{other._initialized}
         {
-            if(!_initialized)
+            if constexpr (_niche)
             {
-                std::construct_at(&_err_data, move(other._err_data));
+                std::construct_at(&_err_data, niche_traits<Err>::niche());
             }
         }
 
         constexpr option_err(const option_err&) = delete;
         constexpr option_err& operator=(const option_err&) = delete;
 
-        constexpr option_err& operator=(option_err&& rhs)
-        {
-            option_err _tmp = move(rhs);
-            swap(_initialized, rhs._initialized);
+        constexpr option_err(option_err&&)
+        requires (result_detail::trivially_copyable<Err>) = default;
+
+        constexpr option_err& operator=(option_err&&)
+        requires (result_detail::trivially_copyable<Err>) = default;
 
-            if (!rhs._initialized)
+        constexpr ~option_err()
+        requires (result_detail::trivially_destructible<Err>) = default;
+
+        constexpr option_err(option_err&& other)
+            : _initialized{other._initialized}
+        {
+            if (!other._has_ok())
             {
-                std::construct_at(&rhs._err_data, move(_err_data));
+                std::construct_at(&_err_data, move(other._err_data));
             }
+        }
 
-            swap(_initialized, _tmp._initialized);
-
-            if (!_initialized)
+        constexpr option_err& operator=(option_err&& rhs)
+        {
+            if (this != &rhs)
             {
-                std::construct_at(&_err_data, move(_tmp._err_data));
+                _destroy();
+                _initialized = rhs._initialized;
+
+                if (!rhs._has_ok())
+                {
+                    std::construct_at(&_err_data, move(rhs._err_data));
+                }
             }
 
             return *this;
@@ -546,20 +798,17 @@ namespace hsd
 
         constexpr ~option_err()
         {
-            if (!_initialized)
-            {
-                _err_data.~Err();
-            }
+            _destroy();
         }
 
         constexpr bool is_ok() const
         {
-            return _initialized;
+            return _has_ok();
         }
 
         explicit constexpr operator bool() const
         {
-            return _initialized;
+            return _has_ok();
         }
 
         constexpr auto unwrap(
@@ -567,7 +816,7 @@ namespace hsd
             const char* file_name = __builtin_FILE(), 
             usize line = __builtin_LINE())
         {
-            if (!_initialized)
+            if (!_has_ok()) [[unlikely]]
             {
                 if constexpr (requires (Err _err) {_err.pretty_error() -> template IsSame<const char*>;})
                 {
@@ -586,7 +835,7 @@ namespace hsd
             const char* file_name = __builtin_FILE(), 
             usize line = __builtin_LINE())
         {
-            if (!_initialized)
+            if (!_has_ok()) [[unlikely]]
             {
                 panic(message, func, file_name, line);
             }
@@ -597,7 +846,7 @@ namespace hsd
             const char* file_name = __builtin_FILE(),
             usize line = __builtin_LINE())
         {
-            if (_initialized)
+            if (_has_ok())
             {
                 panic_type_err<Err, void>(func, file_name, line);
             }
@@ -613,7 +862,7 @@ namespace hsd
             const char* file_name = __builtin_FILE(), 
             usize line = __builtin_LINE())
         {
-            if (_initialized)
+            if (_has_ok())
             {
                 panic(message, func, file_name, line);
             }
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "_SStreamDetail.hpp"
-#include "FormatGenerator.hpp"
+#include "_FormatWriterDetail.hpp"
 #include "Tuple.hpp"
 
 namespace hsd
@@ -85,116 +85,34 @@ namespace hsd
         template < basic_string_literal fmt, typename... Args >
         inline void append_data(Args&&... args)
         {
-            using char_type = typename decltype(fmt)::char_type;
-            using tup_type = type_tuple<Args...>;
-
-            static_assert(
-                is_same<char_type, CharT>::value, 
-                "Unsupported character type"
-            );
-
-            static constexpr auto _fmt_buf =
-                parse_literal<fmt, sizeof...(Args) + 1>().unwrap();
-
-            static constexpr auto _last = _fmt_buf[tup_type::size];
-            static constexpr auto _last_fmt = 
-                format_literal<char_type, _last.length + 1>
-                {
-                    .format = {_last.format, _last.length},
-                    .base = _last.base
-                };
-
-
-            static_assert(
-                _fmt_buf.size() == sizeof...(Args) + 1, 
-                "The number of arguments doesn't match"
+            usize _len = format_to<fmt>(
+                data() + size(), capacity() - size(), args...
             );
 
-            if constexpr (sizeof...(Args) != 0)
+            if (_len >= capacity() - size())
             {
-                static constexpr auto _print_fmt =
-                    []<usize... Ints>(index_sequence<Ints...>)
-                    {
-                        constexpr auto _gen_fmt = []<usize I>()
-                        {
-                            constexpr auto _curr_fmt = 
-                                format_literal<char_type, _fmt_buf[I].length + 1>
-                                {
-                                    .format = {_fmt_buf[I].format, _fmt_buf[I].length},
-                                    .base = _fmt_buf[I].base
-                                };
-
-                            return format<_curr_fmt, typename tup_type::template type_at<I>>();
-                        };
-
-                        return ((_gen_fmt.template operator()<Ints>()) + ...);
-                    }(make_index_sequence<tup_type::size>{}) + _last_fmt.format;
-
-                const tuple _args = (make_args(args) + ...);
-
-                [&]<usize... Ints>(index_sequence<Ints...>)
-                {
-                    if constexpr (is_same<char_type, char>::value)
-                    {
-                        this->_size += static_cast<usize>(
-                            snprintf(
-                                data() + size(), capacity() - size(), 
-                                _print_fmt.data, _args.template get<Ints>()...
-                            )
-                        ) - 1;
-                    }
-                    else
-                    {
-                        this->_size += static_cast<usize>(
-                            swprintf(
-                                data() + size(), capacity() - size(),
-                                _print_fmt.data, _args.template get<Ints>()...
-                            )
-                        ) - 1;
-                    }
-                }(make_index_sequence<decltype(_args)::size()>{});
-            }
-            else
-            {
-                if constexpr (is_same<char_type, char>::value)
-                {
-                    this->_size += static_cast<usize>(
-                        snprintf(
-                            data() + size(), capacity() - size(),
-                            _last_fmt.format.data
-                        )
-                    ) - 1;
-                }
-                else
-                {
-                    this->_size += static_cast<usize>(
-                        swprintf(
-                            data() + size(), capacity() - size(),
-                            _last_fmt.format.data
-                        )
-                    ) - 1;
-                }
+                reserve(size() + _len + 1);
+                format_to<fmt>(data() + size(), capacity() - size(), args...);
             }
+
+            this->_size += _len;
         }
 
         inline void pop_back()
         {
             vector<CharT>::pop_back();
-            this->back() = '\0';
+
+            if (capacity() != 0)
+            {
+                data()[size()] = '\0';
+            }
         }
 
         inline void push_back(CharT c)
         {
-            if (this->size() != 0)
-            {
-                this->back() = c;
-                this->emplace_back('\0');
-            }
-            else
-            {
-                this->emplace_back(c);
-                this->emplace_back('\0');
-            }
+            this->emplace_back(c);
+            reserve(size() + 1);
+            data()[size()] = '\0';
         }
 
         inline void set_separators(const CharT* separators)
@@ -210,7 +128,11 @@ namespace hsd
         inline void clear()
         {
             vector<CharT>::clear();
-            this->emplace_back('\0');
+
+            if (capacity() != 0)
+            {
+                data()[0] = '\0';
+            }
         }
 
         using vector<CharT>::resize;
@@ -2,357 +2,395 @@
 
 #include "Allocator.hpp"
 #include "Atomic.hpp"
+#include "Extra/CompressedPair.hpp"
+
+#include <new>
 
 namespace hsd
 {
-    namespace non_atomic_types
+    namespace shared_detail
     {
-        namespace shared_detail
+        template <typename Base, typename Derived>
+        concept ConvertibleDerived = (
+            Convertible<Derived, Base> ||
+            std::is_base_of_v<Base, Derived>
+        );
+
+        struct unsafe_count
         {
-            template <typename Base, typename Derived>
-            concept ConvertibleDerived = (
-                Convertible<Derived, Base> || 
-                std::is_base_of_v<Base, Derived>
-            );
+            using count_type = usize;
 
-            template < typename T, template <typename> typename Allocator >
-            class storage
+            static inline void increment(count_type& count)
             {
-            public:
-                using alloc_type = Allocator<remove_array_t<T>>;
-                using pointer_type = typename alloc_type::pointer_type;
-                using value_type = typename alloc_type::value_type;
-
-            private:
-                alloc_type _alloc;
-                pointer_type _data = nullptr;
-                usize _size = 0;
-
-                template <typename U, template <typename> typename Alloc>
-                friend class storage;
+                count++;
+            }
 
-            public:
-                inline storage()
-                requires (DefaultConstructible<alloc_type>) = default;
+            // Returns true if that was the last reference
+            static inline bool release(count_type& count)
+            {
+                return --count == 0;
+            }
 
-                inline storage(pointer_type ptr, usize size)
-                requires (DefaultConstructible<alloc_type>)
-                    : _data{ptr}, _size{size}
-                {}
+            // Takes a reference only if there's still one left
+            static inline bool try_increment(count_type& count)
+            {
+                if (count == 0)
+                    return false;
 
-                inline storage(const alloc_type& alloc, usize size)
-                requires (CopyConstructible<value_type>)
-                    : _alloc{alloc}, _size{size}
-                {
-                    _data = _alloc.allocate(size).unwrap();
-                    _alloc.construct_at(_data);
+                count++;
+                return true;
+            }
 
-                    for (usize _index = 0; _index < size; _index++)
-                        _alloc.construct_at(&_data[_index]);
-                }
+            static inline usize load(const count_type& count)
+            {
+                return count;
+            }
+        };
 
-                inline storage(pointer_type ptr, const alloc_type& alloc, usize size)
-                requires (CopyConstructible<value_type>)
-                    : _alloc{alloc}, _data{ptr}, _size{size}
-                {}
+        struct safe_count
+        {
+            using count_type = atomic_usize;
 
-                inline storage(const storage& other)
-                requires (CopyConstructible<alloc_type>)
-                    : _alloc{other._alloc}, _data{other._data}, _size{other._size}
-                {}
+            static inline void increment(count_type& count)
+            {
+                count.fetch_add(1, memory_order_relaxed);
+            }
 
-                inline storage(const storage& other)
-                requires (!CopyConstructible<alloc_type>)
-                    : _data{other._data}, _size{other._size}
-                {}
+            // The release orders our writes before the destruction,
+            // the acquire makes the last owner see everybody's writes
+            static inline bool release(count_type& count)
+            {
+                return count.fetch_sub(1, memory_order_acq_rel) == 1;
+            }
 
-                inline storage(storage&& other)
-                requires (MoveConstructible<alloc_type>)
-                    : _alloc{move(other._alloc)}
-                {
-                    _data = exchange(other._data, nullptr);
-                    swap(_size, other._size);
-                }
+            static inline bool try_increment(count_type& count)
+            {
+                usize _current = count.load(memory_order_relaxed);
 
-                inline storage(storage&& other)
-                requires (!MoveConstructible<alloc_type>)
+                while (_current != 0)
                 {
-                    _data = exchange(other._data, nullptr);
-                    swap(_size, other._size);
+                    if (count.compare_exchange_weak(
+                        _current, _current + 1, memory_order_acquire, memory_order_relaxed))
+                    {
+                        return true;
+                    }
                 }
 
-                template <typename U = T>
-                inline storage(const storage<U, Allocator>& other)
-                requires (CopyConstructible<alloc_type>)
-                    : _alloc{other._alloc}, _data{other._data}, _size{other._size}
-                {}
-
-                template <typename U = T>
-                inline storage(const storage<U, Allocator>& other)
-                requires (!CopyConstructible<alloc_type>)
-                    : _data{other._data}, _size{other._size}
-                {}
-
-                template <typename U = T>
-                inline storage(storage<U, Allocator>&& other)
-                requires (MoveConstructible<alloc_type>)
-                    : _alloc{move(other._alloc)}
-                {
-                    _data = exchange(other._data, nullptr);
-                    swap(_size, other._size);
-                }
+                return false;
+            }
 
-                template <typename U = T>
-                inline storage(storage<U, Allocator>&& other)
-                requires (!MoveConstructible<alloc_type>)
-                {
-                    _data = exchange(other._data, nullptr);
-                    swap(_size, other._size);
-                }
+            static inline usize load(const count_type& count)
+            {
+                return count.load(memory_order_acquire);
+            }
+        };
 
-                inline storage& operator=(const storage& rhs)
-                {
-                    _alloc = rhs._alloc;
-                    _data = rhs._data;
-                    _size = rhs._size;
-                    return *this;
-                }
+        // Stateless allocators get a fresh instance for the new type,
+        // stateful ones are converted, so they keep their state
+        template <typename U, template <typename> typename Allocator, typename T>
+        static inline Allocator<U> rebind(const Allocator<T>& alloc)
+        {
+            if constexpr (DefaultConstructible<Allocator<U>>)
+            {
+                return Allocator<U>{};
+            }
+            else
+            {
+                return Allocator<U>{alloc};
+            }
+        }
 
-                inline storage& operator=(storage&& rhs)
-                {
-                    _alloc = rhs._alloc;
-                    _data = exchange(rhs._data, nullptr);                    
-                    swap(_size, rhs._size);
-                    return *this;
-                }
+        // Reference counts shared by every owner of an object. All
+        // the strong references together hold a single weak one, the
+        // block itself is freed when the weak count drops to zero
+        template <typename Policy>
+        class control_block
+        {
+        private:
+            typename Policy::count_type _strong = 1;
+            typename Policy::count_type _weak = 1;
 
-                template <typename U = T>
-                inline storage& operator=(const storage<U, Allocator>& rhs)
-                {
-                    _alloc = rhs._alloc;
-                    _data = rhs._data;
-                    _size = rhs._size;
-                    return *this;
-                }
+        protected:
+            virtual void _destroy_object() = 0;
+            virtual void _deallocate_self() = 0;
 
-                template <typename U = T>
-                inline storage& operator=(storage<U, Allocator>&& rhs)
-                {
-                    _alloc = rhs._alloc; 
-                    _data = exchange(rhs._data, nullptr);               
-                    swap(_size, rhs._size);
-                    return *this;
-                }
+        public:
+            virtual ~control_block() = default;
 
-                inline auto deallocate()
-                {
-                    return _alloc.deallocate(_data, _size);
-                }
+            inline void add_ref()
+            {
+                Policy::increment(_strong);
+            }
 
-                inline usize get_size() const
+            inline void release()
+            {
+                if (Policy::release(_strong))
                 {
-                    return _size;
+                    _destroy_object();
+                    release_weak();
                 }
+            }
 
-                inline auto* get_pointer() const
-                {
-                    return _data;
-                }
+            // Fails once the object is gone, used by weak_ptr::lock
+            inline bool try_add_ref()
+            {
+                return Policy::try_increment(_strong);
+            }
 
-                inline void set_pointer(pointer_type ptr)
-                {
-                    this->_data = ptr;
-                }
+            inline void add_weak()
+            {
+                Policy::increment(_weak);
+            }
 
-                inline void set_size(usize size)
+            inline void release_weak()
+            {
+                if (Policy::release(_weak))
                 {
-                    _size = size;
+                    _deallocate_self();
                 }
-            };
+            }
 
-            template < template <typename> typename Allocator >
-            class counter
+            inline usize use_count() const
             {
-            public:
-                using alloc_type = Allocator<usize>;
-                using pointer_type = typename alloc_type::pointer_type;
-                using value_type = typename alloc_type::value_type;
-
-            private:
-                alloc_type _alloc;
-                usize* _data = nullptr;
-
-                template < template <typename> typename Alloc >
-                friend class counter;                
+                return Policy::load(_strong);
+            }
+        };
 
-            public:
-                inline counter()
-                requires (DefaultConstructible<alloc_type>)
-                {
-                    _data = _alloc.allocate(1).unwrap();
-                    *_data = 1;
-                }
+        template <typename T>
+        static inline void destroy_elements(T* ptr, usize size)
+        {
+            // Reverse order of construction
+            while (size != 0)
+            {
+                ptr[--size].~T();
+            }
+        }
 
-                inline counter(const alloc_type& alloc)
-                requires (CopyConstructible<alloc_type>)
-                    : _alloc{alloc}
-                {
-                    _data = _alloc.allocate(1).unwrap();
-                    *_data = 1;
-                }
+        // The object (or the array) lives right after the counts, so
+        // a make_shared costs one allocation and the first access to
+        // the object usually lands on the same cache line as the counts.
+        // The block gets allocated in units of itself, array elements
+        // past the first one spill into the trailing units
+        template < typename T, template <typename> typename Allocator, typename Policy >
+        class inplace_block final
+            : public control_block<Policy>
+        {
+        private:
+            // A stateless allocator adds nothing to the block
+            compressed_pair<Allocator<T>, usize> _alloc_size;
+            alignas(T) uchar _storage[sizeof(T)];
 
-                inline counter(usize* ptr)
-                requires (DefaultConstructible<alloc_type>)
-                    : _data{ptr}
-                {
-                    (*_data)++;
-                }
+            inline inplace_block(const Allocator<T>& alloc, usize size)
+                : _alloc_size{alloc, size}
+            {}
 
-                inline counter(const alloc_type& alloc, usize* ptr)
-                requires (CopyConstructible<alloc_type>)
-                    : _alloc{alloc}, _data{ptr}
-                {
-                    (*_data)++;
-                }
+            static inline usize _units(usize size)
+            {
+                if (size <= 1)
+                    return 1;
 
-                inline counter(const counter& other)
-                requires (CopyConstructible<alloc_type>)
-                    : _alloc{other._alloc}, _data{other._data}
-                {
-                    (*_data)++;
-                }
+                return 1 + ((size - 1) * sizeof(T) +
+                    sizeof(inplace_block) - 1) / sizeof(inplace_block);
+            }
 
-                inline counter(const counter& other)
-                requires (!CopyConstructible<alloc_type>)
-                    : _data{other._data}
-                {
-                    (*_data)++;
-                }
+            virtual void _destroy_object() override
+            {
+                destroy_elements(get(), _alloc_size.second());
+            }
 
-                inline counter& operator=(const counter& rhs)
-                {
-                    _data = rhs._data;
-                    (*_data)++;
-                    return *this;
-                }
+            virtual void _deallocate_self() override
+            {
+                auto _block_alloc = rebind<inplace_block>(_alloc_size.first());
+                usize _count = _units(_alloc_size.second());
 
-                inline counter& operator=(counter&& rhs)
-                {
-                    _data = exchange(rhs._data, nullptr);
-                    return *this;
-                }
+                this->~inplace_block();
+                _block_alloc.deallocate(this, _count).unwrap();
+            }
 
-                inline usize& operator*()
-                {
-                    return *_data;
-                }
+        public:
+            inline T* get()
+            {
+                return std::launder(reinterpret_cast<T*>(_storage));
+            }
 
-                inline auto deallocate()
-                {
-                    return _alloc.deallocate(_data, 1);
-                }
+            // A single object is built from args, with no
+            // args every element gets value-initialized
+            template <typename... Args>
+            static inline inplace_block* create(
+                const Allocator<T>& alloc, usize size, Args&&... args)
+            {
+                auto _block_alloc = rebind<inplace_block>(alloc);
+                auto* _block = _block_alloc.allocate(_units(size)).unwrap();
+                new (_block) inplace_block{alloc, size};
 
-                inline usize get_size() const
+                if constexpr (sizeof...(Args) != 0)
                 {
-                    return 1u;
+                    Allocator<T>::construct_at(_block->get(), forward<Args>(args)...);
                 }
-
-                inline auto* get_pointer() const
+                else
                 {
-                    return _data;
+                    for (usize _index = 0; _index < size; _index++)
+                    {
+                        Allocator<T>::construct_at(&_block->get()[_index]);
+                    }
                 }
 
-                inline void set_pointer(pointer_type ptr)
-                {
-                    _data = ptr;
-                }
-            };
-            
-        } // namespace shared_detail
+                return _block;
+            }
+        };
 
-        template < typename T, template <typename> typename Allocator = allocator >
-        class shared_ptr
+        // Takes over a pointer allocated elsewhere, the object and the
+        // counts sit in two separate allocations
+        template < typename T, template <typename> typename Allocator, typename Policy >
+        class pointer_block final
+            : public control_block<Policy>
         {
         private:
-            shared_detail::storage<T, Allocator> _value;
-            shared_detail::counter<Allocator> _count{};
+            compressed_pair<Allocator<T>, T*> _alloc_ptr;
+            usize _size;
 
-            template <typename U, template <typename> typename Alloc>
-            friend class shared_ptr;
+            inline pointer_block(T* ptr, const Allocator<T>& alloc, usize size)
+                : _alloc_ptr{alloc, ptr}, _size{size}
+            {}
 
-            inline void _delete()
+            virtual void _destroy_object() override
             {
-                using value_type = typename shared_detail::storage<T, Allocator>::value_type;
+                destroy_elements(_alloc_ptr.second(), _size);
+                _alloc_ptr.first().deallocate(_alloc_ptr.second(), _size).unwrap();
+            }
 
-                if (_count.get_pointer() != nullptr)
-                {
-                    (*_count)--;
+            virtual void _deallocate_self() override
+            {
+                auto _block_alloc = rebind<pointer_block>(_alloc_ptr.first());
 
-                    if (*_count == 0)
-                    {
-                        if (get() != nullptr) 
-                        {
-                            if constexpr (is_array<T>::value)
-                            {
-                                for (usize i = 0, size = _value.get_size(); i < size; ++i)
-                                    get()[size-i].~value_type();
-                            }
-                            else
-                            {
-                                get()->~value_type();
-                            }
-                        }
-                        _value.deallocate().unwrap();
-                        _count.deallocate().unwrap();
-                    }
+                this->~pointer_block();
+                _block_alloc.deallocate(this, 1).unwrap();
+            }
 
-                    _value.set_pointer(nullptr);
-                    _count.set_pointer(nullptr);
-                }
+        public:
+            static inline pointer_block* create(
+                T* ptr, const Allocator<T>& alloc, usize size)
+            {
+                auto _block_alloc = rebind<pointer_block>(alloc);
+                auto* _block = _block_alloc.allocate(1).unwrap();
+                return new (_block) pointer_block{ptr, alloc, size};
             }
+        };
 
+        struct make_tag {};
+
+        template < typename T, template <typename> typename Allocator, typename Policy >
+        class weak_ptr;
+
+        template < typename T, template <typename> typename Allocator, typename Policy >
+        class shared_ptr
+        {
         public:
             using alloc_type = Allocator< remove_array_t<T> >;
             using pointer_type = typename alloc_type::pointer_type;
             using value_type = typename alloc_type::value_type;
             using reference_type = typename alloc_type::value_type&;
 
+        private:
+            using block_type = control_block<Policy>;
+
+            value_type* _ptr = nullptr;
+            block_type* _block = nullptr;
+
+            template <typename U, template <typename> typename Alloc, typename Pol>
+            friend class shared_ptr;
+
+            template <typename U, template <typename> typename Alloc, typename Pol>
+            friend class weak_ptr;
+
+            inline void _adopt(pointer_type ptr, const alloc_type& alloc, usize size)
+            {
+                if (ptr != nullptr)
+                {
+                    _ptr = ptr;
+                    _block = pointer_block<value_type, Allocator, Policy>::create(
+                        ptr, alloc, size
+                    );
+                }
+            }
+
+            inline void _delete()
+            {
+                if (_block != nullptr)
+                {
+                    exchange(_block, nullptr)->release();
+                    _ptr = nullptr;
+                }
+            }
+
+        public:
             inline shared_ptr() = default;
             inline shared_ptr(NullType) {}
 
-            inline shared_ptr(pointer_type ptr) 
+            inline shared_ptr(pointer_type ptr)
             requires (DefaultConstructible<alloc_type>)
-                : _value{ptr, 1u}
-            {}
+            {
+                _adopt(ptr, alloc_type{}, 1u);
+            }
 
-            inline shared_ptr(pointer_type ptr, usize size) 
+            inline shared_ptr(pointer_type ptr, usize size)
             requires (DefaultConstructible<alloc_type>)
-                : _value{ptr, size}
-            {}
+            {
+                _adopt(ptr, alloc_type{}, size);
+            }
 
-            inline shared_ptr(const alloc_type& alloc) 
-                : _value{alloc, 1u}, _count{alloc}
+            inline shared_ptr(const alloc_type& alloc)
+                : shared_ptr{make_tag{}, alloc, 1u}
             {}
 
-            inline shared_ptr(const alloc_type& alloc, usize size) 
-                : _value{alloc, size}, _count{alloc}
+            inline shared_ptr(const alloc_type& alloc, usize size)
+                : shared_ptr{make_tag{}, alloc, size}
             {}
 
-            inline shared_ptr(pointer_type ptr, 
-                const alloc_type& alloc, usize size) 
-                : _value{ptr, alloc, size}, _count{alloc}
-            {}
+            inline shared_ptr(pointer_type ptr,
+                const alloc_type& alloc, usize size)
+            {
+                _adopt(ptr, alloc, size);
+            }
+
+            // Object and counts in a single allocation, used by make_shared
+            template <typename... Args>
+            inline shared_ptr(make_tag, const alloc_type& alloc, usize size, Args&&... args)
+            {
+                auto* _inplace = inplace_block<value_type, Allocator, Policy>::create(
+                    alloc, size, forward<Args>(args)...
+                );
+
+                _ptr = _inplace->get();
+                _block = _inplace;
+            }
+
+            inline shared_ptr(const shared_ptr& other)
+                : _ptr{other._ptr}, _block{other._block}
+            {
+                if (_block != nullptr)
+                    _block->add_ref();
+            }
 
-            template <typename U = T> 
-            inline shared_ptr(const shared_ptr<U, Allocator>& other)
-            requires(shared_detail::ConvertibleDerived<T, U>)
-                : _value{other._value}, _count{other._count}
+            inline shared_ptr(shared_ptr&& other)
+                : _ptr{exchange(other._ptr, nullptr)},
+                _block{exchange(other._block, nullptr)}
             {}
 
-            template <typename U = T> 
-            inline shared_ptr(shared_ptr<U, Allocator>&& other)
-            requires(shared_detail::ConvertibleDerived<T, U>)
-                : _value{move(other._value)}, _count{move(other._count)}
+            template <typename U = T>
+            inline shared_ptr(const shared_ptr<U, Allocator, Policy>& other)
+            requires(ConvertibleDerived<T, U>)
+                : _ptr{other._ptr}, _block{other._block}
+            {
+                if (_block != nullptr)
+                    _block->add_ref();
+            }
+
+            template <typename U = T>
+            inline shared_ptr(shared_ptr<U, Allocator, Policy>&& other)
+            requires(ConvertibleDerived<T, U>)
+                : _ptr{exchange(other._ptr, nullptr)},
+                _block{exchange(other._block, nullptr)}
             {}
 
             inline ~shared_ptr()
@@ -366,23 +404,49 @@ namespace hsd
                 return *this;
             }
 
-            template <typename U = T> 
-            requires(shared_detail::ConvertibleDerived<T, U>)
-            inline shared_ptr& operator=(shared_ptr<U, Allocator>& rhs)
+            inline shared_ptr& operator=(const shared_ptr& rhs)
             {
+                if (rhs._block != nullptr)
+                    rhs._block->add_ref();
+
                 _delete();
-                _value = rhs._value;
-                _count = rhs._count;
+                _ptr = rhs._ptr;
+                _block = rhs._block;
                 return *this;
             }
 
-            template <typename U = T> 
-            requires(shared_detail::ConvertibleDerived<T, U>)
-            inline shared_ptr& operator=(shared_ptr<U, Allocator>&& rhs)
+            inline shared_ptr& operator=(shared_ptr&& rhs)
             {
+                if (this != &rhs)
+                {
+                    _delete();
+                    _ptr = exchange(rhs._ptr, nullptr);
+                    _block = exchange(rhs._block, nullptr);
+                }
+
+                return *this;
+            }
+
+            template <typename U = T>
+            requires(ConvertibleDerived<T, U>)
+            inline shared_ptr& operator=(const shared_ptr<U, Allocator, Policy>& rhs)
+            {
+                if (rhs._block != nullptr)
+                    rhs._block->add_ref();
+
                 _delete();
-                _value = move(rhs._value);
-                _count = move(rhs._count);
+                _ptr = rhs._ptr;
+                _block = rhs._block;
+                return *this;
+            }
+
+            template <typename U = T>
+            requires(ConvertibleDerived<T, U>)
+            inline shared_ptr& operator=(shared_ptr<U, Allocator, Policy>&& rhs)
+            {
+                _delete();
+                _ptr = exchange(rhs._ptr, nullptr);
+                _block = exchange(rhs._block, nullptr);
                 return *this;
             }
 
@@ -393,7 +457,7 @@ namespace hsd
 
             inline bool operator!=(const shared_ptr& rhs) const
             {
-                return get() == rhs.get();
+                return get() != rhs.get();
             }
 
             inline bool operator==(NullType) const
@@ -403,17 +467,17 @@ namespace hsd
 
             inline bool operator!=(NullType) const
             {
-                return get() == nullptr;
+                return get() != nullptr;
             }
 
             inline auto* get()
             {
-                return _value.get_pointer();
+                return _ptr;
             }
 
             inline auto* get() const
             {
-                return _value.get_pointer();
+                return _ptr;
             }
 
             inline auto* operator->()
@@ -436,555 +500,257 @@ namespace hsd
                 return *get();
             }
 
-            inline usize get_count()
+            inline usize get_count() const
             {
-                return *_count;
+                return _block == nullptr ? 0 : _block->use_count();
             }
 
-            inline bool is_unique()
+            inline bool is_unique() const
             {
                 return get_count() == 1;
             }
         };
 
-        template < typename T, template <typename> typename Allocator >
-        struct MakeShr
-        {
-            using single_object = shared_ptr<T, Allocator>;
-        };
-
-        template < typename T, template <typename> typename Allocator >
-        struct MakeShr<T[], Allocator>
-        {
-            using array = shared_ptr<T[], Allocator>;
-        };
-
-        template < typename T, usize N, template <typename> typename Allocator >
-        struct MakeShr<T[N], Allocator>
-        {
-            struct invalid_type {};  
-        };
-
-        template < typename T, template <typename> typename Allocator = allocator, typename... Args >
-        requires (DefaultConstructible<Allocator<uchar>>)
-        static inline typename MakeShr<T, Allocator>::single_object 
-        make_shared(Args&&... args)
-        {
-            Allocator<remove_array_t<T>> _alloc;
-            auto* _ptr = _alloc.allocate(1).unwrap();
-            _alloc.construct_at(_ptr, forward<Args>(args)...);
-            return shared_ptr<T, Allocator>(_ptr);
-        }
-
-        template < typename T, template <typename> typename Allocator = allocator, typename U, typename... Args >
-        static inline typename MakeShr<T, Allocator>::single_object 
-        make_shared(Allocator<U>& alloc, Args&&... args)
+        // Refers to an object owned by shared pointers without keeping
+        // it alive, only the control block stays around. For a block
+        // made by make_shared that's also the object's storage, its
+        // destructor has run but the memory waits for the last weak_ptr
+        template < typename T, template <typename> typename Allocator, typename Policy >
+        class weak_ptr
         {
-            auto* _ptr = static_cast<Allocator<remove_array_t<T>>>(alloc).allocate(1).unwrap();
-            Allocator<remove_array_t<T>>::construct_at(_ptr, forward<Args>(args)...);
-            return shared_ptr<T, Allocator>(_ptr, static_cast<Allocator<remove_array_t<T>>>(alloc), 1);
-        }
-
-        template < typename T, template <typename> typename Allocator = allocator >
-        requires (DefaultConstructible<Allocator<uchar>>)
-        static inline typename MakeShr<T, Allocator>::array
-        make_shared(usize size)
-        {
-            Allocator<remove_array_t<T>> _alloc;
-            auto* _ptr = _alloc.allocate(size).unwrap();
-            return shared_ptr<T, Allocator>(_ptr, size);
-        }
-
-        template < typename T, template <typename> typename Allocator = allocator, typename U >
-        static inline typename MakeShr<T, Allocator>::array
-        make_shared(Allocator<U>& alloc, usize size)
-        {
-            return shared_ptr<T, Allocator>(static_cast<Allocator<remove_array_t<T>>>(alloc), size);
-        }
-
-        template < typename T, template <typename> typename Allocator = allocator, typename... Args >
-        static inline typename MakeShr<T, Allocator>::invalid_type 
-        make_shared(Args&&...) = delete;
-    }
-
-    namespace atomic_types
-    {
-        namespace shared_detail
-        {
-            template <typename Base, typename Derived>
-            concept ConvertibleDerived = (
-                Convertible<Derived, Base> || 
-                std::is_base_of_v<Base, Derived>
-            );
-
-            template < typename T, template <typename> typename Allocator >
-            class storage
-            {
-            public:
-                using alloc_type = Allocator<remove_array_t<T>>;
-                using pointer_type = typename alloc_type::pointer_type;
-                using value_type = typename alloc_type::value_type;
-
-            private:
-                alloc_type _alloc;
-                pointer_type _data = nullptr;
-                usize _size = 0;
-
-                template <typename U, template <typename> typename Alloc>
-                friend class storage;
-
-            public:
-                inline storage()
-                requires (DefaultConstructible<alloc_type>) = default;
-
-                inline storage(pointer_type ptr, usize size)
-                requires (DefaultConstructible<alloc_type>)
-                    : _data{ptr}, _size{size}
-                {}
-
-                inline storage(const alloc_type& alloc, usize size)
-                requires (CopyConstructible<value_type>)
-                    : _alloc{alloc}, _size{size}
-                {
-                    _data = _alloc.allocate(size).unwrap();
-                    _alloc.construct_at(_data);
-
-                    for (usize _index = 0; _index < size; _index++)
-                        _alloc.construct_at(&_data[_index]);
-                }
-
-                inline storage(pointer_type ptr, const alloc_type& alloc, usize size)
-                requires (CopyConstructible<value_type>)
-                    : _alloc{alloc}, _data{ptr}, _size{size}
-                {}
-
-                inline storage(const storage& other)
-                requires (CopyConstructible<alloc_type>)
-                    : _alloc{other._alloc}, _data{other._data}, _size{other._size}
-                {}
-
-                inline storage(const storage& other)
-                requires (!CopyConstructible<alloc_type>)
-                    : _data{other._data}, _size{other._size}
-                {}
-
-                inline storage(storage&& other)
-                requires (MoveConstructible<alloc_type>)
-                    : _alloc{move(other._alloc)}
-                {
-                    _data = exchange(other._data, nullptr);
-                    swap(_size, other._size);
-                }
-
-                inline storage(storage&& other)
-                requires (!MoveConstructible<alloc_type>)
-                {
-                    _data = exchange(other._data, nullptr);
-                    swap(_size, other._size);
-                }
-
-                template <typename U = T>
-                inline storage(const storage<U, Allocator>& other)
-                requires (CopyConstructible<alloc_type>)
-                    : _alloc{other._alloc}, _data{other._data}, _size{other._size}
-                {}
-
-                template <typename U = T>
-                inline storage(const storage<U, Allocator>& other)
-                requires (!CopyConstructible<alloc_type>)
-                    : _data{other._data}, _size{other._size}
-                {}
-
-                template <typename U = T>
-                inline storage(storage<U, Allocator>&& other)
-                requires (MoveConstructible<alloc_type>)
-                    : _alloc{move(other._alloc)}
-                {
-                    _data = exchange(other._data, nullptr);
-                    swap(_size, other._size);
-                }
-
-                template <typename U = T>
-                inline storage(storage<U, Allocator>&& other)
-                requires (!MoveConstructible<alloc_type>)
-                {
-                    _data = exchange(other._data, nullptr);
-                    swap(_size, other._size);
-                }
-
-                inline storage& operator=(const storage& rhs)
-                {
-                    _alloc = rhs._alloc;
-                    _data = rhs._data;
-                    _size = rhs._size;
-                    return *this;
-                }
-
-                inline storage& operator=(storage&& rhs)
-                {
-                    _alloc = rhs._alloc;
-                    _data = exchange(rhs._data, nullptr);                    
-                    swap(_size, rhs._size);
-                    return *this;
-                }
-
-                template <typename U = T>
-                inline storage& operator=(const storage<U, Allocator>& rhs)
-                {
-                    _alloc = rhs._alloc;
-                    _data = rhs._data;
-                    _size = rhs._size;
-                    return *this;
-                }
-
-                template <typename U = T>
-                inline storage& operator=(storage<U, Allocator>&& rhs)
-                {
-                    _alloc = rhs._alloc; 
-                    _data = exchange(rhs._data, nullptr);               
-                    swap(_size, rhs._size);
-                    return *this;
-                }
-
-                inline auto deallocate()
-                {
-                    return _alloc.deallocate(_data, _size);
-                }
-
-                inline usize get_size() const
-                {
-                    return _size;
-                }
+        public:
+            using shared_type = shared_ptr<T, Allocator, Policy>;
+            using value_type = typename shared_type::value_type;
 
-                inline auto* get_pointer() const
-                {
-                    return _data;
-                }
+        private:
+            using block_type = control_block<Policy>;
 
-                inline void set_pointer(pointer_type ptr)
-                {
-                    this->_data = ptr;
-                }
+            value_type* _ptr = nullptr;
+            block_type* _block = nullptr;
 
-                inline void set_size(usize size)
-                {
-                    _size = size;
-                }
-            };
+            template <typename U, template <typename> typename Alloc, typename Pol>
+            friend class weak_ptr;
 
-            template < template <typename> typename Allocator >
-            class counter
+            inline void _delete()
             {
-            public:
-                using alloc_type = Allocator<atomic_usize>;
-                using pointer_type = typename alloc_type::pointer_type;
-                using value_type = typename alloc_type::value_type;
-
-            private:
-                alloc_type _alloc;
-                atomic_usize* _data = nullptr;
-
-                template < template <typename> typename Alloc >
-                friend class counter;                
-
-            public:
-                inline counter()
-                requires (DefaultConstructible<alloc_type>)
+                if (_block != nullptr)
                 {
-                    _data = _alloc.allocate(1).unwrap();
-                    *_data = 1;
+                    exchange(_block, nullptr)->release_weak();
+                    _ptr = nullptr;
                 }
+            }
 
-                inline counter(const alloc_type& alloc)
-                requires (CopyConstructible<alloc_type>)
-                    : _alloc{alloc}
-                {
-                    _data = _alloc.allocate(1).unwrap();
-                    *_data = 1;
-                }
-
-                inline counter(atomic_usize* ptr)
-                requires (DefaultConstructible<alloc_type>)
-                    : _data{ptr}
-                {
-                    (*_data)++;
-                }
-
-                inline counter(const alloc_type& alloc, atomic_usize* ptr)
-                requires (CopyConstructible<alloc_type>)
-                    : _alloc{alloc}, _data{ptr}
-                {
-                    (*_data)++;
-                }
-
-                inline counter(const counter& other)
-                requires (CopyConstructible<alloc_type>)
-                    : _alloc{other._alloc}, _data{other._data}
-                {
-                    (*_data)++;
-                }
-
-                inline counter(const counter& other)
-                requires (!CopyConstructible<alloc_type>)
-                    : _data{other._data}
-                {
-                    (*_data)++;
-                }
-
-                inline counter& operator=(const counter& rhs)
-                {
-                    _data = rhs._data;
-                    (*_data)++;
-                    return *this;
-                }
-
-                inline counter& operator=(counter&& rhs)
-                {
-                    _data = exchange(rhs._data, nullptr);
-                    return *this;
-                }
-
-                inline atomic_usize& operator*()
-                {
-                    return *_data;
-                }
-
-                inline auto deallocate()
-                {
-                    return _alloc.deallocate(_data, 1);
-                }
-
-                inline usize get_size() const
-                {
-                    return 1u;
-                }
-
-                inline auto* get_pointer() const
-                {
-                    return _data;
-                }
-
-                inline void set_pointer(pointer_type ptr)
-                {
-                    _data = ptr;
-                }
-            };
-            
-        } // namespace shared_detail
-
-        template < typename T, template <typename> typename Allocator = allocator >
-        class shared_ptr
-        {
-        private:
-            shared_detail::storage<T, Allocator> _value;
-            shared_detail::counter<Allocator> _count{};
-
-            template <typename U, template <typename> typename Alloc>
-            friend class shared_ptr;
-
-            inline void _delete()
+            inline void _assign(value_type* ptr, block_type* block)
             {
-                using value_type = typename shared_detail::storage<T, Allocator>::value_type;
+                if (block != nullptr)
+                    block->add_weak();
 
-                if (_count.get_pointer() != nullptr)
-                {
-                    (*_count)--;
-
-                    if (*_count == 0)
-                    {
-                        if (get() != nullptr) 
-                        {
-                            if constexpr (is_array<T>::value)
-                            {
-                                for (usize i = 0, size = _value.get_size(); i < size; ++i)
-                                    get()[size-i].~value_type();
-                            }
-                            else
-                            {
-                                get()->~value_type();
-                            }
-                        }
-                        _value.deallocate().unwrap();
-                        _count.deallocate().unwrap();
-                    }
-
-                    _value.set_pointer(nullptr);
-                    _count.set_pointer(nullptr);
-                }
+                _delete();
+                _ptr = ptr;
+                _block = block;
             }
 
         public:
-            using alloc_type = Allocator< remove_array_t<T> >;
-            using pointer_type = typename alloc_type::pointer_type;
-            using value_type = typename alloc_type::value_type;
-            using reference_type = typename alloc_type::value_type&;
-
-            inline shared_ptr() = default;
-            inline shared_ptr(NullType) {}
-
-            inline shared_ptr(pointer_type ptr) 
-            requires (DefaultConstructible<alloc_type>)
-                : _value{ptr, 1u}
-            {}
-
-            inline shared_ptr(pointer_type ptr, usize size) 
-            requires (DefaultConstructible<alloc_type>)
-                : _value{ptr, size}
-            {}
-
-            inline shared_ptr(const alloc_type& alloc) 
-                : _value{alloc, 1u}, _count{alloc}
-            {}
+            inline weak_ptr() = default;
+            inline weak_ptr(NullType) {}
 
-            inline shared_ptr(const alloc_type& alloc, usize size) 
-                : _value{alloc, size}, _count{alloc}
-            {}
-
-            inline shared_ptr(pointer_type ptr, 
-                const alloc_type& alloc, usize size) 
-                : _value{ptr, alloc, size}, _count{alloc}
-            {}
+            template <typename U = T>
+            inline weak_ptr(const shared_ptr<U, Allocator, Policy>& other)
+            requires(ConvertibleDerived<T, U>)
+                : _ptr{other._ptr}, _block{other._block}
+            {
+                if (_block != nullptr)
+                    _block->add_weak();
+            }
 
-            template <typename U = T> 
-            inline shared_ptr(const shared_ptr<U, Allocator>& other)
-            requires(shared_detail::ConvertibleDerived<T, U>)
-                : _value{other._value}, _count{other._count}
-            {}
+            inline weak_ptr(const weak_ptr& other)
+                : _ptr{other._ptr}, _block{other._block}
+            {
+                if (_block != nullptr)
+                    _block->add_weak();
+            }
 
-            template <typename U = T> 
-            inline shared_ptr(shared_ptr<U, Allocator>&& other)
-            requires(shared_detail::ConvertibleDerived<T, U>)
-                : _value{move(other._value)}, _count{move(other._count)}
+            inline weak_ptr(weak_ptr&& other)
+                : _ptr{exchange(other._ptr, nullptr)},
+                _block{exchange(other._block, nullptr)}
             {}
 
-            inline ~shared_ptr()
+            template <typename U = T>
+            inline weak_ptr(const weak_ptr<U, Allocator, Policy>& other)
+            requires(ConvertibleDerived<T, U>)
+                : _ptr{other._ptr}, _block{other._block}
             {
-                _delete();
+                if (_block != nullptr)
+                    _block->add_weak();
             }
 
-            inline shared_ptr& operator=(NullType)
+            inline ~weak_ptr()
             {
                 _delete();
-                return *this;
             }
 
-            template <typename U = T> 
-            requires(shared_detail::ConvertibleDerived<T, U>)
-            inline shared_ptr& operator=(shared_ptr<U, Allocator>& rhs)
+            inline weak_ptr& operator=(NullType)
             {
                 _delete();
-                _value = rhs._value;
-                _count = rhs._count;
                 return *this;
             }
 
-            template <typename U = T> 
-            requires(shared_detail::ConvertibleDerived<T, U>)
-            inline shared_ptr& operator=(shared_ptr<U, Allocator>&& rhs)
+            inline weak_ptr& operator=(const weak_ptr& rhs)
             {
-                _delete();
-                _value = move(rhs._value);
-                _count = move(rhs._count);
+                _assign(rhs._ptr, rhs._block);
                 return *this;
             }
 
-            inline bool operator==(const shared_ptr& rhs) const
-            {
-                return get() == rhs.get();
-            }
-
-            inline bool operator!=(const shared_ptr& rhs) const
+            inline weak_ptr& operator=(weak_ptr&& rhs)
             {
-                return get() == rhs.get();
-            }
-
-            inline bool operator==(NullType) const
-            {
-                return get() == nullptr;
-            }
-
-            inline bool operator!=(NullType) const
-            {
-                return get() == nullptr;
-            }
+                if (this != &rhs)
+                {
+                    _delete();
+                    _ptr = exchange(rhs._ptr, nullptr);
+                    _block = exchange(rhs._block, nullptr);
+                }
 
-            inline auto* get()
-            {
-                return _value.get_pointer();
+                return *this;
             }
 
-            inline auto* get() const
+            template <typename U = T>
+            requires(ConvertibleDerived<T, U>)
+            inline weak_ptr& operator=(const shared_ptr<U, Allocator, Policy>& rhs)
             {
-                return _value.get_pointer();
+                _assign(rhs._ptr, rhs._block);
+                return *this;
             }
 
-            inline auto* operator->()
+            // An owning pointer if the object is still alive, null if not
+            inline shared_type lock() const
             {
-                return get();
-            }
+                shared_type _result;
 
-            inline auto* operator->() const
-            {
-                return get();
-            }
+                if (_block != nullptr && _block->try_add_ref())
+                {
+                    _result._ptr = _ptr;
+                    _result._block = _block;
+                }
 
-            inline auto& operator*()
-            {
-                return *get();
+                return _result;
             }
 
-            inline auto& operator*() const
+            inline usize get_count() const
             {
-                return *get();
+                return _block == nullptr ? 0 : _block->use_count();
             }
 
-            inline usize get_count()
+            inline bool expired() const
             {
-                return *_count;
-            }
-
-            inline bool is_unique()
-            {
-                return get_count() == 1;
+                return get_count() == 0;
             }
         };
 
-        template < typename T, template <typename> typename Allocator >
+        template < typename T, template <typename> typename Allocator, typename Policy >
         struct MakeShr
         {
-            using single_object = shared_ptr<T, Allocator>;
+            using single_object = shared_ptr<T, Allocator, Policy>;
         };
 
-        template < typename T, template <typename> typename Allocator >
-        struct MakeShr<T[], Allocator>
+        template < typename T, template <typename> typename Allocator, typename Policy >
+        struct MakeShr<T[], Allocator, Policy>
         {
-            using array = shared_ptr<T[], Allocator>;
+            using array = shared_ptr<T[], Allocator, Policy>;
         };
 
-        template < typename T, usize N, template <typename> typename Allocator >
-        struct MakeShr<T[N], Allocator>
+        template < typename T, usize N, template <typename> typename Allocator, typename Policy >
+        struct MakeShr<T[N], Allocator, Policy>
         {
-            struct invalid_type {};  
+            struct invalid_type {};
         };
+    } // namespace shared_detail
+
+    namespace non_atomic_types
+    {
+        template < typename T, template <typename> typename Allocator = allocator >
+        using shared_ptr = shared_detail::shared_ptr<T, Allocator, shared_detail::unsafe_count>;
+
+        template < typename T, template <typename> typename Allocator = allocator >
+        using weak_ptr = shared_detail::weak_ptr<T, Allocator, shared_detail::unsafe_count>;
+
+        template < typename T, template <typename> typename Allocator >
+        using MakeShr = shared_detail::MakeShr<T, Allocator, shared_detail::unsafe_count>;
+
+        template < typename T, template <typename> typename Allocator = allocator, typename... Args >
+        requires (DefaultConstructible<Allocator<uchar>>)
+        static inline typename MakeShr<T, Allocator>::single_object
+        make_shared(Args&&... args)
+        {
+            return shared_ptr<T, Allocator>(
+                shared_detail::make_tag{}, Allocator<remove_array_t<T>>{},
+                1u, forward<Args>(args)...
+            );
+        }
+
+        template < typename T, template <typename> typename Allocator = allocator, typename U, typename... Args >
+        static inline typename MakeShr<T, Allocator>::single_object
+        make_shared(Allocator<U>& alloc, Args&&... args)
+        {
+            return shared_ptr<T, Allocator>(
+                shared_detail::make_tag{}, static_cast<Allocator<remove_array_t<T>>>(alloc),
+                1u, forward<Args>(args)...
+            );
+        }
+
+        template < typename T, template <typename> typename Allocator = allocator >
+        requires (DefaultConstructible<Allocator<uchar>>)
+        static inline typename MakeShr<T, Allocator>::array
+        make_shared(usize size)
+        {
+            return shared_ptr<T, Allocator>(
+                shared_detail::make_tag{}, Allocator<remove_array_t<T>>{}, size
+            );
+        }
+
+        template < typename T, template <typename> typename Allocator = allocator, typename U >
+        static inline typename MakeShr<T, Allocator>::array
+        make_shared(Allocator<U>& alloc, usize size)
+        {
+            return shared_ptr<T, Allocator>(
+                shared_detail::make_tag{}, static_cast<Allocator<remove_array_t<T>>>(alloc), size
+            );
+        }
+
+        template < typename T, template <typename> typename Allocator = allocator, typename... Args >
+        static inline typename MakeShr<T, Allocator>::invalid_type
+        make_shared(Args&&...) = delete;
+    }
+
+    namespace atomic_types
+    {
+        template < typename T, template <typename> typename Allocator = allocator >
+        using shared_ptr = shared_detail::shared_ptr<T, Allocator, shared_detail::safe_count>;
+
+        template < typename T, template <typename> typename Allocator = allocator >
+        using weak_ptr = shared_detail::weak_ptr<T, Allocator, shared_detail::safe_count>;
+
+        template < typename T, template <typename> typename Allocator >
+        using MakeShr = shared_detail::MakeShr<T, Allocator, shared_detail::safe_count>;
 
         template < typename T, template <typename> typename Allocator = allocator, typename... Args >
         requires (DefaultConstructible<Allocator<uchar>>)
-        static inline typename MakeShr<T, Allocator>::single_object 
+        static inline typename MakeShr<T, Allocator>::single_object
         make_shared(Args&&... args)
         {
-            Allocator<remove_array_t<T>> _alloc;
-            auto* _ptr = _alloc.allocate(1).unwrap();
-            _alloc.construct_at(_ptr, forward<Args>(args)...);
-            return shared_ptr<T, Allocator>(_ptr);
+            return shared_ptr<T, Allocator>(
+                shared_detail::make_tag{}, Allocator<remove_array_t<T>>{},
+                1u, forward<Args>(args)...
+            );
         }
 
-        template < typename T, template <typename> typename Allocator = allocator, typename U, typename... Args> 
-        static inline typename MakeShr<T, Allocator>::single_object 
+        template < typename T, template <typename> typename Allocator = allocator, typename U, typename... Args>
+        static inline typename MakeShr<T, Allocator>::single_object
         make_shared(Allocator<U>& alloc, Args&&... args)
         {
-            auto* _ptr = static_cast<Allocator<remove_array_t<T>>>(alloc).allocate(1).unwrap();
-            Allocator<remove_array_t<T>>::construct_at(_ptr, forward<Args>(args)...);
-            return shared_ptr<T, Allocator>(_ptr, static_cast<Allocator<remove_array_t<T>>>(alloc), 1);
+            return shared_ptr<T, Allocator>(
+                shared_detail::make_tag{}, static_cast<Allocator<remove_array_t<T>>>(alloc),
+                1u, forward<Args>(args)...
+            );
         }
 
         template < typename T, template <typename> typename Allocator = allocator >
@@ -992,20 +758,22 @@ namespace hsd
         static inline typename MakeShr<T, Allocator>::array
         make_shared(usize size)
         {
-            Allocator<remove_array_t<T>> _alloc;
-            auto* _ptr = _alloc.allocate(size).unwrap();
-            return shared_ptr<T, Allocator>(_ptr, size);
+            return shared_ptr<T, Allocator>(
+                shared_detail::make_tag{}, Allocator<remove_array_t<T>>{}, size
+            );
         }
 
         template < typename T, template <typename> typename Allocator = allocator, typename U >
         static inline typename MakeShr<T, Allocator>::array
         make_shared(Allocator<U>& alloc, usize size)
         {
-            return shared_ptr<T, Allocator>(static_cast<Allocator<remove_array_t<T>>>(alloc), size);
+            return shared_ptr<T, Allocator>(
+                shared_detail::make_tag{}, static_cast<Allocator<remove_array_t<T>>>(alloc), size
+            );
         }
 
         template < typename T, template <typename> typename Allocator = allocator, typename... Args >
-        static inline typename MakeShr<T, Allocator>::invalid_type 
+        static inline typename MakeShr<T, Allocator>::invalid_type
         make_shared(Args&&...) = delete;
     }
 
@@ -1014,25 +782,34 @@ namespace hsd
     template < typename T, template <typename> typename Allocator = allocator >
     using safe_shared_ptr = atomic_types::shared_ptr<T, Allocator>;
 
+    template < typename T, template <typename> typename Allocator = allocator >
+    using unsafe_weak_ptr = non_atomic_types::weak_ptr<T, Allocator>;
+    template < typename T, template <typename> typename Allocator = allocator >
+    using safe_weak_ptr = atomic_types::weak_ptr<T, Allocator>;
+
     template < typename T, template <typename> typename Allocator = allocator, typename... Args >
+    requires (!is_array<T>::value)
     static inline auto make_unsafe_shared(Args&&... args)
     {
         return non_atomic_types::make_shared<T, Allocator, Args...>(forward<Args>(args)...);
     }
 
     template < typename T, template <typename> typename Allocator = allocator, typename... Args >
+    requires (!is_array<T>::value)
     static inline auto make_safe_shared(Args&&... args)
     {
         return atomic_types::make_shared<T, Allocator, Args...>(forward<Args>(args)...);
     }
 
     template < typename T, template <typename> typename Allocator = allocator, typename U, typename... Args >
+    requires (!is_array<T>::value)
     static inline auto make_unsafe_shared(Allocator<U>& alloc, Args&&... args)
     {
         return non_atomic_types::make_shared<T, Allocator, U, Args...>(alloc, forward<Args>(args)...);
     }
 
     template < typename T, template <typename> typename Allocator = allocator, typename U, typename... Args >
+    requires (!is_array<T>::value)
     static inline auto make_safe_shared(Allocator<U>& alloc, Args&&... args)
     {
         return atomic_types::make_shared<T, Allocator, U, Args...>(alloc, forward<Args>(args)...);
@@ -1061,4 +838,4 @@ namespace hsd
     {
         return atomic_types::make_shared<T, Allocator, U>(alloc, size);
     }
-}
\ No newline at end of file
+}
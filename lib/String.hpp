@@ -4,6 +4,7 @@
 #include "StringView.hpp"
 #include "Algorithm.hpp"
 #include "_SStreamDetail.hpp"
+#include "Extra/CompressedPair.hpp"
 
 namespace hsd
 {
@@ -15,15 +16,35 @@ namespace hsd
         static inline const CharT _s_empty = 0;
         using alloc_type = Allocator<CharT>;
         
-        alloc_type _alloc;
-        CharT* _data = nullptr;
+        // A stateless allocator takes no space next to the pointer
+        compressed_pair<alloc_type, CharT*> _alloc_data;
         usize _size = 0;
         usize _capacity = 0;
 
+        inline alloc_type& _alloc()
+        {
+            return _alloc_data.first();
+        }
+
+        inline const alloc_type& _alloc() const
+        {
+            return _alloc_data.first();
+        }
+
+        inline CharT*& _data()
+        {
+            return _alloc_data.second();
+        }
+
+        inline CharT* _data() const
+        {
+            return _alloc_data.second();
+        }
+
         inline void _reset()
         {
-            _alloc.deallocate(_data, _capacity + 1).unwrap();
-            _data = nullptr;
+            _alloc().deallocate(_data(), _capacity + 1).unwrap();
+            _data() = nullptr;
         }
 
     public:
@@ -38,89 +59,87 @@ namespace hsd
         template <typename Alloc = alloc_type>
         inline basic_string(const Alloc& alloc)
         requires (Constructible<alloc_type, const Alloc&>)
-            : _alloc{alloc}
+            : _alloc_data{alloc_type{alloc}, nullptr}
         {}
 
         inline basic_string(usize size)
         requires (DefaultConstructible<alloc_type>)
         {
-            _data = _alloc.allocate(size + 1).unwrap();
+            _data() = _alloc().allocate(size + 1).unwrap();
             _capacity = size;
         }
 
         template <typename Alloc = alloc_type>
         inline basic_string(usize size, const Alloc& alloc)
         requires (Constructible<alloc_type, Alloc>)
-            : _alloc{alloc}
+            : _alloc_data{alloc_type{alloc}, nullptr}
         {
-            _data = _alloc.allocate(size + 1).unwrap();
+            _data() = _alloc().allocate(size + 1).unwrap();
             _capacity = size;
         }
 
         inline basic_string(const CharT* cstr)
         requires (DefaultConstructible<alloc_type>)
-            : _alloc{}
         {
             _size = (cstr != nullptr) ? _str_utils::length(cstr) : 0;
             _capacity = _size;
-            _data = _alloc.allocate(_size + 1).unwrap();
+            _data() = _alloc().allocate(_size + 1).unwrap();
             
             if (cstr != nullptr)
             {
-                _str_utils::copy(_data, cstr, _size);
+                _str_utils::copy(_data(), cstr, _size);
             }
 
-            _data[_size] = static_cast<CharT>(0);
+            _data()[_size] = static_cast<CharT>(0);
         }
 
         template <typename Alloc = alloc_type>
         inline basic_string(const CharT* cstr, const Alloc& alloc)
         requires (Constructible<alloc_type, Alloc>)
-            : _alloc{alloc}
+            : _alloc_data{alloc_type{alloc}, nullptr}
         {
             _size = (cstr != nullptr) ? _str_utils::length(cstr) : 0;
             _capacity = _size;
-            _data = _alloc.allocate(_size + 1).unwrap();
+            _data() = _alloc().allocate(_size + 1).unwrap();
             
             if (cstr != nullptr)
             {
-                _str_utils::copy(_data, cstr, _size);
+                _str_utils::copy(_data(), cstr, _size);
             }
 
-            _data[_size] = static_cast<CharT>(0);
+            _data()[_size] = static_cast<CharT>(0);
         }
 
         inline basic_string(const CharT* cstr, usize size)
         requires (DefaultConstructible<alloc_type>)
-            : _alloc{}
         {
             _size = size;
             _capacity = _size;
-            _data = _alloc.allocate(_size + 1).unwrap();
+            _data() = _alloc().allocate(_size + 1).unwrap();
             
             if (cstr != nullptr)
             {
-                _str_utils::copy(_data, cstr, _size);
+                _str_utils::copy(_data(), cstr, _size);
             }
 
-            _data[_size] = static_cast<CharT>(0);
+            _data()[_size] = static_cast<CharT>(0);
         }
 
         template <typename Alloc = alloc_type>
         inline basic_string(const CharT* cstr, usize size, const Alloc& alloc)
         requires (Constructible<alloc_type, Alloc>)
-            : _alloc{alloc}
+            : _alloc_data{alloc_type{alloc}, nullptr}
         {
             _size = size;
             _capacity = _size;
-            _data = _alloc.allocate(_size + 1).unwrap();
+            _data() = _alloc().allocate(_size + 1).unwrap();
             
             if (cstr != nullptr)
             {
-                _str_utils::copy(_data, cstr, _size);
+                _str_utils::copy(_data(), cstr, _size);
             }
 
-            _data[_size] = static_cast<CharT>(0);
+            _data()[_size] = static_cast<CharT>(0);
         }
 
         inline basic_string(basic_string_view<CharT> view)
@@ -135,53 +154,52 @@ namespace hsd
         {}
 
         inline basic_string(const basic_string& other)
-            : _alloc{other._alloc}
+            : _alloc_data{other._alloc_data.first(), nullptr}
         {
             _size = other._size;
             _capacity = other._capacity;
-            _data = _alloc.allocate(_capacity + 1).unwrap();
+            _data() = _alloc().allocate(_capacity + 1).unwrap();
             
-            if (other._data != nullptr)
+            if (other._data() != nullptr)
             {
-                _str_utils::copy(_data, other._data, _size);
+                _str_utils::copy(_data(), other._data(), _size);
             }
 
-            _data[_size] = static_cast<CharT>(0);
+            _data()[_size] = static_cast<CharT>(0);
         }
 
         template <typename CharT2>
         inline basic_string(const basic_string<CharT2, Allocator>& other)
-            : _alloc{other._alloc}
+            : _alloc_data{alloc_type{other._alloc_data.first()}, nullptr}
         {
-            _size = _capacity = unicode::length(other._data);
-            _data = _alloc.allocate(_capacity + 1).unwrap();
+            _size = _capacity = unicode::length(other._data());
+            _data() = _alloc().allocate(_capacity + 1).unwrap();
             
             if constexpr (sizeof(CharT) == 1)
             {
-                unicode::to_utf8(_data, other._data);
+                unicode::to_utf8(_data(), other._data());
             }
             else if constexpr (sizeof(CharT) == 2)
             {
-                unicode::to_utf16(_data, other._data);
+                unicode::to_utf16(_data(), other._data());
             }
             else if constexpr (sizeof(CharT) == 4)
             {
-                unicode::to_utf32(_data, other._data);
+                unicode::to_utf32(_data(), other._data());
             }
             else
             {
                 panic("Unsupported character size");
             }
 
-            _data[_size] = static_cast<CharT>(0);
+            _data()[_size] = static_cast<CharT>(0);
         }
 
         inline basic_string(basic_string&& other)
-            : _alloc{move(other._alloc)}
+            : _alloc_data{move(other._alloc()), exchange(other._data(), nullptr)}
         {
             swap(_size, other._size);
             swap(_capacity, other._capacity);
-            swap(_data, other._data);
         }
 
         inline ~basic_string()
@@ -194,8 +212,8 @@ namespace hsd
             auto _new_size = _str_utils::length(rhs);
             reserve(_new_size);
             _size = _new_size;
-            _str_utils::copy(_data, rhs, _size);
-            _data[_size] = static_cast<CharT>(0);
+            _str_utils::copy(_data(), rhs, _size);
+            _data()[_size] = static_cast<CharT>(0);
             return *this;
         }
 
@@ -204,20 +222,20 @@ namespace hsd
             auto _new_size = rhs.size();
             reserve(_new_size);
             _size = _new_size;
-            copy_n(rhs.data(), _size, _data);
-            _data[_size] = static_cast<CharT>(0);
+            copy_n(rhs.data(), _size, _data());
+            _data()[_size] = static_cast<CharT>(0);
             return *this;
         }
 
         inline basic_string& operator=(const basic_string& rhs)
         {
             _reset();
-            _alloc = rhs._alloc;
+            _alloc() = rhs._alloc();
             _size = rhs._size;
             _capacity = _size;
-            _data = _alloc.allocate(_size + 1).unwrap();
-            copy_n(rhs.c_str(), _size, _data);
-            _data[_size] = static_cast<CharT>(0);
+            _data() = _alloc().allocate(_size + 1).unwrap();
+            copy_n(rhs.c_str(), _size, _data());
+            _data()[_size] = static_cast<CharT>(0);
             return *this;
         }
 
@@ -225,43 +243,43 @@ namespace hsd
         inline basic_string& operator=(const basic_string<CharT2, Allocator>& rhs)
         {
             _reset();
-            _alloc = rhs._alloc;
-            _size = _capacity = unicode::length(rhs._data);
-            _data = _alloc.allocate(_size + 1).unwrap();
+            _alloc() = rhs._alloc();
+            _size = _capacity = unicode::length(rhs._data());
+            _data() = _alloc().allocate(_size + 1).unwrap();
             
             if constexpr (sizeof(CharT) == 1)
             {
-                unicode::to_utf8(_data, rhs._data);
+                unicode::to_utf8(_data(), rhs._data());
             }
             else if constexpr (sizeof(CharT) == 2)
             {
-                unicode::to_utf16(_data, rhs._data);
+                unicode::to_utf16(_data(), rhs._data());
             }
             else if constexpr (sizeof(CharT) == 4)
             {
-                unicode::to_utf32(_data, rhs._data);
+                unicode::to_utf32(_data(), rhs._data());
             }
             else
             {
                 panic("Unsupported character size");
             }
 
-            _data[_size] = static_cast<CharT>(0);
+            _data()[_size] = static_cast<CharT>(0);
             return *this;
         }
 
         inline basic_string& operator=(basic_string&& rhs)
         {
-            swap(_alloc, rhs._alloc);
+            swap(_alloc(), rhs._alloc());
             swap(_size, rhs._size);
             swap(_capacity, rhs._capacity);
-            swap(_data, rhs._data);
+            swap(_data(), rhs._data());
             return *this;
         }
 
         inline basic_string operator+(const basic_string& rhs) const
         {
-            if (rhs.data() == nullptr || _data == nullptr)
+            if (rhs.data() == nullptr || _data() == nullptr)
             {
                 panic("Cannot concatenate null strings");
             }
@@ -269,16 +287,16 @@ namespace hsd
             {
                 basic_string _buf(_size + rhs._size);
                 _buf._size = _size + rhs._size;
-                _str_utils::copy(_buf._data, _data, _size);
-                _str_utils::add(_buf._data, rhs._data, _size);
-                _buf._data[_buf._size] = static_cast<CharT>(0);
+                _str_utils::copy(_buf._data(), _data(), _size);
+                _str_utils::add(_buf._data(), rhs._data(), _size);
+                _buf._data()[_buf._size] = static_cast<CharT>(0);
                 return _buf;
             }
         }
 
         inline basic_string operator+(const basic_string_view<CharT>& rhs) const
         {
-            if (rhs.data() == nullptr || _data == nullptr)
+            if (rhs.data() == nullptr || _data() == nullptr)
             {
                 panic("Cannot concatenate null strings");
             }
@@ -286,16 +304,16 @@ namespace hsd
             {
                 basic_string _buf(_size + rhs.size());
                 _buf._size = _size + rhs.size();
-                _str_utils::copy(_buf._data, _data, _size);
-                _str_utils::add(_buf._data, rhs.data(), _size);
-                _buf._data[_buf._size] = static_cast<CharT>(0);
+                _str_utils::copy(_buf._data(), _data(), _size);
+                _str_utils::add(_buf._data(), rhs.data(), _size);
+                _buf._data()[_buf._size] = static_cast<CharT>(0);
                 return _buf;
             }
         }
 
         inline basic_string operator+(const CharT* rhs) const
         {
-            if (rhs == nullptr || _data == nullptr)
+            if (rhs == nullptr || _data() == nullptr)
             {
                 panic("Cannot concatenate null strings");
             }
@@ -304,9 +322,9 @@ namespace hsd
                 usize _rhs_len = _str_utils::length(rhs);
                 basic_string _buf(_size + _rhs_len);
                 _buf._size = _size + _rhs_len;
-                _str_utils::copy(_buf._data, _data, _size);
-                _str_utils::add(_buf._data, rhs, _size);
-                _buf._data[_buf._size] = static_cast<CharT>(0);
+                _str_utils::copy(_buf._data(), _data(), _size);
+                _str_utils::add(_buf._data(), rhs, _size);
+                _buf._data()[_buf._size] = static_cast<CharT>(0);
                 return _buf;
             }
         }
@@ -314,23 +332,23 @@ namespace hsd
         inline friend basic_string operator+(
             const basic_string_view<CharT>& lhs, const basic_string& rhs)
         {
-            if (lhs.data() == nullptr || rhs._data == nullptr)
+            if (lhs.data() == nullptr || rhs._data() == nullptr)
             {
                 panic("Cannot concatenate null strings");
             }
             else
             {
                 basic_string _buf(rhs._size + lhs._size);
-                _str_utils::copy(_buf._data, lhs.data(), lhs._size);
-                _str_utils::add(_buf._data, rhs._data, lhs._size);
-                _buf._data[_buf._size] = static_cast<CharT>(0);
+                _str_utils::copy(_buf._data(), lhs.data(), lhs._size);
+                _str_utils::add(_buf._data(), rhs._data(), lhs._size);
+                _buf._data()[_buf._size] = static_cast<CharT>(0);
                 return _buf;
             }
         }
 
         inline friend basic_string operator+(const CharT* lhs, const basic_string& rhs)
         {
-            if (lhs == nullptr || rhs._data == nullptr)
+            if (lhs == nullptr || rhs._data() == nullptr)
             {
                 panic("Cannot concatenate null strings");
             }
@@ -338,16 +356,16 @@ namespace hsd
             {
                 usize _lhs_len = _str_utils::length(lhs);
                 basic_string _buf(rhs._size + _lhs_len);
-                _str_utils::copy(_buf._data, lhs, _lhs_len);
-                _str_utils::add(_buf._data, rhs._data, _lhs_len);
-                _buf._data[_buf._size] = static_cast<CharT>(0);
+                _str_utils::copy(_buf._data(), lhs, _lhs_len);
+                _str_utils::add(_buf._data(), rhs._data(), _lhs_len);
+                _buf._data()[_buf._size] = static_cast<CharT>(0);
                 return _buf;
             }
         }
 
         inline basic_string& operator+=(const basic_string& rhs)
         {
-            if (rhs.data() == nullptr || _data == nullptr)
+            if (rhs.data() == nullptr || _data() == nullptr)
             {
                 panic("Cannot concatenate null strings");
             }
@@ -355,24 +373,24 @@ namespace hsd
             {
                 basic_string _buf(_size + rhs._size);
                 _buf._size = _size + rhs._size;
-                _str_utils::copy(_buf._data, _data, _size);
-                _str_utils::add(_buf._data, rhs._data, _size);
-                _buf._data[_buf._size] = static_cast<CharT>(0);
+                _str_utils::copy(_buf._data(), _data(), _size);
+                _str_utils::add(_buf._data(), rhs._data(), _size);
+                _buf._data()[_buf._size] = static_cast<CharT>(0);
                 operator=(hsd::move(_buf));
                 return *this;
             }
             else
             {
-                _str_utils::add(_data, rhs._data, _size);
+                _str_utils::add(_data(), rhs._data(), _size);
                 _size += rhs._size;
-                _data[_size] = static_cast<CharT>(0);
+                _data()[_size] = static_cast<CharT>(0);
                 return *this;
             }
         }
 
         inline basic_string& operator+=(const basic_string_view<CharT>& rhs)
         {
-            if (rhs.data() == nullptr || _data == nullptr)
+            if (rhs.data() == nullptr || _data() == nullptr)
             {
                 panic("Error: nullptr argument.");
             }
@@ -380,24 +398,24 @@ namespace hsd
             {
                 basic_string _buf(_size + rhs.size());
                 _buf._size = _size + rhs.size();
-                _str_utils::copy(_buf._data, _data, _size);
-                _str_utils::add(_buf._data, rhs.data(), _size);
-                _buf._data[_buf._size] = static_cast<CharT>(0);
+                _str_utils::copy(_buf._data(), _data(), _size);
+                _str_utils::add(_buf._data(), rhs.data(), _size);
+                _buf._data()[_buf._size] = static_cast<CharT>(0);
                 operator=(hsd::move(_buf));
                 return *this;
             }
             else
             {
-                _str_utils::add(_data, rhs.data(), _size);
+                _str_utils::add(_data(), rhs.data(), _size);
                 _size += rhs.size();
-                _data[_size] = static_cast<CharT>(0);
+                _data()[_size] = static_cast<CharT>(0);
                 return *this;
             }
         }
 
         inline basic_string& operator+=(const CharT* rhs)
         {
-            if (rhs == nullptr || _data == nullptr)
+            if (rhs == nullptr || _data() == nullptr)
             {
                 panic("Error: nullptr argument.");
             }
@@ -409,16 +427,16 @@ namespace hsd
                 {
                     basic_string _buf(_size + _rhs_len);
                     _buf._size = _size + _rhs_len;
-                    _str_utils::copy(_buf._data, _data, _size);
-                    _str_utils::add(_buf._data, rhs, _size);
-                    _buf._data[_buf._size] = static_cast<CharT>(0);
+                    _str_utils::copy(_buf._data(), _data(), _size);
+                    _str_utils::add(_buf._data(), rhs, _size);
+                    _buf._data()[_buf._size] = static_cast<CharT>(0);
                     operator=(hsd::move(_buf));
                     return *this;
                 }
                 else
                 {
-                    _str_utils::add(_data, rhs, _size);
-                    _data[_size] = static_cast<CharT>(0);
+                    _str_utils::add(_data(), rhs, _size);
+                    _data()[_size] = static_cast<CharT>(0);
                     return *this;
                 }
             }
@@ -426,17 +444,17 @@ namespace hsd
 
         inline CharT& operator[](usize index)
         {
-            return _data[index];
+            return _data()[index];
         }
 
         inline const CharT& operator[](usize index) const
         {
-            return _data[index];
+            return _data()[index];
         }
 
         inline bool operator==(const basic_string& rhs) const
         {
-            return _size == rhs._size && _str_utils::compare(_data, rhs._data) == 0;
+            return _size == rhs._size && _str_utils::compare(_data(), rhs._data()) == 0;
         }
 
         inline bool operator!=(const basic_string& rhs) const
@@ -446,24 +464,24 @@ namespace hsd
 
         inline bool operator<(const basic_string& rhs) const
         {
-            return _str_utils::compare(_data, rhs._data) == -1;
+            return _str_utils::compare(_data(), rhs._data()) == -1;
         }
 
         inline bool operator<=(const basic_string& rhs) const
         {
-            auto _comp_rez = _str_utils::compare(_data, rhs._data);
+            auto _comp_rez = _str_utils::compare(_data(), rhs._data());
 
             return _comp_rez == -1 || _comp_rez == 0;
         }
 
         inline bool operator>(const basic_string& rhs) const
         {
-            return _str_utils::compare(_data, rhs._data) == 1;
+            return _str_utils::compare(_data(), rhs._data()) == 1;
         }
 
         inline bool operator>=(const basic_string& rhs) const
         {
-            auto _comp_rez = _str_utils::compare(_data, rhs._data);
+            auto _comp_rez = _str_utils::compare(_data(), rhs._data());
 
             return _comp_rez == 1 || _comp_rez == 0;
         }
@@ -474,7 +492,7 @@ namespace hsd
             if(index >= _size)
                 return bad_access{};
 
-            return {_data[index]};
+            return {_data()[index]};
         }
 
         inline auto at(usize index) const
@@ -483,7 +501,7 @@ namespace hsd
             if(index >= _size)
                 return bad_access{};
 
-            return {_data[index]};
+            return {_data()[index]};
         }
 
         inline usize find(const basic_string& str, usize pos = 0) const
@@ -495,7 +513,7 @@ namespace hsd
             else
             {
                 const CharT* _find_addr = _str_utils::find(
-                    &_data[pos], str._data
+                    &_data()[pos], str._data()
                 );
 
                 if (_find_addr == nullptr)
@@ -504,7 +522,7 @@ namespace hsd
                 }
                 else
                 {
-                    return static_cast<usize>(_find_addr - _data);
+                    return static_cast<usize>(_find_addr - _data());
                 }
             }
         }
@@ -518,7 +536,7 @@ namespace hsd
             else
             {
                 const CharT* _find_addr = _str_utils::find(
-                    &_data[pos], str
+                    &_data()[pos], str
                 );
 
                 if (_find_addr == nullptr)
@@ -527,7 +545,7 @@ namespace hsd
                 }
                 else
                 {
-                    return static_cast<usize>(_find_addr - _data);
+                    return static_cast<usize>(_find_addr - _data());
                 }
             }
         }
@@ -541,7 +559,7 @@ namespace hsd
             else
             {
                 const CharT* _find_addr = _str_utils::find(
-                    &_data[pos], letter
+                    &_data()[pos], letter
                 );
 
                 if (_find_addr == nullptr)
@@ -550,7 +568,7 @@ namespace hsd
                 }
                 else
                 {
-                    return static_cast<usize>(_find_addr - _data);
+                    return static_cast<usize>(_find_addr - _data());
                 }
             }
         }
@@ -564,7 +582,7 @@ namespace hsd
             else if (pos == npos)
             {
                 const CharT* _find_addr = _str_utils::find_rev(
-                    &_data[pos], str._data, _size
+                    &_data()[pos], str._data(), _size
                 );
 
                 if(_find_addr == nullptr)
@@ -573,13 +591,13 @@ namespace hsd
                 }
                 else
                 {
-                    return static_cast<usize>(_find_addr - _data);
+                    return static_cast<usize>(_find_addr - _data());
                 }
             }
             else
             {
                 const CharT* _find_addr = _str_utils::find_rev(
-                    &_data[pos], str._data, _size - pos
+                    &_data()[pos], str._data(), _size - pos
                 );
 
                 if (_find_addr == nullptr)
@@ -588,7 +606,7 @@ namespace hsd
                 }
                 else
                 {
-                    return static_cast<usize>(_find_addr - _data);
+                    return static_cast<usize>(_find_addr - _data());
                 }
             }
         }
@@ -602,7 +620,7 @@ namespace hsd
             else if (pos == npos)
             {
                 const CharT* _find_addr = _str_utils::find_rev(
-                    &_data[pos], str, _size
+                    &_data()[pos], str, _size
                 );
 
                 if (_find_addr == nullptr)
@@ -611,13 +629,13 @@ namespace hsd
                 }
                 else
                 {
-                    return static_cast<usize>(_find_addr - _data);
+                    return static_cast<usize>(_find_addr - _data());
                 }
             }
             else
             {
                 const CharT* _find_addr = _str_utils::find_rev(
-                    &_data[pos], str, _size - pos
+                    &_data()[pos], str, _size - pos
                 );
 
                 if (_find_addr == nullptr)
@@ -626,7 +644,7 @@ namespace hsd
                 }
                 else
                 {
-                    return static_cast<usize>(_find_addr - _data);
+                    return static_cast<usize>(_find_addr - _data());
                 }
             }
         }
@@ -640,7 +658,7 @@ namespace hsd
             else if (pos == npos)
             {
                 const CharT* _find_addr = _str_utils::find_rev(
-                    &_data[pos], str, _size
+                    &_data()[pos], str, _size
                 );
 
                 if (_find_addr == nullptr)
@@ -649,13 +667,13 @@ namespace hsd
                 }
                 else
                 {
-                    return static_cast<usize>(_find_addr - _data);
+                    return static_cast<usize>(_find_addr - _data());
                 }
             }
             else
             {
                 const CharT* _find_addr = _str_utils::find_rev(
-                    &_data[pos], str, _size - pos
+                    &_data()[pos], str, _size - pos
                 );
 
                 if (_find_addr == nullptr)
@@ -664,22 +682,22 @@ namespace hsd
                 }
                 else
                 {
-                    return static_cast<usize>(_find_addr - _data);
+                    return static_cast<usize>(_find_addr - _data());
                 }
             }
         }
 
         inline bool starts_with(CharT letter) const
         {
-            if (_data != nullptr)
-                return _data[0] == letter;
+            if (_data() != nullptr)
+                return _data()[0] == letter;
 
             return false;
         }
 
         inline bool starts_with(const CharT* str) const
         {
-            if (_data != nullptr)
+            if (_data() != nullptr)
                 return find(str) == 0;
 
             return false;
@@ -687,7 +705,7 @@ namespace hsd
 
         inline bool starts_with(const basic_string& str) const
         {
-            if (_data != nullptr)
+            if (_data() != nullptr)
                 return find(str) == 0;
 
             return false;
@@ -695,7 +713,7 @@ namespace hsd
 
         inline bool contains(CharT letter) const
         {
-            if (_data != nullptr)
+            if (_data() != nullptr)
                 return find(letter) != npos;
 
             return false;
@@ -703,7 +721,7 @@ namespace hsd
 
         inline bool contains(const CharT* str) const
         {
-            if (_data != nullptr)
+            if (_data() != nullptr)
                 return find(str) != npos;
 
             return false;
@@ -711,7 +729,7 @@ namespace hsd
 
         inline bool contains(const basic_string& str) const
         {
-            if (_data != nullptr)
+            if (_data() != nullptr)
                 return find(str) != npos;
 
             return false;
@@ -719,8 +737,8 @@ namespace hsd
 
         inline bool ends_with(CharT letter) const
         {
-            if (_data != nullptr)
-                return _data[_size - 1] == letter;
+            if (_data() != nullptr)
+                return _data()[_size - 1] == letter;
 
             return false;
         }
@@ -729,7 +747,7 @@ namespace hsd
         {
             usize _len = cstring::length(str);
 
-            if (_data != nullptr)
+            if (_data() != nullptr)
                 return rfind(str) == (_size - _len);
 
             return false;
@@ -737,7 +755,7 @@ namespace hsd
 
         inline bool ends_with(const basic_string& str) const
         {
-            if (_data != nullptr)
+            if (_data() != nullptr)
                 return rfind(str) == (_size - str._size);
 
             return false;
@@ -749,7 +767,7 @@ namespace hsd
             if (from > _size || (from + count) > _size)
                 return bad_access{};
 
-            return basic_string{_data + from, count};
+            return basic_string{_data() + from, count};
         }
 
         inline auto sub_string(usize from)
@@ -775,8 +793,8 @@ namespace hsd
 
             for (usize _index = 0; _index < _capacity - _last_pos + 1; _index++)
             {
-                this->_data[_current_pos + _index] = 
-                    move(this->_data[_last_pos + _index]);
+                this->_data()[_current_pos + _index] = 
+                    move(this->_data()[_last_pos + _index]);
             }
 
             _size -= static_cast<usize>(to - from) + 1;
@@ -795,18 +813,18 @@ namespace hsd
 
                 // Allocate space for NULL byte
                 auto* _new_buf = 
-                    _alloc.allocate(_new_capacity + 1).unwrap();
+                    _alloc().allocate(_new_capacity + 1).unwrap();
 
                 _new_buf[_new_capacity] = 0;
                 
                 for (usize _index = 0; _index < _size; ++_index)
                 {
-                    auto& _value = _data[_index];
+                    auto& _value = _data()[_index];
                     _new_buf[_index] = move(_value);
                 }
 
-                _alloc.deallocate(_data, _capacity + 1).unwrap();
-                _data = _new_buf;
+                _alloc().deallocate(_data(), _capacity + 1).unwrap();
+                _data() = _new_buf;
                 _capacity = _new_capacity;
             }
         }
@@ -815,8 +833,8 @@ namespace hsd
         inline void emplace_back(Args&&... args)
         {
             reserve(_size + 2);
-            _data[_size] = CharT{forward<Args>(args)...};
-            _data[++_size] = '\0';
+            _data()[_size] = CharT{forward<Args>(args)...};
+            _data()[++_size] = '\0';
         }
 
         inline void push_back(const CharT& val)
@@ -833,7 +851,7 @@ namespace hsd
         {
             if (_capacity != 0)
             {
-                _data[0] = '\0';
+                _data()[0] = '\0';
                 _size = 0;
             }
         }
@@ -842,23 +860,23 @@ namespace hsd
         {
             if (_size > 0)
             {
-                _data[_size--] = '\0';
+                _data()[_size--] = '\0';
             }
         }
 
         inline CharT& front()
         {
-            return _data[0];
+            return _data()[0];
         }
 
         inline CharT& back()
         {
-            return _data[_size - 1];
+            return _data()[_size - 1];
         }
 
         inline usize size() const
         {
-            return (_data != nullptr) ? _size + 1 : 0;
+            return (_data() != nullptr) ? _size + 1 : 0;
         }
 
         inline usize length() const
@@ -873,17 +891,17 @@ namespace hsd
 
         inline iterator data()
         {
-            return _data;
+            return _data();
         }
 
         inline const_iterator data() const
         {
-            return _data;
+            return _data();
         }
 
         inline const_iterator c_str() const
         {
-            return _data != nullptr ? _data : &_s_empty;
+            return _data() != nullptr ? _data() : &_s_empty;
         }
 
         inline iterator begin()
@@ -918,7 +936,7 @@ namespace hsd
 
         explicit constexpr operator basic_string_view<CharT>() const
         {
-            return basic_string_view<CharT>(_data, _size);
+            return basic_string_view<CharT>(_data(), _size);
         }
 
         template <typename CharU>
@@ -0,0 +1,438 @@
+#pragma once
+
+#include "Future.hpp"
+#include "Thread.hpp"
+#include "Vector.hpp"
+
+namespace hsd
+{
+    namespace pool_detail
+    {
+        struct task_base
+        {
+            virtual void run() = 0;
+            virtual ~task_base() = default;
+        };
+
+        template <typename Func>
+        struct task_impl final : task_base
+        {
+            Func _func;
+
+            template <typename F>
+            inline task_impl(F&& func)
+                : _func{forward<F>(func)}
+            {}
+
+            virtual void run() override
+            {
+                _func();
+            }
+        };
+
+        // Chase-Lev work-stealing deque (Le et al., "Correct and Efficient
+        // Work-Stealing for Weak Memory Models"). The owning worker pushes
+        // and pops at the bottom, every other thread steals from the top
+        template <typename T>
+        class work_deque
+        {
+        private:
+            struct ring
+            {
+                isize capacity;
+                atomic<T>* slots;
+                ring* retired = nullptr;
+
+                inline ring(isize size)
+                    : capacity{size}, slots{new atomic<T>[static_cast<usize>(size)]}
+                {}
+
+                inline ~ring()
+                {
+                    delete[] slots;
+                }
+
+                inline T get(isize index) const
+                {
+                    return slots[index & (capacity - 1)].load(memory_order_relaxed);
+                }
+
+                inline void put(isize index, T value)
+                {
+                    slots[index & (capacity - 1)].store(value, memory_order_relaxed);
+                }
+            };
+
+            alignas(hardware_destructive_interference_size) atomic_isize _top = 0;
+            alignas(hardware_destructive_interference_size) atomic_isize _bottom = 0;
+            alignas(hardware_destructive_interference_size) atomic<ring*> _ring;
+
+            // Thieves may still be reading an old ring after it has been
+            // replaced, so old rings are only freed with the deque itself
+            inline ring* _grow(ring* old, isize top, isize bottom)
+            {
+                auto* _new_ring = new ring{old->capacity * 2};
+
+                for (isize _index = top; _index < bottom; _index++)
+                {
+                    _new_ring->put(_index, old->get(_index));
+                }
+
+                _new_ring->retired = old;
+                _ring.store(_new_ring, memory_order_release);
+                return _new_ring;
+            }
+
+        public:
+            inline work_deque(isize capacity = 256)
+                : _ring{new ring{capacity}}
+            {}
+
+            inline work_deque(const work_deque&) = delete;
+            inline work_deque& operator=(const work_deque&) = delete;
+
+            inline ~work_deque()
+            {
+                auto* _current = _ring.load(memory_order_relaxed);
+
+                while (_current != nullptr)
+                {
+                    auto* _next = _current->retired;
+                    delete _current;
+                    _current = _next;
+                }
+            }
+
+            // Owner only
+            inline void push(T value)
+            {
+                isize _bot = _bottom.load(memory_order_relaxed);
+                isize _tp = _top.load(memory_order_acquire);
+                auto* _current = _ring.load(memory_order_relaxed);
+
+                if (_bot - _tp > _current->capacity - 1)
+                {
+                    _current = _grow(_current, _tp, _bot);
+                }
+
+                _current->put(_bot, value);
+                atomic_thread_fence(memory_order_release);
+                _bottom.store(_bot + 1, memory_order_relaxed);
+            }
+
+            // Owner only
+            inline T pop()
+            {
+                isize _bot = _bottom.load(memory_order_relaxed) - 1;
+                auto* _current = _ring.load(memory_order_relaxed);
+                _bottom.store(_bot, memory_order_relaxed);
+                atomic_thread_fence(memory_order_seq_cst);
+                isize _tp = _top.load(memory_order_relaxed);
+
+                if (_tp > _bot)
+                {
+                    _bottom.store(_bot + 1, memory_order_relaxed);
+                    return nullptr;
+                }
+
+                T _value = _current->get(_bot);
+
+                if (_tp == _bot)
+                {
+                    // Last element, race against the thieves for it
+                    if (!_top.compare_exchange_strong(
+                        _tp, _tp + 1, memory_order_seq_cst, memory_order_relaxed))
+                    {
+                        _value = nullptr;
+                    }
+
+                    _bottom.store(_bot + 1, memory_order_relaxed);
+                }
+
+                return _value;
+            }
+
+            // Any thread
+            inline T steal()
+            {
+                isize _tp = _top.load(memory_order_acquire);
+                atomic_thread_fence(memory_order_seq_cst);
+                isize _bot = _bottom.load(memory_order_acquire);
+
+                if (_tp >= _bot)
+                    return nullptr;
+
+                auto* _current = _ring.load(memory_order_acquire);
+                T _value = _current->get(_tp);
+
+                if (!_top.compare_exchange_strong(
+                    _tp, _tp + 1, memory_order_seq_cst, memory_order_relaxed))
+                {
+                    return nullptr;
+                }
+
+                return _value;
+            }
+
+            inline bool empty() const
+            {
+                return _bottom.load(memory_order_relaxed) <=
+                    _top.load(memory_order_relaxed);
+            }
+        };
+    } // namespace pool_detail
+
+    class thread_pool
+    {
+    private:
+        struct alignas(hardware_destructive_interference_size) worker
+        {
+            pool_detail::work_deque<pool_detail::task_base*> deque;
+            u64 seed;
+        };
+
+        struct worker_context
+        {
+            thread_pool* pool = nullptr;
+            usize index = 0;
+        };
+
+        static constexpr usize _spin_rounds = 64;
+
+        worker* _workers = nullptr;
+        usize _worker_count = 0;
+        hsd::vector<thread> _threads;
+
+        // Tasks submitted from threads that aren't workers of this pool
+        mutex _inject_mutex;
+        hsd::vector<pool_detail::task_base*> _injected;
+        usize _inject_head = 0;
+
+        mutex _sleep_mutex;
+        condition_variable _wake_cond;
+        atomic_usize _pending = 0;
+        atomic_usize _sleeping = 0;
+        atomic_bool _stop = false;
+
+        static inline worker_context& _current()
+        {
+            static thread_local worker_context _context;
+            return _context;
+        }
+
+        static inline u64 _next_random(u64& seed)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            return seed;
+        }
+
+        inline pool_detail::task_base* _pop_injected()
+        {
+            unique_lock<mutex> _lock{_inject_mutex};
+
+            if (_inject_head == _injected.size())
+                return nullptr;
+
+            auto* _task = _injected[_inject_head++];
+
+            if (_inject_head == _injected.size())
+            {
+                _injected.clear();
+                _inject_head = 0;
+            }
+
+            return _task;
+        }
+
+        inline pool_detail::task_base* _find_task(usize index)
+        {
+            auto& _self = _workers[index];
+
+            if (auto* _task = _self.deque.pop(); _task != nullptr)
+                return _task;
+
+            if (auto* _task = _pop_injected(); _task != nullptr)
+                return _task;
+
+            // Random victim first, then everyone else in order
+            usize _victim = static_cast<usize>(
+                _next_random(_self.seed) % _worker_count
+            );
+
+            for (usize _step = 0; _step < _worker_count; _step++)
+            {
+                usize _other = (_victim + _step) % _worker_count;
+
+                if (_other == index)
+                    continue;
+
+                if (auto* _task = _workers[_other].deque.steal(); _task != nullptr)
+                    return _task;
+            }
+
+            return nullptr;
+        }
+
+        inline void _run(pool_detail::task_base* task)
+        {
+            _pending.fetch_sub(1, memory_order_relaxed);
+            task->run();
+            delete task;
+        }
+
+        inline void _worker_loop(usize index)
+        {
+            _current() = {this, index};
+
+            while (true)
+            {
+                if (auto* _task = _find_task(index); _task != nullptr)
+                {
+                    _run(_task);
+                    continue;
+                }
+
+                bool _found = false;
+
+                for (usize _round = 0; _round < _spin_rounds && !_found; _round++)
+                {
+                    this_thread::yield();
+
+                    if (auto* _task = _find_task(index); _task != nullptr)
+                    {
+                        _run(_task);
+                        _found = true;
+                    }
+                }
+
+                if (_found)
+                    continue;
+
+                unique_lock<mutex> _lock{_sleep_mutex};
+                _sleeping.fetch_add(1);
+
+                _wake_cond.wait(_lock, [this] {
+                    return _pending.load() != 0 || _stop.load();
+                });
+
+                _sleeping.fetch_sub(1);
+
+                if (_stop.load() && _pending.load() == 0)
+                    break;
+            }
+
+            _current() = {};
+        }
+
+        inline void _push(pool_detail::task_base* task)
+        {
+            auto& _context = _current();
+
+            if (_context.pool == this)
+            {
+                _workers[_context.index].deque.push(task);
+            }
+            else
+            {
+                unique_lock<mutex> _lock{_inject_mutex};
+                _injected.push_back(task);
+            }
+
+            // Pairs with the sleeper bumping _sleeping before
+            // re-checking _pending, so a wake up can't get lost
+            _pending.fetch_add(1);
+
+            if (_sleeping.load() != 0)
+            {
+                unique_lock<mutex> _lock{_sleep_mutex};
+                _wake_cond.notify_one();
+            }
+        }
+
+    public:
+        inline explicit thread_pool(
+            usize workers = static_cast<usize>(thread::hardware_concurrency()))
+            : _worker_count{workers != 0 ? workers : 1}
+        {
+            _workers = new worker[_worker_count];
+            _threads.reserve(_worker_count);
+
+            for (usize _index = 0; _index < _worker_count; _index++)
+            {
+                _workers[_index].seed = 0x9E3779B97F4A7C15ull * (_index + 1);
+            }
+
+            for (usize _index = 0; _index < _worker_count; _index++)
+            {
+                _threads.emplace_back([this, _index] {
+                    _worker_loop(_index);
+                });
+            }
+        }
+
+        inline thread_pool(const thread_pool&) = delete;
+        inline thread_pool& operator=(const thread_pool&) = delete;
+
+        // Runs every task that was already submitted, then joins
+        inline ~thread_pool()
+        {
+            _stop.store(true);
+
+            {
+                unique_lock<mutex> _lock{_sleep_mutex};
+                _wake_cond.notify_all();
+            }
+
+            for (auto& _thread : _threads)
+            {
+                _thread.join().unwrap();
+            }
+
+            delete[] _workers;
+        }
+
+        inline usize size() const
+        {
+            return _worker_count;
+        }
+
+        // Index of the calling worker, or none
+        // if the caller doesn't belong to this pool
+        inline option<usize> current_worker() const
+        {
+            auto& _context = _current();
+
+            if (_context.pool != this)
+                return {};
+
+            return _context.index;
+        }
+
+        // Fire and forget, nothing is reported back
+        template <typename Func>
+        requires (Invocable<Func>)
+        inline void execute(Func&& func)
+        {
+            _push(new pool_detail::task_impl<decay_t<Func>>{forward<Func>(func)});
+        }
+
+        template <typename Func, typename... Args>
+        requires (Invocable<Func, Args...>)
+        inline auto submit(Func&& func, Args&&... args)
+        {
+            return future_detail::package_call(
+                [this](auto&& task, auto&) { execute(move(task)); },
+                forward<Func>(func), forward<Args>(args)...
+            );
+        }
+
+        // Process-wide pool, used by default for continuations and async
+        static inline thread_pool& global()
+        {
+            static thread_pool _pool;
+            return _pool;
+        }
+    };
+} // namespace hsd
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "Atomic.hpp"
+#include "Vector.hpp"
+#include "Pair.hpp"
+
+namespace hsd
+{
+    template <typename Owner, typename Record>
+    class thread_registry;
+
+    namespace registry_detail
+    {
+        // Who a record belongs to right now
+        static constexpr u32 active = 0;    // a thread uses it
+        static constexpr u32 idle = 1;      // its thread exited, the owner keeps it
+        static constexpr u32 busy = 2;      // a thread exit or the owner is on it
+        static constexpr u32 orphaned = 3;  // the owner is gone, its thread frees it
+
+        // Base of the records kept in a thread_registry (CRTP)
+        template <typename Record>
+        struct record_base
+        {
+            atomic_u32 state = active;
+            Record* next = nullptr;
+        };
+    } // namespace registry_detail
+
+    // Gives every thread that uses the owner a record of its own, found
+    // through a thread local list. When a thread exits, its record goes
+    // through Owner::_thread_exit and is then left for the next thread.
+    // The owner may go away before the threads that used it: close()
+    // frees the idle records and orphans the ones still held by a
+    // thread, which frees them on exit or on its next lookup
+    template <typename Owner, typename Record>
+    class thread_registry
+    {
+    private:
+        using entry_type = pair<Owner*, Record*>;
+
+        atomic<Record*> _records = nullptr;
+
+        // Records of the current thread, handed back when it exits
+        struct local_list
+        {
+            hsd::vector<entry_type> entries;
+
+            inline ~local_list()
+            {
+                for (auto& _entry : entries)
+                {
+                    _detach(_entry);
+                }
+            }
+
+            static inline local_list& get()
+            {
+                static thread_local local_list _list;
+                return _list;
+            }
+        };
+
+        static inline void _detach(entry_type& entry)
+        {
+            auto* _rec = entry.second;
+            u32 _state = registry_detail::active;
+
+            while (!_rec->state.compare_exchange_weak(
+                _state, registry_detail::busy,
+                memory_order_acquire, memory_order_acquire))
+            {
+                if (_state == registry_detail::orphaned)
+                {
+                    delete _rec;
+                    return;
+                }
+
+                // The owner is closing it right now
+                _state = registry_detail::active;
+                cpu_relax();
+            }
+
+            entry.first->_thread_exit(*_rec);
+            _rec->state.store(registry_detail::idle, memory_order_release);
+        }
+
+        // Drops the entries of owners that are gone
+        static inline void _sweep(hsd::vector<entry_type>& entries)
+        {
+            usize _kept = 0;
+
+            for (usize _index = 0; _index < entries.size(); _index++)
+            {
+                auto* _rec = entries[_index].second;
+
+                if (_rec->state.load(memory_order_acquire) == registry_detail::orphaned)
+                {
+                    delete _rec;
+                }
+                else
+                {
+                    entries[_kept++] = entries[_index];
+                }
+            }
+
+            while (entries.size() > _kept)
+            {
+                entries.pop_back();
+            }
+        }
+
+        inline Record* _acquire()
+        {
+            // Reuse a record left behind by a finished thread
+            for (auto* _rec = _records.load(memory_order_acquire);
+                _rec != nullptr; _rec = _rec->next)
+            {
+                u32 _expected = registry_detail::idle;
+
+                if (_rec->state.load(memory_order_relaxed) == registry_detail::idle &&
+                    _rec->state.compare_exchange_strong(
+                        _expected, registry_detail::active,
+                        memory_order_acquire, memory_order_relaxed))
+                {
+                    return _rec;
+                }
+            }
+
+            auto* _rec = new Record{};
+            auto* _head = _records.load(memory_order_relaxed);
+
+            do
+            {
+                _rec->next = _head;
+            } while (!_records.compare_exchange_weak(
+                _head, _rec, memory_order_release, memory_order_relaxed));
+
+            return _rec;
+        }
+
+    public:
+        inline thread_registry() = default;
+        inline thread_registry(const thread_registry&) = delete;
+        inline thread_registry& operator=(const thread_registry&) = delete;
+
+        inline ~thread_registry()
+        {
+            close([](Record&) {});
+        }
+
+        // The calling thread's record, a new owner at the address
+        // of a closed one doesn't get the old one's records
+        inline Record& local(Owner* owner)
+        {
+            auto& _entries = local_list::get().entries;
+
+            for (auto& _entry : _entries)
+            {
+                if (_entry.first == owner && _entry.second->state.load(
+                    memory_order_acquire) != registry_detail::orphaned)
+                {
+                    return *_entry.second;
+                }
+            }
+
+            _sweep(_entries);
+
+            auto* _rec = _acquire();
+            _entries.emplace_back(owner, _rec);
+            return *_rec;
+        }
+
+        // Every record, linked through next
+        inline Record* records() const
+        {
+            return _records.load(memory_order_acquire);
+        }
+
+        // Calls release on every record while nobody else can touch
+        // it, then frees it or leaves it to the thread that holds it.
+        // Only the owner's destructor should call it, once nobody
+        // uses the owner anymore
+        template <typename Func>
+        inline void close(Func&& release)
+        {
+            auto* _rec = _records.exchange(nullptr, memory_order_acquire);
+
+            while (_rec != nullptr)
+            {
+                // An orphaned record may be freed as soon as it's marked
+                auto* _next = _rec->next;
+                u32 _state = _rec->state.load(memory_order_relaxed);
+
+                while (_state == registry_detail::busy || !_rec->state.compare_exchange_weak(
+                    _state, registry_detail::busy, memory_order_acquire, memory_order_relaxed))
+                {
+                    cpu_relax();
+                    _state = _rec->state.load(memory_order_relaxed);
+                }
+
+                release(*_rec);
+
+                if (_state == registry_detail::idle)
+                {
+                    delete _rec;
+                }
+                else
+                {
+                    _rec->state.store(registry_detail::orphaned, memory_order_release);
+                }
+
+                _rec = _next;
+            }
+        }
+    };
+} // namespace hsd
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Allocator.hpp"
+#include "Extra/CompressedPair.hpp"
 
 namespace hsd
 {
@@ -9,6 +10,25 @@ namespace hsd
         template <typename T, typename U>
         concept ConvertibleDerived = Convertible<U, T> || std::is_base_of_v<T, U>;
 
+        // Allocators that take the object back whole instead of
+        // having it destroyed and freed, like the one of object_pool
+        template <typename Alloc>
+        concept Recycling = requires(Alloc alloc, typename Alloc::pointer_type ptr)
+        {
+            alloc.recycle(ptr);
+        };
+
+        // Single objects always have a size of one, no need to store it
+        struct single_size
+        {
+            constexpr single_size(usize) {}
+
+            constexpr operator usize() const
+            {
+                return 1;
+            }
+        };
+
         template < typename T, template <typename> typename Allocator >
         class storage
         {
@@ -16,40 +36,49 @@ namespace hsd
             using alloc_type = Allocator<remove_array_t<T>>;
             using pointer_type = typename alloc_type::pointer_type;
             using value_type = typename alloc_type::value_type;
+            using size_type = conditional_t<is_array<T>::value, usize, single_size>;
 
         private:
-            alloc_type _alloc;
-            pointer_type _data = nullptr;
-            usize _size = 0;
+            // A stateless allocator takes no space next to the pointer,
+            // so unique_ptr<T> is as big as T* and unique_ptr<T[]> adds
+            // only the size
+            compressed_pair<alloc_type, pointer_type> _alloc_data;
+            [[no_unique_address]] size_type _size = 0;
             
             template <typename U, template <typename> typename Alloc>
             friend class storage;
 
+            inline alloc_type& _alloc()
+            {
+                return _alloc_data.first();
+            }
+
         public:
             inline storage()
             requires (DefaultConstructible<alloc_type>) = default;
 
             inline storage(pointer_type ptr, usize size)
             requires (DefaultConstructible<alloc_type>)
-                : _data{ptr}, _size{size}
+                : _alloc_data{alloc_type{}, ptr}, _size{size}
             {}
 
             inline storage(const alloc_type& alloc, usize size)
             requires (CopyConstructible<alloc_type> && DefaultConstructible<value_type>)
-                : _alloc{alloc}, _size{size}
+                : _alloc_data{alloc, nullptr}, _size{size}
             {
-                _data = _alloc.allocate(size).unwrap();
-                _alloc.construct_at(_data);
+                auto* _data = _alloc().allocate(size).unwrap();
 
                 for(usize _index = 0; _index < size; _index++)
                 {
-                    _alloc.construct_at(&_data[_index]);
+                    _alloc().construct_at(&_data[_index]);
                 }
+
+                set_pointer(_data);
             }
 
             inline storage(pointer_type ptr, const alloc_type& alloc, usize size)
             requires (CopyConstructible<alloc_type>)
-                : _alloc{alloc}, _data{ptr}, _size{size}
+                : _alloc_data{alloc, ptr}, _size{size}
             {}
 
             inline storage(const storage&) = delete;
@@ -57,30 +86,52 @@ namespace hsd
             template <typename U = T>
             inline storage(storage<U, Allocator>&& other)
             requires (MoveConstructible<alloc_type>)
-                : _alloc{move(other._alloc)}, 
-                _data{exchange(other._data, nullptr)},
-                _size{exchange(other._size, 0)}
-            {}
+                : _alloc_data{
+                    move(other._alloc()), 
+                    exchange(other._alloc_data.second(), nullptr)
+                }, _size{exchange(other._size, 0u)}
+            {
+                static_assert(
+                    allocator_detail::can_free_as<remove_array_t<U>, remove_array_t<T>>,
+                    "Over-aligned types must keep their alignment"
+                );
+            }
 
             template <typename U = T>
             inline storage(storage<U, Allocator>&& other)
             requires (!MoveConstructible<alloc_type>)
-                : _data{exchange(other._data, nullptr)},
-                _size{exchange(other._size, 0)}
-            {}
+                : _size{exchange(other._size, 0u)}
+            {
+                static_assert(
+                    allocator_detail::can_free_as<remove_array_t<U>, remove_array_t<T>>,
+                    "Over-aligned types must keep their alignment"
+                );
+
+                set_pointer(exchange(other._alloc_data.second(), nullptr));
+            }
 
             template <typename U = T>
             inline storage& operator=(storage<U, Allocator>&& rhs)
             {
-                _alloc = move(rhs._alloc);
-                _data = exchange(rhs._data, nullptr);
-                _size = exchange(rhs._size, 0);
+                static_assert(
+                    allocator_detail::can_free_as<remove_array_t<U>, remove_array_t<T>>,
+                    "Over-aligned types must keep their alignment"
+                );
+
+                _alloc() = move(rhs._alloc());
+                set_pointer(exchange(rhs._alloc_data.second(), nullptr));
+                _size = exchange(rhs._size, 0u);
                 return *this;
             }
 
             inline auto deallocate()
             {
-                return _alloc.deallocate(_data, _size);
+                return _alloc().deallocate(get_pointer(), _size);
+            }
+
+            inline void recycle()
+            {
+                _alloc().recycle(get_pointer());
             }
 
             inline usize get_size() const
@@ -90,12 +141,12 @@ namespace hsd
 
             inline auto* get_pointer() const
             {
-                return _data;
+                return _alloc_data.second();
             }
 
             inline void set_pointer(pointer_type ptr)
             {
-                _data = ptr;
+                _alloc_data.second() = ptr;
             }
 
             inline void set_size(usize size)
@@ -116,22 +167,34 @@ namespace hsd
 
         inline void _delete()
         {
-            if (get() != nullptr)
-            {
-                using value_type = typename unique_detail::storage<T, Allocator>::value_type;
+            using value_type = typename unique_detail::storage<T, Allocator>::value_type;
 
-                if constexpr (is_array<T>::value)
+            if constexpr (unique_detail::Recycling<Allocator<remove_array_t<T>>>)
+            {
+                if (get() != nullptr)
                 {
-                    for (usize i = 0, size = _value.get_size(); i < size; ++i)
-                        get()[size - i].~value_type();
+                    _value.recycle();
                 }
-                else
+            }
+            else
+            {
+                // Arrays of trivial types only have to be freed
+                if (get() != nullptr && !std::is_trivially_destructible_v<value_type>)
                 {
-                    get()->~value_type();
+                    if constexpr (is_array<T>::value)
+                    {
+                        for (usize i = _value.get_size(); i > 0; --i)
+                            get()[i - 1].~value_type();
+                    }
+                    else
+                    {
+                        get()->~value_type();
+                    }
                 }
+                
+                _value.deallocate().unwrap();
             }
-            
-            _value.deallocate().unwrap();
+
             _value.set_pointer(nullptr);
         }
 
@@ -289,6 +352,14 @@ namespace hsd
     {
         Allocator<remove_array_t<T>> _alloc;
         auto* _ptr = _alloc.allocate(size).unwrap();
+
+        // Destroyed one by one later on, so they have to be created
+        if constexpr (!std::is_trivially_default_constructible_v<remove_array_t<T>>)
+        {
+            for (usize _index = 0; _index < size; _index++)
+                _alloc.construct_at(&_ptr[_index]);
+        }
+
         return unique_ptr<T, Allocator>(_ptr, size);
     }
 
@@ -2,6 +2,7 @@
 
 #include "Result.hpp"
 #include "Reference.hpp"
+#include "IntegerSequence.hpp"
 
 namespace hsd
 {
@@ -93,6 +94,10 @@ namespace hsd
 
     namespace variant_detail
     {
+        // Up to this many alternatives (or combinations of them, for
+        // several variants) visit compares indices, past it, it jumps
+        static constexpr usize linear_visit_limit = 8;
+
         template <typename _Ty, usize _Idx>
         struct index_tagged
         {
@@ -124,6 +129,13 @@ namespace hsd
 
             // Empty constructor
             constexpr variant_storage() {}
+
+            constexpr ~variant_storage()
+            requires (
+                std::is_trivially_destructible_v<_Tfirst> &&
+                (std::is_trivially_destructible_v<_Trest> && ...)
+            ) = default;
+
             // TODO: Constexpr
             constexpr ~variant_storage() {}
 
@@ -184,13 +196,24 @@ namespace hsd
                 std::construct_at(&l, index_constant<_Idx>(), forward<_Ty>(value));
             }
 
+            static constexpr bool TriviallyDestructible()
+            {
+                return (
+                    std::is_trivially_destructible_v<_Tfirst> &&
+                    (std::is_trivially_destructible_v<_Trest> && ...)
+                );
+            }
+
             // Destructor
-            static void destroy(Storage& s, usize id)
+            constexpr static void destroy(Storage& s, usize id)
             {
-                visit(s, id, [](auto val) {
-                    using _ValType = remove_cvref_t<decltype(val.val)>;
-                    val.val.~_ValType();
-                });
+                if constexpr (!TriviallyDestructible())
+                {
+                    visit(s, id, [](auto val) {
+                        using _ValType = remove_cvref_t<decltype(val.val)>;
+                        val.val.~_ValType();
+                    });
+                }
             }
 
             template <usize _TheIdx>
@@ -285,20 +308,52 @@ namespace hsd
                 }
             }
 
-            template < typename _Func, usize _Idx = 0 >
-            constexpr static auto visit(Storage& s, usize id, _Func&& func, index_constant<_Idx> = index_constant<_Idx>())
+            template <usize _Idx, typename _Func>
+            constexpr static decltype(auto) visit_at(Storage& s, _Func& func)
             {
-                if (id == 0)
+                auto& _val = get_mut_impl<_Idx>(s);
+                return func(index_tagged<remove_reference_t<decltype(_val)>&, _Idx>{_val});
+            }
+
+            // One entry per alternative, indexed by the stored index
+            template <typename _Func, usize... _Is>
+            static constexpr decltype(&visit_at<0, _Func>) visit_table[] = {
+                &visit_at<_Is, _Func>...
+            };
+
+            template <usize _Idx, typename _Func>
+            constexpr static decltype(auto) visit_linear(Storage& s, usize id, _Func& func)
+            {
+                if constexpr (_Idx == sizeof...(_Trest))
                 {
-                    return forward<_Func>(func)(index_tagged<_Tfirst &, _Idx>{s.value_first});
+                    return visit_at<_Idx>(s, func);
                 }
-                else if constexpr (Storage::RestTraits::NotEmpty())
+                else
+                {
+                    if (id == _Idx)
+                        return visit_at<_Idx>(s, func);
+
+                    return visit_linear<_Idx + 1>(s, id, func);
+                }
+            }
+
+            // Jumps straight to the alternative, no chain of compares.
+            // A few compares still beat the indirect call, so small
+            // variants keep them and get the visitor inlined
+            template <typename _Func>
+            constexpr static decltype(auto) visit(Storage& s, usize id, _Func&& func)
+            {
+                using _FuncType = remove_reference_t<_Func>;
+
+                if constexpr (sizeof...(_Trest) + 1 <= linear_visit_limit)
                 {
-                    return Storage::RestTraits::visit(s.storage_rest, id - 1, forward<_Func>(func), index_constant<_Idx + 1>());
+                    return visit_linear<0>(s, id, func);
                 }
                 else
                 {
-                    return forward<_Func>(func)(index_tagged<_Tfirst&, _Idx>{s.value_first});
+                    return [&]<usize... _Is>(index_sequence<_Is...>) -> decltype(auto) {
+                        return visit_table<_FuncType, _Is...>[id](s, func);
+                    }(make_index_sequence<sizeof...(_Trest) + 1>{});
                 }
             }
         };
@@ -437,6 +492,11 @@ namespace hsd
         } // namespace bases
     } // namespace variant_detail
 
+    namespace variant_detail
+    {
+        struct variant_access;
+    } // namespace variant_detail
+
     template <typename _Tfirst, typename... _Trest>
     class variant<_Tfirst, _Trest...>
         : private variant_detail::bases::ascp_for<_Tfirst, _Trest...>
@@ -444,8 +504,10 @@ namespace hsd
         using _Base = variant_detail::bases::ascp_for<_Tfirst, _Trest...>;
         using _StorageTraits = typename _Base::_StorageTraits;
 
+        friend struct variant_detail::variant_access;
+
         template <typename _Func>
-        constexpr auto _visit(_Func&& func)
+        constexpr decltype(auto) _visit(_Func&& func)
         {
             return _StorageTraits::visit(this->_storage(), this->_StoredIndex, forward<_Func>(func));
         }
@@ -483,6 +545,11 @@ namespace hsd
                 forward<remove_reference_t<decltype(val)>>(val)) 
         {}
 
+        // With only trivially destructible alternatives there's nothing
+        // to dispatch on, and trivially copyable ones make the whole
+        // variant trivially copyable, copies are a plain memcpy
+        ~variant() requires (_StorageTraits::TriviallyDestructible()) = default;
+
         ~variant()
         {
             _destroy();
@@ -599,12 +666,20 @@ namespace hsd
 
         //// function template visit
         template <typename _Visitor>
-        constexpr auto visit(_Visitor&& vis)
+        constexpr decltype(auto) visit(_Visitor&& vis)
         {
-            return _visit([&](auto val) {
+            return _visit([&](auto val) -> decltype(auto) {
                 return forward<_Visitor>(vis)(val.val);
             });
         }
+
+        template <typename _Visitor>
+        constexpr decltype(auto) visit(_Visitor&& vis) const
+        {
+            return const_cast<variant*>(this)->_visit([&](auto val) -> decltype(auto) {
+                return forward<_Visitor>(vis)(static_cast<const decltype(val.val)&>(val.val));
+            });
+        }
     };
 
     // class template variant_size
@@ -704,4 +779,109 @@ namespace hsd
         return v.template holds_alternative<_Ty>();
     }
 
+    namespace variant_detail
+    {
+        // Unchecked access for visit, the index was already dispatched on
+        struct variant_access
+        {
+            template < usize _Idx, typename... _Ts >
+            static constexpr auto& get(variant<_Ts...>& v)
+            {
+                return variant<_Ts...>::_StorageTraits::template get_mut_impl<_Idx>(v._storage());
+            }
+
+            template < usize _Idx, typename... _Ts >
+            static constexpr auto& get(variant<_Ts...> const& v)
+            {
+                return variant<_Ts...>::_StorageTraits::template get_impl<_Idx>(v._storage());
+            }
+        };
+
+        // The alternatives of all the variants flattened into one
+        // index, row-major, every combination gets its own table entry
+        template < typename _Visitor, typename... _Vars >
+        struct multi_visit
+        {
+            static constexpr usize sizes[] = {
+                variant_size<remove_cv_t<_Vars>>::value...
+            };
+
+            template <usize _Flat, usize _Pos>
+            static consteval usize index_of()
+            {
+                usize _stride = 1;
+
+                for (usize _next = _Pos + 1; _next < sizeof...(_Vars); _next++)
+                    _stride *= sizes[_next];
+
+                return (_Flat / _stride) % sizes[_Pos];
+            }
+
+            template <usize _Flat, usize... _Pos>
+            static constexpr decltype(auto) call(
+                index_sequence<_Pos...>, _Visitor& vis, _Vars&... vars)
+            {
+                return vis(variant_access::get<index_of<_Flat, _Pos>()>(vars)...);
+            }
+
+            template <usize _Flat>
+            static constexpr decltype(auto) entry(_Visitor& vis, _Vars&... vars)
+            {
+                return call<_Flat>(index_sequence_for<_Vars...>{}, vis, vars...);
+            }
+
+            template <usize... _Flat>
+            static constexpr decltype(&entry<0>) table[] = {&entry<_Flat>...};
+
+            static constexpr usize combinations = (
+                variant_size<remove_cv_t<_Vars>>::value * ...
+            );
+
+            template <usize _Flat>
+            static constexpr decltype(auto) linear(usize flat, _Visitor& vis, _Vars&... vars)
+            {
+                if constexpr (_Flat + 1 == combinations)
+                {
+                    return entry<_Flat>(vis, vars...);
+                }
+                else
+                {
+                    if (flat == _Flat)
+                        return entry<_Flat>(vis, vars...);
+
+                    return linear<_Flat + 1>(flat, vis, vars...);
+                }
+            }
+
+            static constexpr decltype(auto) dispatch(_Visitor& vis, _Vars&... vars)
+            {
+                usize _flat = 0;
+                ((_flat = _flat * variant_size<remove_cv_t<_Vars>>::value + vars.index()), ...);
+
+                if constexpr (combinations <= linear_visit_limit)
+                {
+                    return linear<0>(_flat, vis, vars...);
+                }
+                else
+                {
+                    return [&]<usize... _Flat>(index_sequence<_Flat...>) -> decltype(auto) {
+                        return table<_Flat...>[_flat](vis, vars...);
+                    }(make_index_sequence<combinations>{});
+                }
+            }
+        };
+    } // namespace variant_detail
+
+    // function template visit, calls vis with the active alternative
+    // of every variant through a single table lookup. All combinations
+    // have to return the same type
+    template < typename _Visitor, typename... _Variants >
+    requires (sizeof...(_Variants) != 0)
+    constexpr decltype(auto) visit(_Visitor&& vis, _Variants&&... vars)
+    {
+        return variant_detail::multi_visit<
+            remove_reference_t<_Visitor>, remove_reference_t<_Variants>...
+        >::dispatch(vis, vars...);
+    }
+
 } // end namespace hsd
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Allocator.hpp"
+#include "Extra/CompressedPair.hpp"
 #include "Span.hpp"
 #include "Reference.hpp"
 
@@ -11,10 +12,31 @@ namespace hsd
     {
     private:
         using alloc_type = Allocator<T>;
-        alloc_type _alloc;
-        T* _data = nullptr;
+
+        // A stateless allocator takes no space next to the pointer
+        compressed_pair<alloc_type, T*> _alloc_data;
         usize _capacity = 0;
 
+        inline alloc_type& _alloc()
+        {
+            return _alloc_data.first();
+        }
+
+        inline const alloc_type& _alloc() const
+        {
+            return _alloc_data.first();
+        }
+
+        inline T*& _data()
+        {
+            return _alloc_data.second();
+        }
+
+        inline T* _data() const
+        {
+            return _alloc_data.second();
+        }
+
     protected:
         usize _size = 0;
 
@@ -36,7 +58,7 @@ namespace hsd
             for (usize _index = _size; _index > 0; --_index)
                 at_unchecked(_index - 1).~T();
                 
-            _alloc.deallocate(_data, _capacity).unwrap();
+            _alloc().deallocate(_data(), _capacity).unwrap();
         }
 
         inline vector() 
@@ -44,7 +66,6 @@ namespace hsd
 
         inline vector(usize size)
         requires (DefaultConstructible<alloc_type>)
-            : _alloc{}
         {
             resize(size);
         }
@@ -52,70 +73,72 @@ namespace hsd
         template <typename Alloc = alloc_type>
         inline vector(const Alloc& alloc)
         requires (Constructible<alloc_type, Alloc>)
-            : _alloc{alloc}
+            : _alloc_data{alloc_type{alloc}, nullptr}
         {}
 
         template <typename Alloc = alloc_type>
         inline vector(usize size, const Alloc& alloc)
         requires (Constructible<alloc_type, Alloc>)
-            : _alloc{alloc}
+            : _alloc_data{alloc_type{alloc}, nullptr}
         {
             resize(size);
         }
 
         inline vector(const vector& other)
         requires (CopyConstructible<alloc_type>)
-            : _alloc{other._alloc}, _capacity{other._capacity}, _size{other._size}
+            : _alloc_data{other._alloc_data.first(), nullptr},
+            _capacity{other._capacity}, _size{other._size}
         {
-            _data = _alloc.allocate(other._capacity).unwrap();
+            _data() = _alloc().allocate(other._capacity).unwrap();
 
             for (usize _index = 0; _index < _size; ++_index)
-                _alloc.construct_at(&_data[_index], other[_index]);
+                _alloc().construct_at(&_data()[_index], other[_index]);
         }
 
         inline vector(const vector& other)
         requires (!CopyConstructible<alloc_type>)
             : _size{other._size}, _capacity{other._capacity}
         {
-            _data = _alloc.allocate(other._capacity).unwrap();
+            _data() = _alloc().allocate(other._capacity).unwrap();
 
             for (usize _index = 0; _index < _size; ++_index)
-                _alloc.construct_at(&_data[_index], other[_index]);
+                _alloc().construct_at(&_data()[_index], other[_index]);
         }
 
         inline vector(vector&& other)
         requires (MoveConstructible<alloc_type>)
-            : _alloc{move(other._alloc)},
-            _data{exchange(other._data, nullptr)},
-            _capacity{exchange(other._capacity, 0)},
+            : _alloc_data{
+                move(other._alloc()), exchange(other._data(), nullptr)
+            }, _capacity{exchange(other._capacity, 0)},
             _size{exchange(other._size, 0)}
         {}
 
         inline vector(vector&& other)
         requires (!MoveConstructible<alloc_type>)
-            : _data{exchange(other._data, nullptr)},
-            _capacity{exchange(other._capacity, 0)},
+            : _capacity{exchange(other._capacity, 0)},
             _size{exchange(other._size, 0)}
-        {}
+        {
+            _data() = exchange(other._data(), nullptr);
+        }
 
         template <usize N>
         inline vector(const T (&arr)[N])
             : _capacity{N}, _size{N}
         {
-            _data = _alloc.allocate(N).unwrap();
+            _data() = _alloc().allocate(N).unwrap();
 
             for (usize _index = 0; _index < _size; ++_index)
-                _alloc.construct_at(&_data[_index], arr[_index]);
+                _alloc().construct_at(&_data()[_index], arr[_index]);
         }
 
         template <usize N>
         inline vector(T (&&arr)[N])
             : _capacity{N}, _size{N}
         {
-            _data = _alloc.allocate(N).unwrap();
+            _data() = _alloc().allocate(N).unwrap();
 
             for (usize _index = 0; _index < _size; ++_index)
-                _alloc.construct_at(&_data[_index], move(arr[_index]));
+                _alloc().construct_at(&_data()[_index], move(arr[_index]));
         }
 
         inline vector& operator=(const vector& rhs)
@@ -126,7 +149,7 @@ namespace hsd
                 reserve(rhs._size);
                 
                 for (usize _index = 0; _index < rhs._size; ++_index)
-                    _alloc.construct_at(&_data[_index], rhs[_index]);
+                    _alloc().construct_at(&_data()[_index], rhs[_index]);
                 
                 _size = rhs._size;
             }
@@ -136,7 +159,7 @@ namespace hsd
                 usize _min_size = _size < rhs._size ? _size : rhs._size;
                 
                 for (_index = 0; _index < _min_size; ++_index)
-                    _data[_index] = rhs[_index];
+                    _data()[_index] = rhs[_index];
                 
                 if (_size > rhs._size)
                 {
@@ -146,7 +169,7 @@ namespace hsd
                 else if (rhs._size > _size)
                 {
                     for (; _index < rhs._size; ++_index)
-                        _alloc.construct_at(&_data[_index], rhs[_index]);
+                        _alloc().construct_at(&_data()[_index], rhs[_index]);
                 }
 
                 _size = rhs._size;
@@ -159,8 +182,8 @@ namespace hsd
         {
             clear();
             
-            _alloc.deallocate(_data, _capacity).unwrap();
-            _data = exchange(rhs._data, nullptr);            
+            _alloc().deallocate(_data(), _capacity).unwrap();
+            _data() = exchange(rhs._data(), nullptr);            
             _size = exchange(rhs._size, 0u);
             _capacity = exchange(rhs._capacity, 0u);
     
@@ -176,7 +199,7 @@ namespace hsd
                 reserve(N);
                 
                 for (usize _index = 0; _index < N; ++_index)
-                    _alloc.construct_at(&_data[_index], arr[_index]);
+                    _alloc().construct_at(&_data()[_index], arr[_index]);
                 
                 _size = N;
             }
@@ -187,7 +210,7 @@ namespace hsd
                 
                 for (_index = 0; _index < min_size; ++_index)
                 {
-                    _data[_index] = arr[_index];
+                    _data()[_index] = arr[_index];
                 }
                 if (_size > N)
                 {
@@ -197,7 +220,7 @@ namespace hsd
                 else if (N > _size)
                 {
                     for (; _index < N; ++_index)
-                        _alloc.construct_at(&_data[_index], arr[_index]);
+                        _alloc().construct_at(&_data()[_index], arr[_index]);
                 }
                 
                 _size = N;
@@ -215,7 +238,7 @@ namespace hsd
                 reserve(N);
                 
                 for (usize _index = 0; _index < N; ++_index)
-                    _alloc.construct_at(&_data[_index], move(arr[_index]));
+                    _alloc().construct_at(&_data()[_index], move(arr[_index]));
                 
                 _size = N;
             }
@@ -226,7 +249,7 @@ namespace hsd
                 
                 for (_index = 0; _index < min_size; ++_index)
                 {
-                    _data[_index] = move(arr[_index]);
+                    _data()[_index] = move(arr[_index]);
                 }
                 if (_size > N)
                 {
@@ -236,7 +259,7 @@ namespace hsd
                 else if (N > _size)
                 {
                     for (; _index < N; ++_index)
-                        _alloc.construct_at(&_data[_index], move(arr[_index]));
+                        _alloc().construct_at(&_data()[_index], move(arr[_index]));
                 }
 
                 _size = N;
@@ -303,8 +326,8 @@ namespace hsd
 
                 for (usize _index = 0; _index < _capacity - _last_pos; _index++)
                 {
-                    _data[_current_pos + _index] = 
-                        move(_data[_last_pos + _index]);
+                    _data()[_current_pos + _index] = 
+                        move(_data()[_last_pos + _index]);
                 }
 
                 return begin() + _current_pos;
@@ -317,7 +340,7 @@ namespace hsd
             if (index >= _size)
                 return bad_access{};
 
-            return {_data[index]};
+            return {_data()[index]};
         }
 
         inline auto at(usize index) const
@@ -326,17 +349,17 @@ namespace hsd
             if (index >= _size)
                 return bad_access{};
 
-            return {_data[index]};
+            return {_data()[index]};
         }
 
         inline auto& at_unchecked(usize index)
         {
-            return _data[index];
+            return _data()[index];
         }
 
         inline const auto& at_unchecked(usize index) const
         {
-            return _data[index];
+            return _data()[index];
         }
 
         inline void clear()
@@ -357,17 +380,17 @@ namespace hsd
                 while (_new_capacity < new_cap)
                     _new_capacity += (_new_capacity + 1) / 2;
 
-                T* _new_buf = _alloc.allocate(_new_capacity).unwrap();
+                T* _new_buf = _alloc().allocate(_new_capacity).unwrap();
 
                 for (usize _index = 0; _index < _size; ++_index)
                 {
                     auto& _value = at_unchecked(_index);
-                    _alloc.construct_at(&_new_buf[_index], move(_value));
+                    _alloc().construct_at(&_new_buf[_index], move(_value));
                     _value.~T();
                 }
 
-                _alloc.deallocate(_data, _capacity).unwrap();
-                _data = _new_buf;
+                _alloc().deallocate(_data(), _capacity).unwrap();
+                _data() = _new_buf;
                 
                 _capacity = _new_capacity;
             }
@@ -377,17 +400,17 @@ namespace hsd
         {
             if (_size == 0)
             {
-                T* _old_buf = exchange(_data, nullptr);
+                T* _old_buf = exchange(_data(), nullptr);
                 deallocate(_old_buf, _capacity).unwrap();
                 _capacity = 0;
             }
             else if (_size < _capacity)
             {
-                T* _new_buf = _alloc.allocate(_size).unwrap();
-                move<T>(_data, _data + _size, _new_buf);
-                deallocate(_data, _capacity).unwrap();
+                T* _new_buf = _alloc().allocate(_size).unwrap();
+                move<T>(_data(), _data() + _size, _new_buf);
+                deallocate(_data(), _capacity).unwrap();
                 _capacity = _size;
-                _data = _new_buf;
+                _data() = _new_buf;
             }
         }
 
@@ -401,29 +424,29 @@ namespace hsd
                 while (_new_capacity < new_size)
                     _new_capacity += (_new_capacity + 1) / 2;
 
-                T* _new_buf = _alloc.allocate(_new_capacity).unwrap();
+                T* _new_buf = _alloc().allocate(_new_capacity).unwrap();
                 usize _index = 0;
 
                 for (; _index < _size; ++_index)
                 {
                     auto& _value = at_unchecked(_index);
-                    _alloc.construct_at(&_new_buf[_index], move(_value));
+                    _alloc().construct_at(&_new_buf[_index], move(_value));
                     _value.~T();
                 }
                 for (; _index < new_size; ++_index)
                 {
                     if constexpr(Constructible<T, alloc_type> && !DefaultConstructible<T>)
                     {
-                        _alloc.construct_at(&_new_buf[_index], _alloc);
+                        _alloc().construct_at(&_new_buf[_index], _alloc());
                     }
                     else
                     {
-                        _alloc.construct_at(&_new_buf[_index]);
+                        _alloc().construct_at(&_new_buf[_index]);
                     }
                 }
 
-                _alloc.deallocate(_data, _capacity).unwrap();
-                _data = _new_buf;
+                _alloc().deallocate(_data(), _capacity).unwrap();
+                _data() = _new_buf;
                 _capacity = _new_capacity;
                 _size = new_size;
             }
@@ -433,11 +456,11 @@ namespace hsd
                 {
                     if constexpr(CopyConstructible<alloc_type> && !DefaultConstructible<T>)
                     {
-                        _alloc.construct_at(&_data[_index], _alloc);
+                        _alloc().construct_at(&_data()[_index], _alloc());
                     }
                     else
                     {
-                        _alloc.construct_at(&_data[_index]);
+                        _alloc().construct_at(&_data()[_index]);
                     }
                 }
                 
@@ -466,7 +489,7 @@ namespace hsd
         inline void emplace_back(Args&&... args)
         {
             reserve(_size + 1);
-            _alloc.construct_at(&_data[_size], forward<Args>(args)...);
+            _alloc().construct_at(&_data()[_size], forward<Args>(args)...);
             ++_size;
         }
 
@@ -501,7 +524,7 @@ namespace hsd
 
         inline iterator data()
         {
-            return _data;
+            return _data();
         }
 
         inline iterator begin()
@@ -526,7 +549,7 @@ namespace hsd
 
         inline const_iterator cbegin() const
         {
-            return _data;
+            return _data();
         }
 
         inline const_iterator cend() const
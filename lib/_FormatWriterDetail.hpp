@@ -0,0 +1,515 @@
+#pragma once
+
+#include "FormatGenerator.hpp"
+
+#include <stdio.h>
+
+namespace hsd
+{
+    namespace format_detail
+    {
+        ///
+        /// @brief Output cursor with `snprintf` semantics: it writes as much
+        /// as fits into the destination and keeps counting past the end.
+        ///
+        /// @tparam CharT - The character type (char or wchar).
+        ///
+        template <typename CharT>
+        class writer
+        {
+        protected:
+            CharT* _dest;
+            usize _space;
+            usize _length = 0;
+
+        public:
+            using char_type = CharT;
+
+            inline writer(CharT* dest, usize space)
+                : _dest{dest}, _space{space}
+            {}
+
+            inline usize length() const
+            {
+                return _length;
+            }
+
+            inline void put(CharT letter)
+            {
+                if (_length < _space)
+                {
+                    _dest[_length] = letter;
+                }
+
+                ++_length;
+            }
+
+            template <typename CharU>
+            inline void put(const CharU* str, usize size)
+            {
+                usize _index = 0;
+
+                for (; _index < size && _length + _index < _space; ++_index)
+                {
+                    _dest[_length + _index] = static_cast<CharT>(str[_index]);
+                }
+
+                _length += size;
+            }
+
+            ///
+            /// @brief Terminates the output with a null character (if
+            /// there is room for it) and returns the needed length.
+            ///
+            /// @return The length of the whole output, without the null character.
+            ///
+            inline usize finish()
+            {
+                if (_length < _space)
+                {
+                    _dest[_length] = '\0';
+                }
+                else if (_space != 0)
+                {
+                    _dest[_space - 1] = '\0';
+                }
+
+                return _length;
+            }
+        };
+
+        template <typename Writer>
+        static inline void write_unsigned(Writer& out, u64 value)
+        {
+            char _buf[20];
+            usize _index = sizeof(_buf);
+
+            do
+            {
+                _buf[--_index] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value != 0);
+
+            out.put(_buf + _index, sizeof(_buf) - _index);
+        }
+
+        template <typename Writer>
+        static inline void write_signed(Writer& out, i64 value)
+        {
+            if (value < 0)
+            {
+                out.put('-');
+                write_unsigned(out, 0u - static_cast<u64>(value));
+            }
+            else
+            {
+                write_unsigned(out, static_cast<u64>(value));
+            }
+        }
+
+        template <typename Writer>
+        static inline void write_hex(Writer& out, u64 value)
+        {
+            constexpr char _digits[] = "0123456789abcdef";
+            char _buf[16];
+            usize _index = sizeof(_buf);
+
+            do
+            {
+                _buf[--_index] = _digits[value & 0xf];
+                value >>= 4;
+            } while (value != 0);
+
+            out.put(_buf + _index, sizeof(_buf) - _index);
+        }
+
+        ///
+        /// @brief Slow path for the values which don't have a native writer
+        /// (exponent notation, extended precision, infinities and NaNs).
+        ///
+        template <typename Writer, typename T>
+        static inline void write_printf(Writer& out, const char* spec, T value)
+        {
+            char _buf[64];
+            i32 _len = snprintf(_buf, sizeof(_buf), spec, value);
+
+            if (_len < 0)
+            {
+                return;
+            }
+            else if (static_cast<usize>(_len) < sizeof(_buf))
+            {
+                out.put(_buf, static_cast<usize>(_len));
+            }
+            else
+            {
+                char* _big_buf = mallocator::allocate_multiple<char>(
+                    static_cast<usize>(_len) + 1
+                ).unwrap();
+
+                snprintf(_big_buf, static_cast<usize>(_len) + 1, spec, value);
+                out.put(_big_buf, static_cast<usize>(_len));
+                mallocator::deallocate(_big_buf);
+            }
+        }
+
+        ///
+        /// @brief Writes a double the way `%f` does. The fraction is
+        /// computed exactly from the binary representation, so the
+        /// rounding matches the C library (round half to even).
+        ///
+        template <typename Writer>
+        static inline void write_fixed(Writer& out, f64 value)
+        {
+            u64 _bits = bit_cast<u64>(value);
+            u64 _exp_bits = (_bits >> 52) & 0x7ff;
+            u64 _mantissa = _bits & ((1ull << 52) - 1);
+
+            // Infinities, NaNs and values not fitting in 63 bits
+            if (_exp_bits == 0x7ff || _exp_bits > 1075 + 10)
+            {
+                write_printf(out, "%f", value);
+                return;
+            }
+
+            i32 _exp = (_exp_bits == 0) ? -1074 : static_cast<i32>(_exp_bits) - 1075;
+            _mantissa |= (_exp_bits == 0) ? 0 : (1ull << 52);
+
+            u64 _integral = 0;
+            u64 _fraction = 0;
+
+            if (_exp >= 0)
+            {
+                _integral = _mantissa << _exp;
+            }
+            else
+            {
+                u32 _shift = static_cast<u32>(-_exp);
+                u64 _frac_bits = _mantissa;
+
+                if (_shift < 64)
+                {
+                    _integral = _mantissa >> _shift;
+                    _frac_bits = _mantissa & ((1ull << _shift) - 1);
+                }
+
+                // Below 2^-75 * 2^53 * 10^6 the fraction always rounds to zero
+                if (_shift < 75)
+                {
+                    u128 _scaled = static_cast<u128>(_frac_bits) * 1'000'000u;
+                    u128 _digits = _scaled >> _shift;
+                    u128 _rest = _scaled - (_digits << _shift);
+                    u128 _half = static_cast<u128>(1) << (_shift - 1);
+
+                    if (_rest > _half || (_rest == _half && (_digits & 1) != 0))
+                    {
+                        ++_digits;
+                    }
+                    if (_digits == 1'000'000u)
+                    {
+                        ++_integral;
+                        _digits = 0;
+                    }
+
+                    _fraction = static_cast<u64>(_digits);
+                }
+            }
+
+            if ((_bits >> 63) != 0)
+            {
+                out.put('-');
+            }
+
+            write_unsigned(out, _integral);
+            out.put('.');
+
+            char _buf[6];
+
+            for (usize _index = 6; _index != 0; --_index)
+            {
+                _buf[_index - 1] = static_cast<char>('0' + _fraction % 10);
+                _fraction /= 10;
+            }
+
+            out.put(_buf, 6);
+        }
+
+        ///
+        /// @brief Writes a double the way `%a` does (glibc style).
+        ///
+        template <typename Writer>
+        static inline void write_hex_float(Writer& out, f64 value)
+        {
+            u64 _bits = bit_cast<u64>(value);
+            u64 _exp_bits = (_bits >> 52) & 0x7ff;
+            u64 _mantissa = _bits & ((1ull << 52) - 1);
+
+            if (_exp_bits == 0x7ff)
+            {
+                write_printf(out, "%a", value);
+                return;
+            }
+            if ((_bits >> 63) != 0)
+            {
+                out.put('-');
+            }
+            if (_exp_bits == 0 && _mantissa == 0)
+            {
+                out.put("0x0p+0", 6);
+                return;
+            }
+
+            i64 _exp = (_exp_bits == 0) ? -1022 : static_cast<i64>(_exp_bits) - 1023;
+            out.put((_exp_bits == 0) ? "0x0" : "0x1", 3);
+
+            if (_mantissa != 0)
+            {
+                constexpr char _digits[] = "0123456789abcdef";
+                usize _count = 13;
+
+                for (; (_mantissa & 0xf) == 0; _mantissa >>= 4)
+                {
+                    --_count;
+                }
+
+                out.put('.');
+
+                for (usize _index = _count; _index != 0; --_index)
+                {
+                    out.put(_digits[(_mantissa >> ((_index - 1) * 4)) & 0xf]);
+                }
+            }
+
+            out.put('p');
+            out.put(_exp < 0 ? '-' : '+');
+            write_signed(out, _exp < 0 ? -_exp : _exp);
+        }
+
+        ///
+        /// @brief Writes a string which the writer may reference in place
+        /// instead of copying it, if it supports external segments.
+        ///
+        template <typename Writer, typename CharU>
+        static inline void write_str(Writer& out, const CharU* str, usize size)
+        {
+            if constexpr (requires {out.put_external(str, size);})
+            {
+                out.put_external(str, size);
+            }
+            else
+            {
+                out.put(str, size);
+            }
+        }
+
+        template <typename Writer, typename CharU>
+        static inline void write_cstr(Writer& out, const CharU* str)
+        {
+            if (str == nullptr)
+            {
+                out.put("(null)", 6);
+                return;
+            }
+
+            write_str(out, str, basic_cstring<CharU>::length(str));
+        }
+
+        template <typename T>
+        static constexpr bool is_integer = 
+            formatter_traits::is_i8<T> || formatter_traits::is_u8<T> ||
+            formatter_traits::is_i16<T> || formatter_traits::is_u16<T> ||
+            formatter_traits::is_i32<T> || formatter_traits::is_u32<T> ||
+            formatter_traits::is_i64<T> || formatter_traits::is_u64<T> ||
+            formatter_traits::is_ilong<T> || formatter_traits::is_ulong<T>;
+
+        template <typename CharT, fmt_common<CharT> info, typename T, typename Writer>
+        static inline void write_value(Writer& out, const auto& value)
+        {
+            // Same rules (and diagnostics) as the printf back-end
+            [[maybe_unused]] constexpr auto _check =
+                get_value_format_string<CharT, info, T>();
+
+            if constexpr (formatter_traits::is_char<T>)
+            {
+                out.put(static_cast<CharT>(value));
+            }
+            else if constexpr (is_integer<T>)
+            {
+                if constexpr (info.tag & info.hex)
+                {
+                    constexpr u64 _mask = (sizeof(T) == sizeof(u64)) ?
+                        ~0ull : ((1ull << (sizeof(T) * 8)) - 1);
+
+                    out.put("0x", 2);
+                    write_hex(out, static_cast<u64>(value) & _mask);
+                }
+                else if constexpr (static_cast<T>(-1) < static_cast<T>(0))
+                {
+                    write_signed(out, static_cast<i64>(value));
+                }
+                else
+                {
+                    write_unsigned(out, static_cast<u64>(value));
+                }
+            }
+            else if constexpr (formatter_traits::is_f128<T>)
+            {
+                if constexpr (info.tag & info.exp)
+                {
+                    write_printf(out, "%Le", value);
+                }
+                else if constexpr (info.tag & info.hex)
+                {
+                    write_printf(out, "%La", value);
+                }
+                else
+                {
+                    write_printf(out, "%Lf", value);
+                }
+            }
+            else if constexpr (IsFloat<T>)
+            {
+                if constexpr (info.tag & info.exp)
+                {
+                    write_printf(out, "%e", static_cast<f64>(value));
+                }
+                else if constexpr (info.tag & info.hex)
+                {
+                    write_hex_float(out, static_cast<f64>(value));
+                }
+                else
+                {
+                    write_fixed(out, static_cast<f64>(value));
+                }
+            }
+            else if constexpr (formatter_traits::is_char_ptr<T>)
+            {
+                write_cstr(out, static_cast<const char*>(value));
+            }
+            else if constexpr (formatter_traits::is_wchar_ptr<T>)
+            {
+                write_cstr(out, static_cast<const wchar*>(value));
+            }
+            else
+            {
+                // tuple<usize, const char*> or tuple<usize, const wchar*>,
+                // like "%.*s" it stops early at a null character
+                const auto* _str = value.template get<1>();
+                usize _len = 0;
+
+                while (_len < value.template get<0>() && _str[_len] != '\0')
+                {
+                    ++_len;
+                }
+
+                write_str(out, _str, _len);
+            }
+        }
+
+        template <basic_string_literal fmt, typename Writer, typename... Args>
+        static inline void write_format(Writer& out, const Args&... args);
+
+        template <typename CharT, fmt_common<CharT> info, typename Writer, typename T>
+        static inline void write_argument(
+            Writer& out, const CharT* text, usize length, const T& arg)
+        {
+            out.put(text, length);
+
+            if constexpr (info.tag & info.ovr)
+            {
+                static_assert(
+                    !(info.tag & info.style),
+                    "Format literal cannot have both"
+                    " ovr and style tags"
+                );
+
+                static_assert(
+                    requires (T _t) {{_t.pretty_args()} -> IsTuple;},
+                    "Object must have a pretty_args() method which returns a tuple."
+                );
+
+                const auto _args = arg.pretty_args();
+
+                [&]<usize... Ints>(index_sequence<Ints...>)
+                {
+                    write_format<T::template pretty_fmt<CharT>()>(
+                        out, _args.template get<Ints>()...
+                    );
+                }(make_index_sequence<decltype(_args)::size()>{});
+            }
+            else
+            {
+                static constexpr auto _style_attr =
+                    get_format_style_attr<CharT, info.style_val>();
+                static constexpr auto _reset_attr =
+                    get_reset_attr<CharT, info.style_val>();
+
+                out.put(_style_attr.data, _style_attr.size() - 1);
+
+                if constexpr (requires {arg.pretty_args();})
+                {
+                    using value_type = decltype(arg.pretty_args());
+                    write_value<CharT, info, value_type>(out, arg.pretty_args());
+                }
+                else
+                {
+                    write_value<CharT, info, decay_t<T>>(out, arg);
+                }
+
+                out.put(_reset_attr.data, _reset_attr.size() - 1);
+            }
+        }
+
+        template <basic_string_literal fmt, typename Writer, typename... Args>
+        static inline void write_format(Writer& out, const Args&... args)
+        {
+            using CharT = typename Writer::char_type;
+
+            static_assert(
+                is_same<typename decltype(fmt)::char_type, CharT>::value,
+                "Unsupported character type"
+            );
+
+            static constexpr auto _fmt_buf =
+                parse_literal<fmt, sizeof...(Args) + 1>().unwrap();
+
+            static_assert(
+                _fmt_buf.size() == sizeof...(Args) + 1,
+                "The number of arguments doesn't match"
+            );
+
+            [&]<usize... Ints>(index_sequence<Ints...>)
+            {
+                (
+                    write_argument<CharT, _fmt_buf[Ints].base>(
+                        out, _fmt_buf[Ints].format, _fmt_buf[Ints].length, args
+                    ), ...
+                );
+            }(make_index_sequence<sizeof...(Args)>{});
+
+            out.put(
+                _fmt_buf[sizeof...(Args)].format,
+                _fmt_buf[sizeof...(Args)].length
+            );
+        }
+    } // namespace format_detail
+
+    ///
+    /// @brief Formats the arguments directly into a character buffer,
+    /// without building an intermediate `printf` format string.
+    ///
+    /// @tparam fmt - The format literal.
+    /// @param dest - The destination buffer.
+    /// @param space - The size of the destination buffer.
+    /// @param args - The values to format.
+    /// @return The length of the whole output, like `snprintf` does,
+    /// the output was truncated if it is greater or equal to space.
+    ///
+    template <basic_string_literal fmt, typename CharT, typename... Args>
+    static inline usize format_to(CharT* dest, usize space, const Args&... args)
+    {
+        format_detail::writer<CharT> _out{dest, space};
+        format_detail::write_format<fmt>(_out, args...);
+        return _out.finish();
+    }
+} // namespace hsd